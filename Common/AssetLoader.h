@@ -0,0 +1,190 @@
+#ifndef AssetLoader_h
+#define AssetLoader_h
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stb_image.h>
+
+#include "AsyncLog.h"
+
+// Imagem decodificada, sempre em RGBA. pixels vazio se a leitura falhou.
+struct DecodedImage {
+    struct StbiFree {
+        void operator()(unsigned char* data) const { stbi_image_free(data); }
+    };
+
+    int id = -1;
+    std::string path;
+    int width = 0;
+    int height = 0;
+    std::unique_ptr<unsigned char, StbiFree> pixels;
+
+    size_t byteSize() const { return (size_t)width * height * 4; }
+};
+
+// Decodificação de imagens fora da thread do GL.
+//
+// A thread principal só pede (request) e, a cada quadro, pega o que ficou
+// pronto (pop); o stbi_load roda em threads próprias. Nenhuma chamada da
+// thread principal espera por elas, a não ser wait, para quem quer tudo
+// carregado antes de seguir. As imagens prontas passam por uma fila limitada
+// a maxReady: com a fila cheia as threads esperam, então imagens grandes não
+// se acumulam na memória se quem consome atrasar. onReady é chamado da
+// thread de decodificação a cada imagem pronta (ex.: para acordar o loop
+// de eventos); não pode mexer em GL. As threads só são criadas no primeiro
+// pedido.
+class AssetLoader {
+public:
+    typedef std::function<void()> ReadyCallback;
+
+    explicit AssetLoader(int threadCount = 2, size_t maxReady = 4)
+        : threadCount(std::max(1, threadCount)), maxReady(std::max<size_t>(1, maxReady)), running(false), nextId(0),
+          inFlight(0) {}
+
+    ~AssetLoader() {
+        stop();
+    }
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    void setOnReady(ReadyCallback callback) { onReady = callback; }
+
+    // devolve o id que volta em DecodedImage::id
+    int request(const std::string& path) {
+        int id;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!running) start();
+            id = nextId++;
+            pendingPaths.push_back(Request{ id, path });
+            inFlight++;
+        }
+        requestCv.notify_one();
+        return id;
+    }
+
+    // Próxima imagem pronta, sem esperar.
+    bool pop(DecodedImage& out) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (ready.empty()) return false;
+            out = std::move(ready.front());
+            ready.pop_front();
+            inFlight--;
+        }
+        spaceCv.notify_one();
+        return true;
+    }
+
+    // Próxima imagem, esperando se preciso; false se não há mais nada pedido.
+    bool wait(DecodedImage& out) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            readyCv.wait(lock, [this] { return !ready.empty() || inFlight == 0; });
+            if (ready.empty()) return false;
+            out = std::move(ready.front());
+            ready.pop_front();
+            inFlight--;
+        }
+        spaceCv.notify_one();
+        return true;
+    }
+
+    bool hasReady() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return !ready.empty();
+    }
+
+    // pedidas e ainda não entregues por pop/wait
+    int pendingCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return inFlight;
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+            pendingPaths.clear();
+        }
+        requestCv.notify_all();
+        spaceCv.notify_all();
+        for (std::thread& worker : workers) {
+            if (worker.joinable()) worker.join();
+        }
+        workers.clear();
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.clear();
+        inFlight = 0;
+    }
+
+private:
+    struct Request {
+        int id;
+        std::string path;
+    };
+
+    // com mutex
+    void start() {
+        running = true;
+        for (int i = 0; i < threadCount; ++i) workers.emplace_back(&AssetLoader::workerLoop, this);
+    }
+
+    void workerLoop() {
+        for (;;) {
+            Request request;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                requestCv.wait(lock, [this] { return !running || !pendingPaths.empty(); });
+                if (!running) return;
+                request = std::move(pendingPaths.front());
+                pendingPaths.pop_front();
+            }
+
+            DecodedImage image;
+            image.id = request.id;
+            image.path = request.path;
+            int channels = 0;
+            image.pixels.reset(stbi_load(request.path.c_str(), &image.width, &image.height, &channels, 4));
+            if (!image.pixels) {
+                image.width = image.height = 0;
+                LOG_ERROR("Falha ao carregar textura: %s", request.path.c_str());
+            }
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                spaceCv.wait(lock, [this] { return !running || ready.size() < maxReady; });
+                if (!running) return;
+                ready.push_back(std::move(image));
+            }
+            readyCv.notify_all();
+            if (onReady) onReady();
+        }
+    }
+
+    const int threadCount;
+    const size_t maxReady;
+    ReadyCallback onReady;
+
+    mutable std::mutex mutex;
+    std::condition_variable requestCv;          // pedido novo ou parada
+    std::condition_variable spaceCv;            // lugar na fila de prontas
+    std::condition_variable readyCv;            // imagem pronta, para wait
+    std::deque<Request> pendingPaths;
+    std::deque<DecodedImage> ready;
+    bool running;
+    int nextId;
+    int inFlight;
+    std::vector<std::thread> workers;
+};
+
+#endif /* AssetLoader_h */
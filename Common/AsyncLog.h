@@ -0,0 +1,295 @@
+#ifndef AsyncLog_h
+#define AsyncLog_h
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Log assíncrono compartilhado pelos projetos.
+//
+// Quem loga só formata a mensagem direto em uma posição de um anel de
+// tamanho fixo e publica: sem trava, sem alocação e sem chamada de sistema.
+// Uma thread de escrita esvazia o anel a cada poucos milissegundos e junta
+// tudo o que achou em uma escrita por destino (stdout, stderr e o arquivo).
+// Com o anel cheio a mensagem é descartada e contada; quem loga nunca espera.
+//
+// Os níveis abaixo de LOG_MIN_LEVEL somem na compilação: as macros viram
+// ((void)0) e os argumentos nem são avaliados. Debug e info vão para stdout,
+// warn e error para stderr; com um arquivo aberto (openFile), tudo vai também
+// para ele.
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_OFF 4
+
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LOG_PRINTF_FORMAT(fmt, args) __attribute__((format(printf, fmt, args)))
+#else
+#define LOG_PRINTF_FORMAT(fmt, args)
+#endif
+
+class AsyncLog {
+public:
+    // destinos de uma mensagem
+    enum Sink {
+        TO_STDOUT = 1,
+        TO_STDERR = 2,
+        TO_FILE = 4
+    };
+
+    static AsyncLog& get() {
+        static AsyncLog log;
+        return log;
+    }
+
+    ~AsyncLog() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        if (writer.joinable()) writer.join();
+        if (file) fclose(file);
+    }
+
+    AsyncLog(const AsyncLog&) = delete;
+    AsyncLog& operator=(const AsyncLog&) = delete;
+
+    // Passa a copiar tudo para 'path' (do zero ou no fim do que já existe).
+    // Espera o que já estava no anel ser escrito no arquivo anterior.
+    bool openFile(const char* path, bool append) {
+        flush();
+        FILE* opened = fopen(path, append ? "a" : "w");
+        if (!opened) return false;
+        std::lock_guard<std::mutex> lock(fileMutex);
+        if (file) fclose(file);
+        file = opened;
+        return true;
+    }
+
+    void message(int level, const char* format, ...) LOG_PRINTF_FORMAT(3, 4) {
+        va_list args;
+        va_start(args, format);
+        push(level, sinksFor(level), format, args);
+        va_end(args);
+    }
+
+    // destinos explícitos, para quem não segue a regra dos níveis (gl_log)
+    void messageTo(int sinks, int level, const char* format, ...) LOG_PRINTF_FORMAT(4, 5) {
+        va_list args;
+        va_start(args, format);
+        push(level, sinks, format, args);
+        va_end(args);
+    }
+
+    void messageTo(int sinks, int level, const char* format, va_list args) {
+        push(level, sinks, format, args);
+    }
+
+    // Espera tudo o que foi logado até aqui chegar aos destinos. Para antes
+    // de imprimir direto no console, quando a ordem importa.
+    void flush() {
+        const uint64_t target = enqueuePos.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(mutex);
+        flushRequested = true;
+        wake.notify_one();
+        written.wait(lock, [&] { return writtenPos >= target || stopping; });
+    }
+
+    uint64_t getDroppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    static const size_t SLOT_COUNT = 4096;                    // potência de 2
+    static const size_t TEXT_BYTES = 240;
+    static const int WRITER_PERIOD_MS = 5;
+
+    // Uma mensagem. 'sequence' é o protocolo do anel (fila limitada de
+    // Vyukov): igual à posição quando livre para quem escreve, posição + 1
+    // quando publicada. Mensagens maiores que 'text' vão inteiras para
+    // 'overflow', alocado; é o caso raro (logs de shader), não o comum.
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        uint8_t level;
+        uint8_t sinks;
+        uint32_t length;
+        char* overflow;
+        char text[TEXT_BYTES];
+    };
+
+    AsyncLog() : slots(new Slot[SLOT_COUNT]), enqueuePos(0), dequeuePos(0), dropped(0), writtenPos(0),
+                 flushRequested(false), stopping(false), file(nullptr) {
+        for (size_t i = 0; i < SLOT_COUNT; ++i) slots[i].sequence.store(i, std::memory_order_relaxed);
+        writer = std::thread(&AsyncLog::writerLoop, this);
+    }
+
+    static int sinksFor(int level) {
+        return (level >= LOG_LEVEL_WARN ? TO_STDERR : TO_STDOUT) | TO_FILE;
+    }
+
+    void push(int level, int sinks, const char* format, va_list args) {
+        uint64_t pos = enqueuePos.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots[pos & (SLOT_COUNT - 1)];
+            const uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const int64_t diff = (int64_t)(sequence - pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        va_list copy;
+        va_copy(copy, args);
+        int length = vsnprintf(slot->text, TEXT_BYTES, format, args);
+        if (length < 0) length = 0;
+        char* text = slot->text;
+        slot->overflow = nullptr;
+        // precisa sobrar lugar para a quebra de linha
+        if (length + 1 >= (int)TEXT_BYTES) {
+            slot->overflow = (char*)malloc((size_t)length + 2);
+            if (slot->overflow) {
+                vsnprintf(slot->overflow, (size_t)length + 1, format, copy);
+                text = slot->overflow;
+            } else {
+                length = (int)TEXT_BYTES - 2;
+            }
+        }
+        va_end(copy);
+        // toda mensagem termina em uma quebra de linha
+        if (length == 0 || text[length - 1] != '\n') text[length++] = '\n';
+        slot->length = (uint32_t)length;
+        slot->level = (uint8_t)level;
+        slot->sinks = (uint8_t)sinks;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+
+        if (level >= LOG_LEVEL_ERROR) wake.notify_one();
+    }
+
+    // Junta as mensagens publicadas em um buffer por destino. Para na
+    // primeira posição ainda não publicada, para manter a ordem.
+    size_t drain() {
+        size_t count = 0;
+        for (;;) {
+            Slot& slot = slots[dequeuePos & (SLOT_COUNT - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != dequeuePos + 1) break;
+            const char* text = slot.overflow ? slot.overflow : slot.text;
+            const size_t length = slot.length;
+            if (slot.sinks & TO_STDOUT) outBatch.append(text, length);
+            if (slot.sinks & TO_STDERR) errBatch.append(text, length);
+            if (slot.sinks & TO_FILE) fileBatch.append(text, length);
+            free(slot.overflow);
+            slot.overflow = nullptr;
+            slot.sequence.store(dequeuePos + SLOT_COUNT, std::memory_order_release);
+            dequeuePos++;
+            count++;
+        }
+        return count;
+    }
+
+    void writeBatches() {
+        if (!outBatch.empty()) {
+            fwrite(outBatch.data(), 1, outBatch.size(), stdout);
+            fflush(stdout);
+            outBatch.clear();
+        }
+        if (!errBatch.empty()) {
+            fwrite(errBatch.data(), 1, errBatch.size(), stderr);
+            fflush(stderr);
+            errBatch.clear();
+        }
+        if (!fileBatch.empty()) {
+            std::lock_guard<std::mutex> lock(fileMutex);
+            if (file) {
+                fwrite(fileBatch.data(), 1, fileBatch.size(), file);
+                fflush(file);
+            }
+            fileBatch.clear();
+        }
+    }
+
+    void writerLoop() {
+        uint64_t reportedDrops = 0;
+        for (;;) {
+            drain();
+            const uint64_t drops = dropped.load(std::memory_order_relaxed);
+            if (drops != reportedDrops) {
+                errBatch += "[log] " + std::to_string(drops - reportedDrops) + " mensagem(ns) descartada(s): anel cheio\n";
+                reportedDrops = drops;
+            }
+            writeBatches();
+
+            std::unique_lock<std::mutex> lock(mutex);
+            writtenPos = dequeuePos;
+            written.notify_all();
+            if (stopping && enqueuePos.load(std::memory_order_acquire) == dequeuePos) return;
+            if (!flushRequested && !stopping) {
+                wake.wait_for(lock, std::chrono::milliseconds(WRITER_PERIOD_MS));
+            }
+            flushRequested = false;
+        }
+    }
+
+    std::unique_ptr<Slot[]> slots;
+    alignas(64) std::atomic<uint64_t> enqueuePos;
+    alignas(64) uint64_t dequeuePos;                 // só a thread de escrita
+    std::atomic<uint64_t> dropped;
+
+    std::string outBatch, errBatch, fileBatch;
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable written;
+    uint64_t writtenPos;
+    bool flushRequested;
+    bool stopping;
+
+    std::mutex fileMutex;
+    FILE* file;
+};
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) AsyncLog::get().message(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) AsyncLog::get().message(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(...) AsyncLog::get().message(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) AsyncLog::get().message(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+
+#endif /* AsyncLog_h */
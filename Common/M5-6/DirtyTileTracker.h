@@ -0,0 +1,92 @@
+#ifndef DirtyTileTracker_h
+#define DirtyTileTracker_h
+
+#include <algorithm>
+#include <vector>
+
+// Registra quais células de um mapa (índice linear row * cols + col) mudaram
+// desde o último envio para a GPU. As faixas são ordenadas e fundidas no flush,
+// e um preenchimento do mapa inteiro vira uma única faixa.
+class DirtyTileTracker {
+public:
+    struct Range {
+        int begin; // primeiro índice sujo
+        int end;   // um após o último índice sujo
+    };
+
+    DirtyTileTracker() : total(0), all(false), mergeGap(8) {}
+
+    void resize(int tileCount) {
+        this->total = tileCount;
+        this->ranges.clear();
+        this->all = tileCount > 0;
+    }
+
+    void markCell(int index) {
+        markRange(index, index + 1);
+    }
+
+    void markRange(int begin, int end) {
+        if (this->all) return;
+        begin = std::max(begin, 0);
+        end = std::min(end, this->total);
+        if (begin >= end) return;
+        if (begin == 0 && end == this->total) {
+            markAll();
+            return;
+        }
+        if (!this->ranges.empty() && this->ranges.back().end >= begin && this->ranges.back().begin <= end) {
+            this->ranges.back().begin = std::min(this->ranges.back().begin, begin);
+            this->ranges.back().end = std::max(this->ranges.back().end, end);
+            return;
+        }
+        this->ranges.push_back({begin, end});
+    }
+
+    void markAll() {
+        this->ranges.clear();
+        this->all = this->total > 0;
+    }
+
+    bool empty() const {
+        return !this->all && this->ranges.empty();
+    }
+
+    // faixas vizinhas separadas por menos de 'gap' células são fundidas para
+    // trocar alguns bytes a mais por menos chamadas de glBufferSubData
+    void setMergeGap(int gap) {
+        this->mergeGap = gap;
+    }
+
+    // Devolve as faixas sujas fundidas e limpa o registro.
+    const std::vector<Range>& consume() {
+        this->flushed.clear();
+        if (this->all) {
+            this->flushed.push_back({0, this->total});
+        } else if (!this->ranges.empty()) {
+            std::sort(this->ranges.begin(), this->ranges.end(),
+                      [](const Range& a, const Range& b) { return a.begin < b.begin; });
+            this->flushed.push_back(this->ranges[0]);
+            for (size_t i = 1; i < this->ranges.size(); i++) {
+                Range& last = this->flushed.back();
+                if (this->ranges[i].begin <= last.end + this->mergeGap) {
+                    last.end = std::max(last.end, this->ranges[i].end);
+                } else {
+                    this->flushed.push_back(this->ranges[i]);
+                }
+            }
+        }
+        this->ranges.clear();
+        this->all = false;
+        return this->flushed;
+    }
+
+private:
+    int total;
+    bool all;
+    int mergeGap;
+    std::vector<Range> ranges;
+    std::vector<Range> flushed;
+};
+
+#endif /* DirtyTileTracker_h */
@@ -0,0 +1,409 @@
+#ifndef MapFile_h
+#define MapFile_h
+
+// Formato binário de mapas (.gbmap), versão 2.
+//
+//   MapFileHeader                     tamanho fixo, sempre no início do arquivo
+//   MapChunkEntry[layers * chunksY * chunksX]   em header.chunkTableOffset
+//   uint64_t[layers * 256]            em header.tileCountOffset: quantos tiles
+//                                     de cada id há em cada camada
+//   dados dos chunks                  nos offsets indicados pela tabela
+//
+// Cada camada é dividida em chunks quadrados de chunkSize x chunkSize tiles
+// (os chunks da borda são completados com MAP_EMPTY_TILE). Um chunk pode ser
+// gravado cru ou comprimido com RLE de bytes (pares contagem-1, id).
+// Todos os campos são little-endian.
+//
+// O arquivo é lido via mmap: abrir só valida o cabeçalho, e cada chunk é
+// decodificado sob demanda direto da memória mapeada. A contagem por id
+// dá totais do mapa inteiro (ex.: moedas) sem decodificar nenhum chunk.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "TileGrid.h"
+
+#define MAP_FILE_MAGIC "GBMP"
+#define MAP_FILE_VERSION 2
+#define MAP_EMPTY_TILE 0xFF
+#define MAP_MAX_CHUNK_SIZE 1024
+
+enum MapChunkCompression {
+    MAP_CHUNK_RAW = 0,
+    MAP_CHUNK_RLE = 1
+};
+
+#pragma pack(push, 1)
+struct MapFileHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t headerSize;
+    uint32_t mapCols;
+    uint32_t mapRows;
+    uint16_t tileWidth;
+    uint16_t tileHeight;
+    uint16_t tilesetCols;
+    uint16_t tilesetRows;
+    uint16_t chunkSize;
+    uint16_t layerCount;
+    uint32_t chunksX;
+    uint32_t chunksY;
+    uint64_t chunkTableOffset;
+    uint64_t tileCountOffset;
+    char tilesetPath[256];
+};
+
+struct MapChunkEntry {
+    uint64_t offset;
+    uint32_t storedSize;
+    uint16_t compression;
+    uint16_t reserved;
+};
+#pragma pack(pop)
+
+// Mapeamento somente leitura de um arquivo inteiro.
+class MappedFile {
+public:
+    MappedFile() : ptr(nullptr), length(0) {
+#ifdef _WIN32
+        fileHandle = INVALID_HANDLE_VALUE;
+        mappingHandle = NULL;
+#endif
+    }
+
+    ~MappedFile() {
+        close();
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+#ifdef _WIN32
+        fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (fileHandle == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0) {
+            close();
+            return false;
+        }
+        mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mappingHandle == NULL) {
+            close();
+            return false;
+        }
+        ptr = static_cast<const unsigned char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        if (!ptr) {
+            close();
+            return false;
+        }
+        length = static_cast<size_t>(size.QuadPart);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+        void* mapped = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) return false;
+        ptr = static_cast<const unsigned char*>(mapped);
+        length = static_cast<size_t>(st.st_size);
+#endif
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (ptr) UnmapViewOfFile(ptr);
+        if (mappingHandle != NULL) CloseHandle(mappingHandle);
+        if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+        mappingHandle = NULL;
+        fileHandle = INVALID_HANDLE_VALUE;
+#else
+        if (ptr) munmap(const_cast<unsigned char*>(ptr), length);
+#endif
+        ptr = nullptr;
+        length = 0;
+    }
+
+    const unsigned char* data() const { return ptr; }
+    size_t size() const { return length; }
+    bool isOpen() const { return ptr != nullptr; }
+
+private:
+    const unsigned char* ptr;
+    size_t length;
+#ifdef _WIN32
+    HANDLE fileHandle;
+    HANDLE mappingHandle;
+#endif
+};
+
+// Leitura de um .gbmap mapeado em memória.
+class MapFileReader {
+public:
+    MapFileReader() : header(nullptr), table(nullptr) {}
+
+    bool open(const std::string& path, std::string& error) {
+        header = nullptr;
+        table = nullptr;
+        if (!file.open(path)) {
+            error = "nao foi possivel mapear " + path;
+            return false;
+        }
+        if (file.size() < sizeof(MapFileHeader)) {
+            error = "arquivo menor que o cabecalho";
+            return false;
+        }
+        const MapFileHeader* h = reinterpret_cast<const MapFileHeader*>(file.data());
+        if (std::memcmp(h->magic, MAP_FILE_MAGIC, 4) != 0) {
+            error = "assinatura invalida";
+            return false;
+        }
+        if (h->version != MAP_FILE_VERSION || h->headerSize != sizeof(MapFileHeader)) {
+            error = "versao de formato nao suportada: " + std::to_string(h->version);
+            return false;
+        }
+        if (h->chunkSize == 0 || h->chunkSize > MAP_MAX_CHUNK_SIZE || h->layerCount == 0) {
+            error = "cabecalho inconsistente";
+            return false;
+        }
+        // a grade de chunks tem que cobrir o mapa exatamente; readLayer e o
+        // streaming contam com isso para não sair da TileGrid
+        if (h->mapCols == 0 || h->mapRows == 0 || h->mapCols > INT32_MAX || h->mapRows > INT32_MAX ||
+            h->chunksX != (h->mapCols + h->chunkSize - 1) / h->chunkSize ||
+            h->chunksY != (h->mapRows + h->chunkSize - 1) / h->chunkSize) {
+            error = "grade de chunks nao corresponde ao tamanho do mapa";
+            return false;
+        }
+        uint64_t chunkCount = (uint64_t)h->chunksX * h->chunksY;
+        if (h->chunkTableOffset > file.size() ||
+            chunkCount > (file.size() - h->chunkTableOffset) / sizeof(MapChunkEntry) / h->layerCount) {
+            error = "tabela de chunks fora do arquivo";
+            return false;
+        }
+        if (h->tileCountOffset > file.size() ||
+            (file.size() - h->tileCountOffset) / (256 * sizeof(uint64_t)) < h->layerCount) {
+            error = "contagem de tiles fora do arquivo";
+            return false;
+        }
+        header = h;
+        table = reinterpret_cast<const MapChunkEntry*>(file.data() + h->chunkTableOffset);
+        return true;
+    }
+
+    const MapFileHeader& getHeader() const { return *header; }
+    int getCols() const { return (int)header->mapCols; }
+    int getRows() const { return (int)header->mapRows; }
+    int getChunkSize() const { return header->chunkSize; }
+    int getChunksX() const { return (int)header->chunksX; }
+    int getChunksY() const { return (int)header->chunksY; }
+    int getLayerCount() const { return header->layerCount; }
+
+    std::string getTilesetPath() const {
+        return std::string(header->tilesetPath, strnlen(header->tilesetPath, sizeof(header->tilesetPath)));
+    }
+
+    // quantos tiles 'id' há na camada inteira, como gravado pelo writeMapFile
+    uint64_t getTileCount(int layer, TileId id) const {
+        uint64_t count;
+        std::memcpy(&count, file.data() + header->tileCountOffset + ((size_t)layer * 256 + id) * sizeof(uint64_t),
+                    sizeof(count));
+        return count;
+    }
+
+    const MapChunkEntry& getChunkEntry(int layer, int cx, int cy) const {
+        return table[((size_t)layer * header->chunksY + cy) * header->chunksX + cx];
+    }
+
+    // Decodifica um chunk em 'out' (chunkSize * chunkSize ids, linha a linha).
+    bool decodeChunk(int layer, int cx, int cy, TileId* out) const {
+        const MapChunkEntry& entry = getChunkEntry(layer, cx, cy);
+        size_t tileCount = (size_t)header->chunkSize * header->chunkSize;
+        // offset vem do arquivo: somado ao tamanho poderia dar a volta em 64 bits
+        if (entry.offset > file.size() || entry.storedSize > file.size() - entry.offset) return false;
+        const unsigned char* src = file.data() + entry.offset;
+
+        if (entry.compression == MAP_CHUNK_RAW) {
+            if (entry.storedSize != tileCount) return false;
+            std::memcpy(out, src, tileCount);
+            return true;
+        }
+        if (entry.compression == MAP_CHUNK_RLE) {
+            size_t written = 0;
+            for (uint32_t i = 0; i < entry.storedSize; i += 2) {
+                if (i + 1 >= entry.storedSize) return false;
+                size_t run = (size_t)src[i] + 1;
+                if (written + run > tileCount) return false;
+                std::memset(out + written, src[i + 1], run);
+                written += run;
+            }
+            return written == tileCount;
+        }
+        return false;
+    }
+
+    // Decodifica uma camada inteira para uma TileGrid.
+    bool readLayer(int layer, TileGrid& grid) const {
+        int cs = header->chunkSize;
+        grid.resize(getCols(), getRows(), MAP_EMPTY_TILE);
+        std::vector<TileId> chunk((size_t)cs * cs);
+        for (int cy = 0; cy < getChunksY(); ++cy) {
+            for (int cx = 0; cx < getChunksX(); ++cx) {
+                if (!decodeChunk(layer, cx, cy, chunk.data())) return false;
+                int rows = std::min(cs, getRows() - cy * cs);
+                int cols = std::min(cs, getCols() - cx * cs);
+                for (int r = 0; r < rows; ++r) {
+                    std::memcpy(grid.rowData(cy * cs + r) + cx * cs, chunk.data() + (size_t)r * cs, cols);
+                }
+            }
+        }
+        return true;
+    }
+
+private:
+    MappedFile file;
+    const MapFileHeader* header;
+    const MapChunkEntry* table;
+};
+
+// Dados do tileset gravados no cabeçalho.
+struct MapTilesetInfo {
+    std::string path;
+    int cols, rows;
+    int tileWidth, tileHeight;
+};
+
+inline void encodeChunkRLE(const TileId* tiles, size_t count, std::vector<unsigned char>& out) {
+    out.clear();
+    size_t i = 0;
+    while (i < count) {
+        size_t run = 1;
+        while (i + run < count && run < 256 && tiles[i + run] == tiles[i]) run++;
+        out.push_back(static_cast<unsigned char>(run - 1));
+        out.push_back(tiles[i]);
+        i += run;
+    }
+}
+
+// Grava as camadas (todas com as mesmas dimensões) em um .gbmap. Com
+// 'compress', cada chunk é gravado em RLE somente se ficar menor que o cru.
+inline bool writeMapFile(const std::string& path, const MapTilesetInfo& tileset, const std::vector<TileGrid>& layers,
+                         int chunkSize, bool compress, std::string& error) {
+    if (layers.empty() || chunkSize <= 0 || chunkSize > MAP_MAX_CHUNK_SIZE) {
+        error = "parametros invalidos";
+        return false;
+    }
+    if (tileset.path.size() >= sizeof(((MapFileHeader*)0)->tilesetPath)) {
+        error = "caminho do tileset longo demais";
+        return false;
+    }
+
+    MapFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAP_FILE_MAGIC, 4);
+    header.version = MAP_FILE_VERSION;
+    header.headerSize = sizeof(MapFileHeader);
+    header.mapCols = layers[0].getWidth();
+    header.mapRows = layers[0].getHeight();
+    header.tileWidth = static_cast<uint16_t>(tileset.tileWidth);
+    header.tileHeight = static_cast<uint16_t>(tileset.tileHeight);
+    header.tilesetCols = static_cast<uint16_t>(tileset.cols);
+    header.tilesetRows = static_cast<uint16_t>(tileset.rows);
+    header.chunkSize = static_cast<uint16_t>(chunkSize);
+    header.layerCount = static_cast<uint16_t>(layers.size());
+    header.chunksX = (header.mapCols + chunkSize - 1) / chunkSize;
+    header.chunksY = (header.mapRows + chunkSize - 1) / chunkSize;
+    header.chunkTableOffset = sizeof(MapFileHeader);
+    std::memcpy(header.tilesetPath, tileset.path.c_str(), tileset.path.size());
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        error = "nao foi possivel criar " + path;
+        return false;
+    }
+
+    size_t chunkCount = (size_t)header.layerCount * header.chunksX * header.chunksY;
+    std::vector<MapChunkEntry> table(chunkCount);
+    std::vector<uint64_t> tileCounts((size_t)header.layerCount * 256, 0);
+    header.tileCountOffset = header.chunkTableOffset + chunkCount * sizeof(MapChunkEntry);
+    uint64_t offset = header.tileCountOffset + tileCounts.size() * sizeof(uint64_t);
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(table.data(), sizeof(MapChunkEntry), table.size(), file);
+    fwrite(tileCounts.data(), sizeof(uint64_t), tileCounts.size(), file);
+
+    std::vector<TileId> chunk((size_t)chunkSize * chunkSize);
+    std::vector<unsigned char> packed;
+    size_t entry = 0;
+    for (size_t layer = 0; layer < layers.size(); ++layer) {
+        const TileGrid& grid = layers[layer];
+        if (grid.getWidth() != (int)header.mapCols || grid.getHeight() != (int)header.mapRows) {
+            fclose(file);
+            error = "camadas com dimensoes diferentes";
+            return false;
+        }
+        for (uint32_t cy = 0; cy < header.chunksY; ++cy) {
+            for (uint32_t cx = 0; cx < header.chunksX; ++cx) {
+                std::fill(chunk.begin(), chunk.end(), (TileId)MAP_EMPTY_TILE);
+                int rows = std::min(chunkSize, grid.getHeight() - (int)cy * chunkSize);
+                int cols = std::min(chunkSize, grid.getWidth() - (int)cx * chunkSize);
+                for (int r = 0; r < rows; ++r) {
+                    const TileId* src = grid.rowData(cy * chunkSize + r) + cx * chunkSize;
+                    std::memcpy(chunk.data() + (size_t)r * chunkSize, src, cols);
+                    for (int c = 0; c < cols; ++c) tileCounts[layer * 256 + src[c]]++;
+                }
+
+                MapChunkEntry& e = table[entry++];
+                e.offset = offset;
+                e.reserved = 0;
+                const unsigned char* payload = chunk.data();
+                e.storedSize = (uint32_t)chunk.size();
+                e.compression = MAP_CHUNK_RAW;
+                if (compress) {
+                    encodeChunkRLE(chunk.data(), chunk.size(), packed);
+                    if (packed.size() < chunk.size()) {
+                        payload = packed.data();
+                        e.storedSize = (uint32_t)packed.size();
+                        e.compression = MAP_CHUNK_RLE;
+                    }
+                }
+                fwrite(payload, 1, e.storedSize, file);
+                offset += e.storedSize;
+            }
+        }
+    }
+
+    fseek(file, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(table.data(), sizeof(MapChunkEntry), table.size(), file);
+    fwrite(tileCounts.data(), sizeof(uint64_t), tileCounts.size(), file);
+    bool ok = ferror(file) == 0;
+    fclose(file);
+    if (!ok) error = "erro de escrita em " + path;
+    return ok;
+}
+
+#endif /* MapFile_h */
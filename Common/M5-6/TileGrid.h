@@ -0,0 +1,68 @@
+#ifndef TileGrid_h
+#define TileGrid_h
+
+#include <cstring>
+#include <vector>
+
+typedef unsigned char TileId;
+
+// Matriz de ids de tiles em um único bloco contíguo, linha a linha
+// (índice = col + row * width). Um byte por tile e nenhuma alocação por linha.
+class TileGrid {
+public:
+    TileGrid() : width(0), height(0) {}
+
+    TileGrid(int w, int h, TileId initWith = 0) : width(w), height(h), tiles((size_t)w * h, initWith) {}
+
+    void resize(int w, int h, TileId initWith = 0) {
+        this->width = w;
+        this->height = h;
+        this->tiles.assign((size_t)w * h, initWith);
+    }
+
+    int getWidth() const { return this->width; }
+    int getHeight() const { return this->height; }
+    size_t size() const { return (size_t)this->width * this->height; }
+
+    bool inBounds(int col, int row) const {
+        return col >= 0 && col < this->width && row >= 0 && row < this->height;
+    }
+
+    int index(int col, int row) const {
+        return col + row * this->width;
+    }
+
+    TileId get(int col, int row) const {
+        return this->tiles[col + (size_t)row * this->width];
+    }
+
+    void set(int col, int row, TileId tile) {
+        this->tiles[col + (size_t)row * this->width] = tile;
+    }
+
+    TileId* data() { return this->tiles.data(); }
+    const TileId* data() const { return this->tiles.data(); }
+
+    TileId* rowData(int row) { return this->tiles.data() + (size_t)row * this->width; }
+    const TileId* rowData(int row) const { return this->tiles.data() + (size_t)row * this->width; }
+
+    void fill(TileId tile) {
+        std::memset(this->tiles.data(), tile, this->tiles.size());
+    }
+
+    // restaura o conteúdo de outra grade; com as mesmas dimensões é um memcpy
+    void copyFrom(const TileGrid& other) {
+        if (other.width != this->width || other.height != this->height) {
+            this->width = other.width;
+            this->height = other.height;
+            this->tiles.resize(other.tiles.size());
+        }
+        std::memcpy(this->tiles.data(), other.tiles.data(), other.tiles.size());
+    }
+
+private:
+    int width, height;
+    std::vector<TileId> tiles;
+};
+
+#endif /* TileGrid_h */
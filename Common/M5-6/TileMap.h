@@ -1,66 +1,60 @@
+#include "TileGrid.h"
+
 class TileMap {
     float z;               // caso de eventual de vários tilemaps sobrepostos
     unsigned int tid;      // indicação do tileset utilizado
-    int width, height;     // dimensões da matriz
-    unsigned char *map; // mapa com ids dos tiles que formam o cenário
+    TileGrid grid;         // mapa com ids dos tiles que formam o cenário
+
 
-    
 public:
-    TileMap(int w, int h, unsigned char initWith) {
-        this->map = new unsigned char [w*h];
-        this->width = w;
-        this->height = h;
+    TileMap(int w, int h, unsigned char initWith) : grid(w, h, initWith) {
         this->z = 0.0f;
         this->tid = 0;
     }
-    
-//    TileMap(const TileMap &tm) {
-//        map = new unsigned char[tm.width * tm.height];
-//        this->width = tm.width;
-//        this->height = tm.height;
-//        this->z = tm.z;
-//        this->tid = tm.tid;
-////        for (int i=0; this->width * this->height; i++) {
-////            this->map[i] = tm.map[i];
-////        }
-//        memcpy(this->map, tm.map, tm.width*tm.height);
-//    }
-    
+
+    TileMap(const TileMap &tm) : grid(tm.grid) {
+        this->z = tm.z;
+        this->tid = tm.tid;
+    }
+
     unsigned char* getMap() {
-        return this->map;
+        return this->grid.data();
     }
-    
+
+    TileGrid& getGrid() {
+        return this->grid;
+    }
+
     int getWidth() {
-        return this->width;
+        return this->grid.getWidth();
     }
-    
+
     int getHeight() {
-        return this->height;
+        return this->grid.getHeight();
     }
-    
+
     int getTile(int col, int row) {
-        return this->map[col + row * this->width];
+        return this->grid.get(col, row);
     }
-    
+
     void setTile(int col, int row, unsigned char tile) {
-        this->map[col + row * this->width] = tile;
+        this->grid.set(col, row, tile);
     }
-    
+
     int getTileSet() {
         return this->tid;
     }
-    
+
     float getZ() {
         return this->z;
     }
-    
+
     void setZ(float z){
         this->z = z;
     }
-    
+
     void setTid(int tid) {
         this->tid = tid;
     }
-    
-};
 
+};
@@ -0,0 +1,222 @@
+#ifndef ShaderProgram_h
+#define ShaderProgram_h
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+// Ponto de ligação do bloco de uniforms por frame, comum a todos os programas.
+#define FRAME_UNIFORM_BINDING 0
+
+// Bloco std140 com os dados que mudam uma vez por frame e valem para todos os
+// programas. Concatenar na fonte do shader logo após o #version:
+//   "#version 330 core\n" FRAME_UNIFORM_BLOCK "..."
+// Os membros ficam no escopo global do GLSL, então 'projection' continua sendo
+// usado pelo nome, como um uniform comum.
+#define FRAME_UNIFORM_BLOCK \
+    "layout (std140) uniform Frame {\n" \
+    "   mat4 projection;\n" \
+    "   vec2 viewportSize;\n" \
+    "   float time;\n" \
+    "};\n"
+
+// Espelho do bloco Frame no layout std140 (mat4 = 64 bytes, vec2 + float
+// ocupam os 12 bytes seguintes, completados até 16).
+struct FrameUniforms {
+    glm::mat4 projection;
+    glm::vec2 viewportSize;
+    float time;
+    float padding;
+};
+
+// Programa GLSL com todos os uniforms ativos resolvidos uma única vez, logo
+// após o link. location() procura na tabela e não chama glGetUniformLocation;
+// o código de desenho guarda as localizações em inteiros na inicialização e
+// usa os set() por localização dentro dos laços.
+class ShaderProgram {
+public:
+    ShaderProgram() : id(0), owner(false) {}
+
+    ~ShaderProgram() {
+        destroy();
+    }
+
+    ShaderProgram(const ShaderProgram&) = delete;
+    ShaderProgram& operator=(const ShaderProgram&) = delete;
+
+    // Compila e linka a partir das fontes. Em caso de erro o log vai para o
+    // std::cerr e o programa fica inválido (id 0).
+    bool build(const char* vertexSource, const char* fragmentSource) {
+        GLuint vs = compile(vertexSource, GL_VERTEX_SHADER);
+        GLuint fs = compile(fragmentSource, GL_FRAGMENT_SHADER);
+        if (vs == 0 || fs == 0) {
+            if (vs != 0) glDeleteShader(vs);
+            if (fs != 0) glDeleteShader(fs);
+            return false;
+        }
+
+        GLuint program = glCreateProgram();
+        glAttachShader(program, fs);
+        glAttachShader(program, vs);
+        glLinkProgram(program);
+        glDeleteShader(vs);
+        glDeleteShader(fs);
+
+        int success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            char infoLog[512];
+            glGetProgramInfoLog(program, 512, NULL, infoLog);
+            std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+            glDeleteProgram(program);
+            return false;
+        }
+        adopt(program, true);
+        return true;
+    }
+
+    // Usa um programa já linkado por outro código (ex.: shaders lidos de
+    // arquivo). Com takeOwnership o programa é apagado no destrutor.
+    void adopt(GLuint program, bool takeOwnership = true) {
+        destroy();
+        id = program;
+        owner = takeOwnership;
+        introspect();
+    }
+
+    void use() const { glUseProgram(id); }
+    GLuint getId() const { return id; }
+    bool isValid() const { return id != 0; }
+
+    // -1 quando o uniform não existe ou foi descartado pelo compilador, o que
+    // o GL aceita (e ignora) nos glUniform*.
+    GLint location(const std::string& name) const {
+        std::unordered_map<std::string, GLint>::const_iterator it = uniforms.find(name);
+        return it == uniforms.end() ? -1 : it->second;
+    }
+
+    bool hasFrameBlock() const { return frameBlock; }
+
+    // Libera o programa antes do destrutor, para quem destrói o contexto GL
+    // (glfwTerminate) ainda com o objeto vivo.
+    void destroy() {
+        if (id != 0 && owner) glDeleteProgram(id);
+        id = 0;
+        owner = false;
+        uniforms.clear();
+    }
+
+    // Os set() valem para o programa em uso (glUseProgram).
+    static void set(GLint loc, int value) { glUniform1i(loc, value); }
+    static void set(GLint loc, float value) { glUniform1f(loc, value); }
+    static void set(GLint loc, const glm::vec2& v) { glUniform2f(loc, v.x, v.y); }
+    static void set(GLint loc, const glm::ivec2& v) { glUniform2i(loc, v.x, v.y); }
+    static void set(GLint loc, const glm::vec4& v) { glUniform4f(loc, v.x, v.y, v.z, v.w); }
+    static void set(GLint loc, const glm::mat4& m) { glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(m)); }
+
+private:
+    GLuint compile(const char* source, GLenum type) {
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, NULL);
+        glCompileShader(shader);
+
+        int success;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            char infoLog[512];
+            glGetShaderInfoLog(shader, 512, NULL, infoLog);
+            std::cerr << "ERROR::SHADER::COMPILATION_FAILED\n" << infoLog << std::endl;
+            glDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+
+    // Lê todos os uniforms ativos do programa e liga o bloco Frame, se houver,
+    // ao ponto FRAME_UNIFORM_BINDING.
+    void introspect() {
+        uniforms.clear();
+        frameBlock = false;
+        if (id == 0) return;
+
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<char> name(maxLength > 0 ? maxLength : 1);
+        for (GLint i = 0; i < count; ++i) {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(id, (GLuint)i, (GLsizei)name.size(), &length, &size, &type, name.data());
+            std::string uniformName(name.data(), length);
+            GLint loc = glGetUniformLocation(id, uniformName.c_str());
+            if (loc < 0) continue; // membros de blocos não têm localização
+
+            // arrays aparecem como "nome[0]"; guarda também "nome"
+            uniforms[uniformName] = loc;
+            size_t bracket = uniformName.find('[');
+            if (bracket != std::string::npos) {
+                uniforms[uniformName.substr(0, bracket)] = loc;
+            }
+        }
+
+        GLuint blockIndex = glGetUniformBlockIndex(id, "Frame");
+        if (blockIndex != GL_INVALID_INDEX) {
+            glUniformBlockBinding(id, blockIndex, FRAME_UNIFORM_BINDING);
+            frameBlock = true;
+        }
+    }
+
+    GLuint id;
+    bool owner;
+    bool frameBlock = false;
+    std::unordered_map<std::string, GLint> uniforms;
+};
+
+// Buffer do bloco Frame: atualizado uma vez por frame e ligado a
+// FRAME_UNIFORM_BINDING, fica visível para todos os programas que declaram o
+// bloco, sem nenhum glUniform por programa.
+class FrameUniformBuffer {
+public:
+    FrameUniformBuffer() : ubo(0) {}
+
+    ~FrameUniformBuffer() {
+        destroy();
+    }
+
+    FrameUniformBuffer(const FrameUniformBuffer&) = delete;
+    FrameUniformBuffer& operator=(const FrameUniformBuffer&) = delete;
+
+    void update(const glm::mat4& projection, float viewportWidth, float viewportHeight, float time) {
+        if (ubo == 0) {
+            glGenBuffers(1, &ubo);
+            glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+            glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), NULL, GL_DYNAMIC_DRAW);
+            glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, ubo);
+        }
+        data.projection = projection;
+        data.viewportSize = glm::vec2(viewportWidth, viewportHeight);
+        data.time = time;
+        data.padding = 0.0f;
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &data);
+    }
+
+    const FrameUniforms& get() const { return data; }
+
+    void destroy() {
+        if (ubo != 0) glDeleteBuffers(1, &ubo);
+        ubo = 0;
+    }
+
+private:
+    GLuint ubo;
+    FrameUniforms data;
+};
+
+#endif /* ShaderProgram_h */
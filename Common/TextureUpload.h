@@ -0,0 +1,135 @@
+#ifndef TextureUpload_h
+#define TextureUpload_h
+
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "AssetLoader.h"
+
+// Lado GL do AssetLoader: envio das imagens decodificadas para texturas.
+
+// Pixel buffer object reaproveitado entre envios. stage copia os pixels para
+// o PBO e o deixa ligado em GL_PIXEL_UNPACK_BUFFER: os glTex*Image seguintes
+// leem dele, com o "ponteiro" sendo o deslocamento no buffer (source), e a
+// cópia para a textura fica com o driver. O glBufferData antes do mapeamento
+// descarta o conteúdo anterior sem esperar a GPU terminar de lê-lo. Se o
+// mapeamento falhar, nada fica ligado e os pixels vão direto. finish desliga
+// o PBO depois dos glTex*Image. release precisa do contexto ainda vivo.
+class PixelUploadBuffer {
+public:
+    PixelUploadBuffer() : pbo(0), staged(false) {}
+    ~PixelUploadBuffer() { release(); }
+
+    PixelUploadBuffer(const PixelUploadBuffer&) = delete;
+    PixelUploadBuffer& operator=(const PixelUploadBuffer&) = delete;
+
+    bool stage(const DecodedImage& image) {
+        staged = false;
+        if (pbo == 0) glGenBuffers(1, &pbo);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, image.byteSize(), NULL, GL_STREAM_DRAW);
+        void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, image.byteSize(), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (!mapped) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            return false;
+        }
+        memcpy(mapped, image.pixels.get(), image.byteSize());
+        if (!glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER)) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            return false;
+        }
+        staged = true;
+        return true;
+    }
+
+    // origem dos pixels nos glTex*Image: deslocamento no PBO, ou a própria imagem
+    const void* source(const DecodedImage& image, size_t offset = 0) const {
+        return staged ? (const void*)offset : (const void*)(image.pixels.get() + offset);
+    }
+
+    void finish() {
+        if (staged) glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        staged = false;
+    }
+
+    // Troca o conteúdo da textura 2D 'target' pela imagem inteira, com mipmaps;
+    // o nome e os parâmetros da textura não mudam.
+    void uploadTexture2D(const DecodedImage& image, GLuint target) {
+        glBindTexture(GL_TEXTURE_2D, target);
+        stage(image);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, source(image));
+        finish();
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+
+    void release() {
+        if (pbo != 0) glDeleteBuffers(1, &pbo);
+        pbo = 0;
+        staged = false;
+    }
+
+private:
+    GLuint pbo;
+    bool staged;
+};
+
+// Texturas 2D carregadas em segundo plano, para quem só precisa de imagens
+// inteiras. request cria a textura já com um texel provisório e pede a
+// imagem ao AssetLoader; quem chama liga a textura e ajusta os parâmetros
+// como antes. pump, no começo de cada quadro, envia o que ficou pronto e
+// devolve quantas texturas foram de fato enviadas; uma imagem que falhou
+// deixa a provisória, não conta e só aparece no log do AssetLoader.
+class AsyncTextureLoader {
+public:
+    explicit AsyncTextureLoader(int threadCount = 2) : loader(threadCount) {}
+
+    ~AsyncTextureLoader() {
+        loader.stop();
+    }
+
+    GLuint request(const std::string& path, const unsigned char placeholder[4]) {
+        GLuint texture = 0;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+        pending.push_back(std::make_pair(loader.request(path), texture));
+        return texture;
+    }
+
+    int pump() {
+        int uploaded = 0;
+        DecodedImage image;
+        while (loader.pop(image)) {
+            for (size_t i = 0; i < pending.size(); ++i) {
+                if (pending[i].first != image.id) continue;
+                if (image.pixels) {
+                    upload.uploadTexture2D(image, pending[i].second);
+                    uploaded++;
+                }
+                pending.erase(pending.begin() + i);
+                break;
+            }
+        }
+        return uploaded;
+    }
+
+    int pendingCount() const { return loader.pendingCount(); }
+
+    // antes de destruir o contexto
+    void stop() {
+        loader.stop();
+        pending.clear();
+        upload.release();
+    }
+
+private:
+    AssetLoader loader;
+    PixelUploadBuffer upload;
+    std::vector<std::pair<int, GLuint>> pending;    // id do pedido, textura
+};
+
+#endif /* TextureUpload_h */
@@ -13,6 +13,7 @@
 | it is really making life easier.                                             |
 \******************************************************************************/
 #include "gl_utils.h"
+#include "AsyncLog.h"
 
 #include <stdio.h>
 #include <time.h>
@@ -27,9 +28,30 @@ int g_gl_height = 600;
 GLFWwindow* g_window = NULL;
 
 /*--------------------------------LOG FUNCTIONS-------------------------------*/
+/* the log file is opened once; messages go through the asynchronous logger
+(AsyncLog.h), so logging does not open, write and close the file every call */
+static bool g_gl_log_open = false;
+
+/* without restart_gl_log, the first message appends to the existing file */
+static bool ensure_gl_log () {
+	if (g_gl_log_open) {
+		return true;
+	}
+	if (!AsyncLog::get ().openFile (GL_LOG_FILE, true)) {
+		fprintf (
+			stderr,
+			"ERROR: could not open GL_LOG_FILE %s file for appending\n",
+			GL_LOG_FILE
+		);
+		return false;
+	}
+	g_gl_log_open = true;
+	return true;
+}
+
 bool restart_gl_log () {
-	FILE* file = fopen (GL_LOG_FILE, "w");
-	if (!file) {
+	g_gl_log_open = AsyncLog::get ().openFile (GL_LOG_FILE, false);
+	if (!g_gl_log_open) {
 		fprintf (
 			stderr,
 			"ERROR: could not open GL_LOG_FILE log file %s for writing\n",
@@ -39,49 +61,29 @@ bool restart_gl_log () {
 	}
 	time_t now = time (NULL);
 	char* date = ctime (&now);
-	fprintf (file, "GL_LOG_FILE log. local time %s\n", date);
-	fclose (file);
+	AsyncLog::get ().messageTo (AsyncLog::TO_FILE, LOG_LEVEL_INFO, "GL_LOG_FILE log. local time %s\n", date);
 	return true;
 }
 
 bool gl_log (const char* message, ...) {
-	va_list argptr;
-	FILE* file = fopen (GL_LOG_FILE, "a");
-	if (!file) {
-		fprintf (
-			stderr,
-			"ERROR: could not open GL_LOG_FILE %s file for appending\n",
-			GL_LOG_FILE
-		);
+	if (!ensure_gl_log ()) {
 		return false;
 	}
+	va_list argptr;
 	va_start (argptr, message);
-	vfprintf (file, message, argptr);
+	AsyncLog::get ().messageTo (AsyncLog::TO_FILE, LOG_LEVEL_INFO, message, argptr);
 	va_end (argptr);
-	fclose (file);
 	return true;
 }
 
 /* same as gl_log except also prints to stderr */
 bool gl_log_err (const char* message, ...) {
+	bool opened = ensure_gl_log ();
 	va_list argptr;
-	FILE* file = fopen (GL_LOG_FILE, "a");
-	if (!file) {
-		fprintf (
-			stderr,
-			"ERROR: could not open GL_LOG_FILE %s file for appending\n",
-			GL_LOG_FILE
-		);
-		return false;
-	}
-	va_start (argptr, message);
-	vfprintf (file, message, argptr);
-	va_end (argptr);
 	va_start (argptr, message);
-	vfprintf (stderr, message, argptr);
+	AsyncLog::get ().messageTo (AsyncLog::TO_FILE | AsyncLog::TO_STDERR, LOG_LEVEL_ERROR, message, argptr);
 	va_end (argptr);
-	fclose (file);
-	return true;
+	return opened;
 }
 
 /*--------------------------------GLFW3 and GLEW------------------------------*/
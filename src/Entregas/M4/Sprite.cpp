@@ -14,6 +14,9 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+#include "ShaderProgram.h"
+#include "TextureUpload.h"
+
 // Constants
 namespace Config {
     constexpr GLint WINDOW_WIDTH = 800;
@@ -28,7 +31,11 @@ namespace Shaders {
         layout (location = 0) in vec3 vPosition;
         layout (location = 1) in vec2 vTextureCoord;
         
-        uniform mat4 projection;
+        layout (std140) uniform Frame {
+            mat4 projection;
+            vec2 viewportSize;
+            float time;
+        };
         uniform mat4 model;
         
         out vec2 TexCoord;
@@ -54,20 +61,15 @@ namespace Shaders {
 }
 
 // Texture Manager
+// Images are decoded on worker threads (AsyncTextureLoader) and uploaded
+// through a PBO by pumpUploads; until then a sprite draws a transparent
+// placeholder, so the first frame does not wait for the disk.
 class TextureManager {
 public:
     static bool loadTexture(const std::string& filename, GLuint& textureID) {
-        int width, height, channels;
-        constexpr int forceChannels = 4;
-        
-        unsigned char* imageData = stbi_load(filename.c_str(), &width, &height, &channels, forceChannels);
-        if (!imageData) {
-            std::cerr << "ERROR: Could not load texture: " << filename << std::endl;
-            return false;
-        }
-
-        glGenTextures(1, &textureID);
-        glBindTexture(GL_TEXTURE_2D, textureID);
+        static const unsigned char placeholder[4] = { 0, 0, 0, 0 };
+        textureID = loader().request(filename, placeholder);
+        if (!textureID) return false;
         
         // Set texture parameters
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -79,73 +81,23 @@ public:
         GLfloat maxAniso = 0.0f;
         glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAniso);
         glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, maxAniso);
-
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, imageData);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        stbi_image_free(imageData);
         return true;
     }
-};
 
-// Shader Manager
-class ShaderManager {
-private:
-    GLuint programID;
-
-    GLuint compileShader(const char* source, GLenum type) {
-        GLuint shader = glCreateShader(type);
-        glShaderSource(shader, 1, &source, nullptr);
-        glCompileShader(shader);
-
-        int success;
-        std::array<char, 512> infoLog;
-        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-        if (!success) {
-            glGetShaderInfoLog(shader, infoLog.size(), nullptr, infoLog.data());
-            std::cerr << "ERROR: Shader compilation failed (type " << type << "): " 
-                      << infoLog.data() << std::endl;
-        }
-        return shader;
+    // Uploads the images that finished decoding; call once per frame
+    static void pumpUploads() {
+        loader().pump();
     }
 
-public:
-    bool initialize() {
-        GLuint vertexShader = compileShader(Shaders::VERTEX_SHADER, GL_VERTEX_SHADER);
-        GLuint fragmentShader = compileShader(Shaders::FRAGMENT_SHADER, GL_FRAGMENT_SHADER);
-
-        programID = glCreateProgram();
-        glAttachShader(programID, vertexShader);
-        glAttachShader(programID, fragmentShader);
-        glLinkProgram(programID);
-
-        int success;
-        std::array<char, 512> infoLog;
-        glGetProgramiv(programID, GL_LINK_STATUS, &success);
-        if (!success) {
-            glGetProgramInfoLog(programID, infoLog.size(), nullptr, infoLog.data());
-            std::cerr << "ERROR: Shader program linking failed: " << infoLog.data() << std::endl;
-            return false;
-        }
-
-        glDeleteShader(vertexShader);
-        glDeleteShader(fragmentShader);
-        return true;
-    }
-
-    void use() const { glUseProgram(programID); }
-    GLuint getProgram() const { return programID; }
-    
-    void setMatrix4(const std::string& name, const glm::mat4& matrix) const {
-        glUniformMatrix4fv(glGetUniformLocation(programID, name.c_str()), 1, GL_FALSE, glm::value_ptr(matrix));
-    }
-    
-    void setInt(const std::string& name, int value) const {
-        glUniform1i(glGetUniformLocation(programID, name.c_str()), value);
+    // Before the GL context goes away
+    static void shutdown() {
+        loader().stop();
     }
 
-    ~ShaderManager() {
-        if (programID) glDeleteProgram(programID);
+private:
+    static AsyncTextureLoader& loader() {
+        static AsyncTextureLoader instance;
+        return instance;
     }
 };
 
@@ -183,7 +135,9 @@ public:
 class SpriteRenderer {
 private:
     GLuint VAO, VBO, EBO;
-    ShaderManager shader;
+    ShaderProgram shader;
+    FrameUniformBuffer frameUniforms;
+    GLint modelLoc = -1;
     glm::mat4 projection;
 
     void setupQuad() {
@@ -224,7 +178,10 @@ private:
 
 public:
     bool initialize() {
-        if (!shader.initialize()) return false;
+        if (!shader.build(Shaders::VERTEX_SHADER, Shaders::FRAGMENT_SHADER)) return false;
+        modelLoc = shader.location("model");
+        shader.use();
+        ShaderProgram::set(shader.location("basic_texture"), 0);
         
         setupQuad();
         projection = glm::ortho(0.0f, static_cast<float>(Config::WINDOW_WIDTH), 
@@ -237,17 +194,16 @@ public:
     }
 
     void render(const std::vector<std::unique_ptr<Sprite>>& sprites) {
+        frameUniforms.update(projection, static_cast<float>(Config::WINDOW_WIDTH),
+                             static_cast<float>(Config::WINDOW_HEIGHT), static_cast<float>(glfwGetTime()));
         shader.use();
-        shader.setMatrix4("projection", projection);
         
         glBindVertexArray(VAO);
+        glActiveTexture(GL_TEXTURE0);
         
         for (const auto& sprite : sprites) {
-            shader.setMatrix4("model", sprite->getModelMatrix());
-            
-            glActiveTexture(GL_TEXTURE0);
+            ShaderProgram::set(modelLoc, sprite->getModelMatrix());
             glBindTexture(GL_TEXTURE_2D, sprite->textureID);
-            shader.setInt("basic_texture", 0);
             
             glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
         }
@@ -329,6 +285,7 @@ public:
         while (!glfwWindowShouldClose(window)) {
             glfwPollEvents();
             processInput();
+            TextureManager::pumpUploads();
 
             glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
             glClear(GL_COLOR_BUFFER_BIT);
@@ -340,6 +297,7 @@ public:
     }
 
     ~Application() {
+        TextureManager::shutdown();
         glfwTerminate();
     }
 };
@@ -0,0 +1,86 @@
+#ifndef AnimationClips_h
+#define AnimationClips_h
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Clipes de animação avaliados a partir do tempo, sem estado por quadro.
+//
+// Um clipe é uma sequência de frameCount quadros a fps quadros por segundo
+// em uma linha da spritesheet (ou, para tiles, a partir de uma fatia do
+// array de texturas). Quem anima guarda só o clipe e o instante em que ele
+// começou; o quadro de qualquer instante sai de clipFrame, a mesma conta que
+// o vertex shader faz com o tempo do bloco Frame. Assim nada é atualizado na
+// CPU a cada quadro, não importa quantas entidades ou tiles estejam na tela.
+
+enum class AnimationLoop {
+    LOOP = 0,
+    ONCE,               // para no último quadro
+    PING_PONG           // vai e volta: 0 1 2 1 0 1 ...
+};
+
+struct AnimationClip {
+    int frameCount;
+    float fps;
+    int row;            // linha da spritesheet ou primeira fatia do tileset
+    AnimationLoop loop;
+};
+
+// Folga somada aos passos de quadro para absorver o arredondamento de tempos
+// que caem exatamente na troca de quadro. É a mesma na CPU e no shader
+// (CLIP_UNIFORM_BLOCK, via CLIP_STRINGIFY) para que os dois troquem de quadro
+// no mesmo instante. O valor é o do shader: lá a conta é em float, e uma
+// folga menor que o épsilon de elapsed * fps (~1e-5 com alguns minutos de
+// jogo) não teria efeito; em double ela só antecipa a troca em 1e-4 quadro.
+#define CLIP_STEP_SLACK 1e-4
+#define CLIP_STRINGIFY_(x) #x
+#define CLIP_STRINGIFY(x) CLIP_STRINGIFY_(x)
+
+// Passos inteiros de quadro desde o início do clipe.
+inline long long clipSteps(const AnimationClip& clip, double elapsed) {
+    const long long steps = (long long)std::floor(elapsed * clip.fps + CLIP_STEP_SLACK);
+    return std::max(steps, 0LL);
+}
+
+inline int clipFrame(const AnimationClip& clip, double elapsed) {
+    if (clip.frameCount <= 1 || clip.fps <= 0.0f) return 0;
+    const long long steps = clipSteps(clip, elapsed);
+    switch (clip.loop) {
+    case AnimationLoop::ONCE:
+        return (int)std::min<long long>(steps, clip.frameCount - 1);
+    case AnimationLoop::PING_PONG: {
+        const long long period = 2LL * (clip.frameCount - 1);
+        const long long k = steps % period;
+        return (int)(k < clip.frameCount ? k : period - k);
+    }
+    default:
+        return (int)(steps % clip.frameCount);
+    }
+}
+
+// Tempo até a próxima troca de quadro; 'never' se o clipe não muda mais.
+inline double secondsToNextClipFrame(const AnimationClip& clip, double elapsed, double never) {
+    if (clip.frameCount <= 1 || clip.fps <= 0.0f) return never;
+    const long long steps = clipSteps(clip, elapsed);
+    if (clip.loop == AnimationLoop::ONCE && steps >= clip.frameCount - 1) return never;
+    return std::max(0.0, (double)(steps + 1) / clip.fps - elapsed);
+}
+
+// Tabela de clipes; o índice é o que as entidades guardam em Animation::clip
+// e o que o shader usa para achar o clipe no bloco Clips.
+class AnimationClipTable {
+public:
+    int add(const AnimationClip& clip) {
+        clips.push_back(clip);
+        return (int)clips.size() - 1;
+    }
+
+    const AnimationClip& get(int index) const { return clips[index]; }
+    int size() const { return (int)clips.size(); }
+
+private:
+    std::vector<AnimationClip> clips;
+};
+
+#endif /* AnimationClips_h */
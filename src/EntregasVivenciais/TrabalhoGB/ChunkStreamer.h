@@ -0,0 +1,353 @@
+#ifndef ChunkStreamer_h
+#define ChunkStreamer_h
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "MapFile.h"
+#include "AsyncLog.h"
+
+// Chunk de uma camada do mapa residente em memória.
+struct StreamedChunk {
+    int cx, cy;
+    std::vector<TileId> tiles;                 // chunkSize * chunkSize, linha a linha
+    std::list<uint64_t>::iterator lruPos;
+    unsigned int gpuBuffer = 0;                // preenchidos por quem desenha o chunk
+    int gpuInstanceCount = 0;
+    bool gpuDirty = true;
+};
+
+// Mundo dividido em chunks lidos sob demanda de um .gbmap.
+//
+// A thread principal só pede chunks (update) e consome os que ficaram prontos
+// (pump); a decodificação acontece em uma thread de I/O. Nenhuma chamada da
+// thread principal espera pela thread de I/O: um chunk que ainda não chegou é
+// simplesmente tratado como ausente (getTile devolve MAP_EMPTY_TILE).
+// Os chunks ficam em um cache LRU limitado por um orçamento de memória, e os
+// que saem da vizinhança do jogador são descartados quando o orçamento estoura.
+// Alterações feitas no mapa (setTile/fillAll) são guardadas à parte e
+// reaplicadas quando um chunk descartado volta a ser carregado.
+class ChunkStreamer {
+public:
+    typedef std::function<void(StreamedChunk&)> ChunkCallback;
+
+    ChunkStreamer() : chunkSize(0), budgetBytes(64u << 20), running(false), fillActive(false), fillTile(0),
+                      lastChunk(nullptr), overBudgetWarned(false) {}
+
+    ~ChunkStreamer() {
+        stop();
+    }
+
+    bool open(const std::string& path, size_t memoryBudgetBytes, std::string& error) {
+        stop();
+        if (!reader.open(path, error)) return false;
+        chunkSize = reader.getChunkSize();
+        budgetBytes = memoryBudgetBytes;
+        running = true;
+        worker = std::thread(&ChunkStreamer::workerLoop, this);
+        return true;
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            running = false;
+            pendingRequests.clear();
+        }
+        queueCv.notify_all();
+        if (worker.joinable()) worker.join();
+    }
+
+    const MapFileReader& getReader() const { return reader; }
+    int getChunkSize() const { return chunkSize; }
+    int getRows() const { return reader.getRows(); }
+    int getCols() const { return reader.getCols(); }
+
+    // chamado quando um chunk entra no cache (já com as alterações aplicadas)
+    void setOnChunkLoaded(ChunkCallback callback) { onLoaded = callback; }
+    // chamado antes de um chunk ser descartado
+    void setOnChunkEvicted(ChunkCallback callback) { onEvicted = callback; }
+
+    // Marca como necessários os chunks a até 'radius' chunks do tile (row, col),
+    // pede os que faltam e descarta os mais antigos se passar do orçamento.
+    void update(int row, int col, int radius) {
+        int ccx = col / chunkSize;
+        int ccy = row / chunkSize;
+
+        wanted.clear();
+        std::vector<uint64_t> missing;
+        for (int cy = ccy - radius; cy <= ccy + radius; ++cy) {
+            for (int cx = ccx - radius; cx <= ccx + radius; ++cx) {
+                if (cx < 0 || cy < 0 || cx >= reader.getChunksX() || cy >= reader.getChunksY()) continue;
+                uint64_t key = chunkKey(cx, cy);
+                wanted.insert(key);
+                auto it = resident.find(key);
+                if (it != resident.end()) {
+                    touch(*it->second);
+                } else if (requested.find(key) == requested.end()) {
+                    missing.push_back(key);
+                }
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(queueMutex, std::try_to_lock);
+        if (lock.owns_lock()) {
+            // pedidos que saíram da vizinhança deixam de ser interessantes
+            for (auto it = pendingRequests.begin(); it != pendingRequests.end();) {
+                if (wanted.find(*it) == wanted.end()) {
+                    requested.erase(*it);
+                    it = pendingRequests.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            for (uint64_t key : missing) {
+                pendingRequests.push_back(key);
+                requested.insert(key);
+            }
+            lock.unlock();
+            if (!missing.empty()) queueCv.notify_one();
+        }
+
+        evictOverBudget();
+    }
+
+    // Integra até 'maxChunks' chunks decodificados. Nunca bloqueia.
+    int pump(int maxChunks) {
+        std::unique_lock<std::mutex> lock(queueMutex, std::try_to_lock);
+        if (!lock.owns_lock()) return 0;
+        std::vector<std::unique_ptr<StreamedChunk>> ready;
+        while (!completed.empty() && (int)ready.size() < maxChunks) {
+            ready.push_back(std::move(completed.front()));
+            completed.pop_front();
+        }
+        lock.unlock();
+
+        for (std::unique_ptr<StreamedChunk>& chunk : ready) {
+            uint64_t key = chunkKey(chunk->cx, chunk->cy);
+            requested.erase(key);
+            if (resident.find(key) != resident.end()) continue;
+            applyEdits(*chunk);
+            lru.push_front(key);
+            chunk->lruPos = lru.begin();
+            StreamedChunk& stored = *chunk;
+            resident[key] = std::move(chunk);
+            if (onLoaded) onLoaded(stored);
+        }
+        if (!ready.empty()) evictOverBudget();
+        return (int)ready.size();
+    }
+
+    // Carrega um chunk imediatamente, na thread chamadora. Só para a inicialização.
+    StreamedChunk* loadNow(int cx, int cy) {
+        uint64_t key = chunkKey(cx, cy);
+        auto it = resident.find(key);
+        if (it != resident.end()) return it->second.get();
+        std::unique_ptr<StreamedChunk> chunk = decode(cx, cy);
+        if (!chunk) return nullptr;
+        applyEdits(*chunk);
+        lru.push_front(key);
+        chunk->lruPos = lru.begin();
+        StreamedChunk* stored = chunk.get();
+        resident[key] = std::move(chunk);
+        if (onLoaded) onLoaded(*stored);
+        return stored;
+    }
+
+    bool isResident(int row, int col) const {
+        return findChunk(row, col) != nullptr;
+    }
+
+    TileId getTile(int row, int col) const {
+        StreamedChunk* chunk = findChunk(row, col);
+        if (!chunk) return MAP_EMPTY_TILE;
+        return chunk->tiles[(row % chunkSize) * chunkSize + (col % chunkSize)];
+    }
+
+    void setTile(int row, int col, TileId tile) {
+        if (row < 0 || col < 0 || row >= getRows() || col >= getCols()) return;
+        edits[cellKey(row, col)] = tile;
+        StreamedChunk* chunk = findChunk(row, col);
+        if (chunk) {
+            chunk->tiles[(row % chunkSize) * chunkSize + (col % chunkSize)] = tile;
+            chunk->gpuDirty = true;
+        }
+    }
+
+    // Preenche o mundo todo: os chunks residentes agora, os demais ao chegarem.
+    void fillAll(TileId tile) {
+        fillActive = true;
+        fillTile = tile;
+        edits.clear();
+        for (auto& entry : resident) {
+            fillChunk(*entry.second);
+        }
+    }
+
+    // Volta ao conteúdo original do arquivo, descartando as alterações.
+    void resetEdits() {
+        fillActive = false;
+        edits.clear();
+        for (auto& entry : resident) {
+            if (onEvicted) onEvicted(*entry.second);
+        }
+        resident.clear();
+        lru.clear();
+        lastChunk = nullptr;
+    }
+
+    template <typename Func>
+    void forEachResident(Func func) {
+        for (auto& entry : resident) func(*entry.second);
+    }
+
+    // há chunks pedidos que ainda não foram integrados por pump()
+    bool hasPendingLoads() const { return !requested.empty(); }
+
+    size_t residentCount() const { return resident.size(); }
+    size_t residentBytes() const { return resident.size() * bytesPerChunk(); }
+    size_t bytesPerChunk() const { return (size_t)chunkSize * chunkSize * (sizeof(TileId) + extraBytesPerTile); }
+
+    // memória extra por tile mantida fora do streamer (ex.: buffer na GPU)
+    void setExtraBytesPerTile(size_t bytes) { extraBytesPerTile = bytes; }
+
+private:
+    static uint64_t chunkKey(int cx, int cy) {
+        return ((uint64_t)(uint32_t)cy << 32) | (uint32_t)cx;
+    }
+
+    static uint64_t cellKey(int row, int col) {
+        return ((uint64_t)(uint32_t)row << 32) | (uint32_t)col;
+    }
+
+    StreamedChunk* findChunk(int row, int col) const {
+        if (row < 0 || col < 0 || row >= reader.getRows() || col >= reader.getCols()) return nullptr;
+        int cx = col / chunkSize;
+        int cy = row / chunkSize;
+        if (lastChunk && lastChunk->cx == cx && lastChunk->cy == cy) return lastChunk;
+        auto it = resident.find(chunkKey(cx, cy));
+        if (it == resident.end()) return nullptr;
+        lastChunk = it->second.get();
+        return lastChunk;
+    }
+
+    void touch(StreamedChunk& chunk) {
+        lru.splice(lru.begin(), lru, chunk.lruPos);
+    }
+
+    void fillChunk(StreamedChunk& chunk) {
+        int rows = std::min(chunkSize, getRows() - chunk.cy * chunkSize);
+        int cols = std::min(chunkSize, getCols() - chunk.cx * chunkSize);
+        for (int r = 0; r < rows; ++r) {
+            std::memset(chunk.tiles.data() + (size_t)r * chunkSize, fillTile, cols);
+        }
+        chunk.gpuDirty = true;
+    }
+
+    void applyEdits(StreamedChunk& chunk) {
+        if (fillActive) fillChunk(chunk);
+        if (edits.empty()) return;
+        int row0 = chunk.cy * chunkSize;
+        int col0 = chunk.cx * chunkSize;
+        if (edits.size() < (size_t)chunkSize * chunkSize) {
+            for (const auto& edit : edits) {
+                int row = (int)(edit.first >> 32);
+                int col = (int)(edit.first & 0xFFFFFFFFu);
+                if (row >= row0 && row < row0 + chunkSize && col >= col0 && col < col0 + chunkSize) {
+                    chunk.tiles[(row - row0) * chunkSize + (col - col0)] = edit.second;
+                }
+            }
+        } else {
+            for (int r = 0; r < chunkSize; ++r) {
+                for (int c = 0; c < chunkSize; ++c) {
+                    auto it = edits.find(cellKey(row0 + r, col0 + c));
+                    if (it != edits.end()) chunk.tiles[r * chunkSize + c] = it->second;
+                }
+            }
+        }
+    }
+
+    void evictOverBudget() {
+        size_t perChunk = bytesPerChunk();
+        auto it = lru.end();
+        while (resident.size() * perChunk > budgetBytes && it != lru.begin()) {
+            --it;
+            uint64_t key = *it;
+            if (wanted.find(key) != wanted.end()) continue;
+            auto found = resident.find(key);
+            if (onEvicted) onEvicted(*found->second);
+            if (lastChunk == found->second.get()) lastChunk = nullptr;
+            resident.erase(found);
+            it = lru.erase(it);
+        }
+        if (resident.size() * perChunk > budgetBytes && !overBudgetWarned) {
+            overBudgetWarned = true;
+            LOG_WARN("Aviso: a vizinhanca visivel ocupa mais que o orcamento de chunks (%zu MB)", budgetBytes >> 20);
+        }
+    }
+
+    std::unique_ptr<StreamedChunk> decode(int cx, int cy) const {
+        std::unique_ptr<StreamedChunk> chunk(new StreamedChunk());
+        chunk->cx = cx;
+        chunk->cy = cy;
+        chunk->tiles.resize((size_t)chunkSize * chunkSize);
+        if (!reader.decodeChunk(0, cx, cy, chunk->tiles.data())) {
+            LOG_WARN("Chunk (%d, %d) corrompido", cx, cy);
+            std::fill(chunk->tiles.begin(), chunk->tiles.end(), (TileId)MAP_EMPTY_TILE);
+        }
+        return chunk;
+    }
+
+    void workerLoop() {
+        for (;;) {
+            uint64_t key;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueCv.wait(lock, [this] { return !running || !pendingRequests.empty(); });
+                if (!running) return;
+                key = pendingRequests.front();
+                pendingRequests.pop_front();
+            }
+            std::unique_ptr<StreamedChunk> chunk = decode((int)(key & 0xFFFFFFFFu), (int)(key >> 32));
+            std::lock_guard<std::mutex> lock(queueMutex);
+            completed.push_back(std::move(chunk));
+        }
+    }
+
+    MapFileReader reader;
+    int chunkSize;
+    size_t budgetBytes;
+    size_t extraBytesPerTile = 0;
+
+    // compartilhado com a thread de I/O
+    std::mutex queueMutex;
+    std::condition_variable queueCv;
+    std::deque<uint64_t> pendingRequests;
+    std::deque<std::unique_ptr<StreamedChunk>> completed;
+    bool running;
+    std::thread worker;
+
+    // somente thread principal
+    std::unordered_map<uint64_t, std::unique_ptr<StreamedChunk>> resident;
+    std::list<uint64_t> lru;
+    std::unordered_set<uint64_t> wanted;
+    std::unordered_set<uint64_t> requested;
+    std::unordered_map<uint64_t, TileId> edits;
+    bool fillActive;
+    TileId fillTile;
+    mutable StreamedChunk* lastChunk;
+    bool overBudgetWarned;
+    ChunkCallback onLoaded;
+    ChunkCallback onEvicted;
+};
+
+#endif /* ChunkStreamer_h */
@@ -0,0 +1,359 @@
+#ifndef Ecs_h
+#define Ecs_h
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "WorkerPool.h"
+
+// ECS por arquétipos.
+//
+// Cada combinação de componentes (um arquétipo) guarda as suas entidades em
+// colunas contíguas, uma por componente (SoA). Criar uma entidade, ou dar e
+// tirar componentes dela, move a sua linha para o arquétipo certo; destruir
+// troca a linha pela última. Os sistemas usam each(), que percorre linha a
+// linha só os arquétipos que têm todos os componentes pedidos, sem nenhuma
+// indireção por entidade. Durante um each() a estrutura (criar, destruir,
+// add, remove) não pode mudar.
+//
+// Componentes precisam ser trivialmente copiáveis (as linhas são movidas com
+// memcpy); cabem até 32 tipos.
+
+struct Entity {
+    uint32_t index;
+    uint32_t generation;
+
+    bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+constexpr Entity NO_ENTITY = { 0xFFFFFFFFu, 0 };
+
+class EntityWorld {
+public:
+    typedef uint32_t ComponentMask;
+    static constexpr int MAX_COMPONENTS = 32;
+
+    EntityWorld() : liveCount(0) {}
+
+    template <class... Cs>
+    Entity create(const Cs&... values) {
+        const int a = archetypeFor(maskOf<Cs...>());
+        const Entity entity = allocate();
+        const size_t row = appendRow(a, entity);
+        int unused[] = { 0, (write(a, row, values), 0)... };
+        (void)unused;
+        records[entity.index].archetype = a;
+        records[entity.index].row = row;
+        return entity;
+    }
+
+    void destroy(Entity entity) {
+        if (!alive(entity)) return;
+        const Record record = records[entity.index];
+        removeRow(record.archetype, record.row);
+        release(entity.index);
+    }
+
+    // destrói todas as entidades que têm os componentes Cs
+    template <class... Cs>
+    void destroyEach() {
+        const ComponentMask mask = maskOf<Cs...>();
+        for (size_t a = 0; a < archetypes.size(); ++a) {
+            Archetype& archetype = archetypes[a];
+            if ((archetype.mask & mask) != mask) continue;
+            for (size_t i = 0; i < archetype.entities.size(); ++i) release(archetype.entities[i].index);
+            archetype.entities.clear();
+            for (size_t c = 0; c < archetype.columns.size(); ++c) archetype.columns[c].data.clear();
+        }
+    }
+
+    bool alive(Entity entity) const {
+        return entity.index < records.size() && records[entity.index].generation == entity.generation &&
+               records[entity.index].archetype >= 0;
+    }
+
+    // nullptr se a entidade não existe ou não tem o componente
+    template <class T>
+    T* get(Entity entity) {
+        if (!alive(entity)) return nullptr;
+        const Record& record = records[entity.index];
+        const int column = archetypes[record.archetype].columnOf[componentId<T>()];
+        if (column < 0) return nullptr;
+        return reinterpret_cast<T*>(archetypes[record.archetype].columns[column].data.data()) + record.row;
+    }
+
+    template <class T>
+    const T* get(Entity entity) const {
+        return const_cast<EntityWorld*>(this)->get<T>(entity);
+    }
+
+    template <class T>
+    void add(Entity entity, const T& value) {
+        if (!alive(entity)) return;
+        if (T* existing = get<T>(entity)) {
+            *existing = value;
+            return;
+        }
+        const size_t row = moveTo(entity, archetypes[records[entity.index].archetype].mask | componentBit<T>());
+        write(records[entity.index].archetype, row, value);
+    }
+
+    template <class T>
+    void remove(Entity entity) {
+        if (!alive(entity) || !get<T>(entity)) return;
+        moveTo(entity, archetypes[records[entity.index].archetype].mask & ~componentBit<T>());
+    }
+
+    // fn(Cs&...) para cada entidade que tem todos os Cs
+    template <class... Cs, class F>
+    void each(F&& fn) {
+        const ComponentMask mask = maskOf<Cs...>();
+        for (size_t a = 0; a < archetypes.size(); ++a) {
+            if ((archetypes[a].mask & mask) != mask || archetypes[a].entities.empty()) continue;
+            eachRow<Cs...>(archetypes[a], 0, archetypes[a].entities.size(), fn);
+        }
+    }
+
+    // como each(), com a entidade antes dos componentes: fn(Entity, Cs&...)
+    template <class... Cs, class F>
+    void eachEntity(F&& fn) {
+        const ComponentMask mask = maskOf<Cs...>();
+        for (size_t a = 0; a < archetypes.size(); ++a) {
+            Archetype& archetype = archetypes[a];
+            if ((archetype.mask & mask) != mask || archetype.entities.empty()) continue;
+            std::tuple<Cs*...> columns(columnData<Cs>(archetype)...);
+            for (size_t i = 0; i < archetype.entities.size(); ++i) {
+                fn(archetype.entities[i], std::get<Cs*>(columns)[i]...);
+            }
+        }
+    }
+
+    // fn(const Cs&...), para consultas
+    template <class... Cs, class F>
+    void each(F&& fn) const {
+        const_cast<EntityWorld*>(this)->each<Cs...>([&](Cs&... components) { fn(static_cast<const Cs&>(components)...); });
+    }
+
+    // Como each(), em blocos de até blockSize linhas distribuídos entre as
+    // threads do pool; fn não pode depender da ordem nem escrever fora da
+    // própria linha.
+    template <class... Cs, class F>
+    void eachParallel(WorkerPool& pool, F&& fn, size_t blockSize = 4096) {
+        const ComponentMask mask = maskOf<Cs...>();
+        blocks.clear();
+        for (size_t a = 0; a < archetypes.size(); ++a) {
+            if ((archetypes[a].mask & mask) != mask) continue;
+            for (size_t begin = 0; begin < archetypes[a].entities.size(); begin += blockSize) {
+                Block block = { (int)a, begin, std::min(begin + blockSize, archetypes[a].entities.size()) };
+                blocks.push_back(block);
+            }
+        }
+        pool.parallelFor((int)blocks.size(), [&](int i, int) {
+            eachRow<Cs...>(archetypes[blocks[i].archetype], blocks[i].begin, blocks[i].end, fn);
+        });
+    }
+
+    // quantas entidades têm todos os Cs
+    template <class... Cs>
+    size_t count() const {
+        const ComponentMask mask = maskOf<Cs...>();
+        size_t total = 0;
+        for (size_t a = 0; a < archetypes.size(); ++a) {
+            if ((archetypes[a].mask & mask) == mask) total += archetypes[a].entities.size();
+        }
+        return total;
+    }
+
+    size_t size() const { return liveCount; }
+    size_t getArchetypeCount() const { return archetypes.size(); }
+
+    void clear() {
+        archetypes.clear();
+        records.clear();
+        freeIndices.clear();
+        liveCount = 0;
+    }
+
+    // Identificador de cada tipo de componente, atribuído no primeiro uso.
+    template <class T>
+    static int componentId() {
+        static_assert(std::is_trivially_copyable<T>::value, "componentes sao copiados com memcpy");
+        static const int id = registerComponent(sizeof(T));
+        return id;
+    }
+
+    template <class T>
+    static ComponentMask componentBit() {
+        return 1u << componentId<T>();
+    }
+
+private:
+    struct Column {
+        size_t elementSize;
+        std::vector<unsigned char> data;
+    };
+
+    struct Archetype {
+        ComponentMask mask;
+        std::vector<Entity> entities;
+        std::vector<Column> columns;          // na ordem dos ids de componente
+        int columnOf[MAX_COMPONENTS];         // -1 se o arquétipo não tem o componente
+    };
+
+    struct Record {
+        uint32_t generation;
+        int archetype;                        // -1: índice livre
+        size_t row;
+    };
+
+    struct Block {
+        int archetype;
+        size_t begin;
+        size_t end;
+    };
+
+    // Mundos de threads diferentes (--sessions) podem registrar tipos ao mesmo
+    // tempo. O tamanho é escrito antes de o id ser publicado pela variável
+    // estática de componentId, então quem tem o id sempre vê o tamanho.
+    static int registerComponent(size_t size) {
+        static std::atomic<int> next(0);
+        const int id = next.fetch_add(1);
+        assert(id < MAX_COMPONENTS);
+        componentSizes()[id] = size;
+        return id;
+    }
+
+    static size_t* componentSizes() {
+        static size_t sizes[MAX_COMPONENTS];
+        return sizes;
+    }
+
+    template <class... Cs>
+    static ComponentMask maskOf() {
+        ComponentMask mask = 0;
+        int unused[] = { 0, (mask |= componentBit<Cs>(), 0)... };
+        (void)unused;
+        return mask;
+    }
+
+    template <class... Cs, class F>
+    static void eachRow(Archetype& archetype, size_t begin, size_t end, F& fn) {
+        std::tuple<Cs*...> columns(columnData<Cs>(archetype)...);
+        for (size_t i = begin; i < end; ++i) {
+            fn(std::get<Cs*>(columns)[i]...);
+        }
+    }
+
+    template <class T>
+    static T* columnData(Archetype& archetype) {
+        return reinterpret_cast<T*>(archetype.columns[archetype.columnOf[componentId<T>()]].data.data());
+    }
+
+    int archetypeFor(ComponentMask mask) {
+        for (size_t a = 0; a < archetypes.size(); ++a) {
+            if (archetypes[a].mask == mask) return (int)a;
+        }
+        Archetype archetype;
+        archetype.mask = mask;
+        for (int id = 0; id < MAX_COMPONENTS; ++id) {
+            archetype.columnOf[id] = -1;
+            if (!(mask & (1u << id))) continue;
+            archetype.columnOf[id] = (int)archetype.columns.size();
+            Column column = { componentSizes()[id], std::vector<unsigned char>() };
+            archetype.columns.push_back(column);
+        }
+        archetypes.push_back(archetype);
+        return (int)archetypes.size() - 1;
+    }
+
+    Entity allocate() {
+        uint32_t index;
+        if (!freeIndices.empty()) {
+            index = freeIndices.back();
+            freeIndices.pop_back();
+        } else {
+            index = (uint32_t)records.size();
+            Record record = { 0, -1, 0 };
+            records.push_back(record);
+        }
+        liveCount++;
+        Entity entity = { index, records[index].generation };
+        return entity;
+    }
+
+    void release(uint32_t index) {
+        records[index].generation++;
+        records[index].archetype = -1;
+        freeIndices.push_back(index);
+        liveCount--;
+    }
+
+    size_t appendRow(int a, Entity entity) {
+        Archetype& archetype = archetypes[a];
+        archetype.entities.push_back(entity);
+        for (size_t c = 0; c < archetype.columns.size(); ++c) {
+            Column& column = archetype.columns[c];
+            column.data.resize(column.data.size() + column.elementSize);
+        }
+        return archetype.entities.size() - 1;
+    }
+
+    template <class T>
+    void write(int a, size_t row, const T& value) {
+        Archetype& archetype = archetypes[a];
+        memcpy(archetype.columns[archetype.columnOf[componentId<T>()]].data.data() + row * sizeof(T), &value, sizeof(T));
+    }
+
+    // tira a linha do arquétipo trazendo a última para o lugar dela
+    void removeRow(int a, size_t row) {
+        Archetype& archetype = archetypes[a];
+        const size_t last = archetype.entities.size() - 1;
+        if (row != last) {
+            for (size_t c = 0; c < archetype.columns.size(); ++c) {
+                Column& column = archetype.columns[c];
+                memcpy(column.data.data() + row * column.elementSize, column.data.data() + last * column.elementSize, column.elementSize);
+            }
+            archetype.entities[row] = archetype.entities[last];
+            records[archetype.entities[row].index].row = row;
+        }
+        archetype.entities.pop_back();
+        for (size_t c = 0; c < archetype.columns.size(); ++c) {
+            archetype.columns[c].data.resize(last * archetype.columns[c].elementSize);
+        }
+    }
+
+    // Move a entidade para o arquétipo da máscara, copiando os componentes
+    // que os dois têm em comum. Devolve a linha nova.
+    size_t moveTo(Entity entity, ComponentMask mask) {
+        const int target = archetypeFor(mask);
+        const Record record = records[entity.index];
+        const size_t row = appendRow(target, entity);
+        Archetype& from = archetypes[record.archetype];
+        Archetype& to = archetypes[target];
+        for (int id = 0; id < MAX_COMPONENTS; ++id) {
+            if (from.columnOf[id] < 0 || to.columnOf[id] < 0) continue;
+            const Column& source = from.columns[from.columnOf[id]];
+            Column& destination = to.columns[to.columnOf[id]];
+            memcpy(destination.data.data() + row * destination.elementSize, source.data.data() + record.row * source.elementSize, source.elementSize);
+        }
+        removeRow(record.archetype, record.row);
+        records[entity.index].archetype = target;
+        records[entity.index].row = row;
+        return row;
+    }
+
+    std::vector<Archetype> archetypes;
+    std::vector<Record> records;
+    std::vector<uint32_t> freeIndices;
+    std::vector<Block> blocks;
+    size_t liveCount;
+};
+
+#endif /* Ecs_h */
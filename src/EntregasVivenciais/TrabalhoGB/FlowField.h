@@ -0,0 +1,433 @@
+#ifndef FlowField_h
+#define FlowField_h
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "PathFinder.h"
+#include "WorkerPool.h"
+
+// Campo de fluxo até um alvo (o jogador), compartilhado por todos os agentes.
+//
+// O campo de integração guarda o custo do menor caminho de cada tile até o
+// alvo (10 em linha reta, 14 na diagonal, como no PathFinder) e o campo de
+// direções, para cada tile, o vizinho que continua esse caminho. Um agente só
+// lê a direção do tile em que está: nenhuma busca por agente.
+//
+// O mapa é dividido em blocos de chunkSize x chunkSize tiles. Cada bloco roda
+// um Dijkstra restrito a si, a partir dos tiles que melhoraram, lendo os
+// custos da borda dos blocos vizinhos; quando um tile da sua borda melhora, o
+// vizinho daquele lado volta para a fila. Os blocos pendentes são processados
+// em quatro cores (paridade de x e de y do bloco): dois blocos da mesma cor
+// nunca são vizinhos, nem na diagonal, então os de uma cor rodam em paralelo
+// sem que um leia o que outro está escrevendo. O resultado é o mesmo de um
+// Dijkstra único, com qualquer número de threads.
+class FlowField {
+public:
+    static constexpr uint32_t UNREACHABLE = 0xFFFFFFFFu;
+    static constexpr uint8_t NO_DIRECTION = 8;     // alvo, bloqueado ou sem caminho
+
+    explicit FlowField(int chunkSize = 32)
+        : chunkSize(chunkSize), width(0), height(0), chunksX(0), chunksY(0), goalCol(-1), goalRow(-1),
+          lastChunkRuns(0), lastRounds(0) {}
+
+    // Recalcula os dois campos para o alvo (col, row). O alvo não precisa ser
+    // caminhável; os outros tiles sim. Sem pool, roda tudo nesta thread.
+    void compute(const WalkMask& mask, int col, int row, WorkerPool* pool) {
+        if (mask.getWidth() != width || mask.getHeight() != height) resize(mask.getWidth(), mask.getHeight());
+        goalCol = col;
+        goalRow = row;
+        lastChunkRuns = 0;
+        lastRounds = 0;
+        std::fill(costs.begin(), costs.end(), UNREACHABLE);
+        if (col < 0 || col >= width || row < 0 || row >= height) {
+            std::fill(directions.begin(), directions.end(), NO_DIRECTION);
+            return;
+        }
+        const int threads = pool ? pool->getThreadCount() : 1;
+        if ((int)open.size() < threads) open.resize(threads);
+
+        const int goal = col + row * width;
+        const int goalChunk = col / chunkSize + (row / chunkSize) * chunksX;
+        costs[goal] = 0;
+        std::fill(keys.begin(), keys.end(), UNREACHABLE);
+        std::fill(listed.begin(), listed.end(), 0);
+        pendingList.clear();
+        keys[goalChunk] = 0;
+        listed[goalChunk] = 1;
+        pendingList.push_back(goalChunk);
+
+        // Blocos fora de ordem refazem trabalho (o custo que chega depois
+        // melhora tiles já calculados), então cada rodada só pega os blocos
+        // pendentes cujo menor custo de entrada está a até um bloco de
+        // distância do menor de todos, como um Dijkstra em nível de bloco.
+        const uint32_t window = (uint32_t)chunkSize * PathFinder::STRAIGHT_COST;
+        bool seeded = false;
+        while (!pendingList.empty()) {
+            lastRounds++;
+            uint32_t minKey = UNREACHABLE;
+            for (size_t i = 0; i < pendingList.size(); ++i) minKey = std::min(minKey, keys[pendingList[i]]);
+            const uint32_t limit = minKey + window;
+
+            for (int color = 0; color < 4; ++color) {
+                batch.clear();
+                for (size_t i = 0; i < pendingList.size(); ++i) {
+                    const int k = pendingList[i];
+                    if (keys[k] <= limit && colorOf(k) == color) batch.push_back(k);
+                }
+                if (batch.empty()) continue;
+                for (size_t i = 0; i < batch.size(); ++i) keys[batch[i]] = UNREACHABLE;
+                borderCosts.assign(batch.size() * 8, UNREACHABLE);
+
+                const int seedGoal = seeded ? -1 : goal;
+                seeded = true;
+                auto run = [&](int i, int worker) {
+                    relaxChunk(mask, batch[i], seedGoal, open[worker], &borderCosts[i * 8]);
+                };
+                if (pool) pool->parallelFor((int)batch.size(), run);
+                else for (int i = 0; i < (int)batch.size(); ++i) run(i, 0);
+                lastChunkRuns += (int)batch.size();
+
+                for (size_t i = 0; i < batch.size(); ++i) {
+                    const int cx = batch[i] % chunksX;
+                    const int cy = batch[i] / chunksX;
+                    for (int d = 0; d < 8; ++d) {
+                        const uint32_t cost = borderCosts[i * 8 + d];
+                        const int nx = cx + DX[d];
+                        const int ny = cy + DY[d];
+                        if (cost == UNREACHABLE || nx < 0 || nx >= chunksX || ny < 0 || ny >= chunksY) continue;
+                        const int k = nx + ny * chunksX;
+                        keys[k] = std::min(keys[k], cost);
+                        if (!listed[k]) {
+                            listed[k] = 1;
+                            pendingList.push_back(k);
+                        }
+                    }
+                }
+            }
+
+            // tira da lista os blocos que rodaram e não voltaram a ficar pendentes
+            size_t kept = 0;
+            for (size_t i = 0; i < pendingList.size(); ++i) {
+                const int k = pendingList[i];
+                if (keys[k] != UNREACHABLE) pendingList[kept++] = k;
+                else listed[k] = 0;
+            }
+            pendingList.resize(kept);
+        }
+
+        auto orient = [&](int k, int) { orientChunk(mask, k); };
+        if (pool) pool->parallelFor(chunksX * chunksY, orient);
+        else for (int k = 0; k < chunksX * chunksY; ++k) orient(k, 0);
+    }
+
+    bool isComputedFor(int col, int row) const { return goalCol == col && goalRow == row && !costs.empty(); }
+
+    // o mapa mudou: o próximo compute é obrigatório mesmo com o mesmo alvo
+    void invalidate() {
+        goalCol = -1;
+        goalRow = -1;
+    }
+
+    // Tile seguinte a partir de 'tile' (col + row * largura); o próprio tile
+    // quando não há para onde ir.
+    int next(int tile) const {
+        const uint8_t d = directions[tile];
+        return d == NO_DIRECTION ? tile : tile + offsets[d];
+    }
+
+    // Mesmo passo em coordenadas da grade; false se o agente fica parado.
+    bool step(int& col, int& row) const {
+        const uint8_t d = directions[col + row * width];
+        if (d == NO_DIRECTION) return false;
+        col += DX[d];
+        row += DY[d];
+        return true;
+    }
+
+    uint8_t direction(int col, int row) const { return directions[col + row * width]; }
+    uint32_t cost(int col, int row) const { return costs[col + row * width]; }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getGoalCol() const { return goalCol; }
+    int getGoalRow() const { return goalRow; }
+    int getChunkCount() const { return chunksX * chunksY; }
+    int getLastChunkRuns() const { return lastChunkRuns; }
+    int getLastRounds() const { return lastRounds; }
+
+private:
+    // retas primeiro, depois diagonais
+    static constexpr int DX[8] = { 1, -1, 0, 0, 1, -1, 1, -1 };
+    static constexpr int DY[8] = { 0, 0, 1, -1, 1, 1, -1, -1 };
+
+    static uint32_t stepCost(int d) { return d < 4 ? PathFinder::STRAIGHT_COST : PathFinder::DIAGONAL_COST; }
+
+    void resize(int w, int h) {
+        width = w;
+        height = h;
+        chunksX = (w + chunkSize - 1) / chunkSize;
+        chunksY = (h + chunkSize - 1) / chunkSize;
+        costs.assign((size_t)w * h, UNREACHABLE);
+        directions.assign((size_t)w * h, NO_DIRECTION);
+        keys.assign(chunksX * chunksY, UNREACHABLE);
+        listed.assign(chunksX * chunksY, 0);
+        for (int d = 0; d < 8; ++d) offsets[d] = DX[d] + DY[d] * w;
+    }
+
+    int colorOf(int k) const {
+        return (k % chunksX) % 2 + ((k / chunksX) % 2) * 2;
+    }
+
+    // Dijkstra dentro do bloco k. Em sideCosts[d] fica o menor custo entre os
+    // tiles melhorados da borda do lado d (na ordem de DX/DY), ou UNREACHABLE.
+    void relaxChunk(const WalkMask& mask, int k, int goal, OpenList& heap, uint32_t* sideCosts) {
+        const int x0 = (k % chunksX) * chunkSize;
+        const int y0 = (k / chunksX) * chunkSize;
+        const int x1 = std::min(x0 + chunkSize, width);
+        const int y1 = std::min(y0 + chunkSize, height);
+        heap.clear();
+
+        // custos que chegam dos blocos vizinhos, pelos tiles da borda
+        for (int r = y0; r < y1; ++r) {
+            // nas linhas do meio, só a primeira e a última coluna
+            const int step = (r == y0 || r == y1 - 1) ? 1 : std::max(1, x1 - 1 - x0);
+            for (int c = x0; c < x1; c += step) {
+                if (!mask.walkable(c, r)) continue;
+                const int tile = c + r * width;
+                uint32_t best = costs[tile];
+                for (int d = 0; d < 8; ++d) {
+                    const int nc = c + DX[d];
+                    const int nr = r + DY[d];
+                    if (nc < 0 || nc >= width || nr < 0 || nr >= height) continue;
+                    if (nc >= x0 && nc < x1 && nr >= y0 && nr < y1) continue;
+                    const uint32_t through = costs[tile + offsets[d]];
+                    if (through != UNREACHABLE) best = std::min(best, through + stepCost(d));
+                }
+                if (best < costs[tile]) {
+                    costs[tile] = best;
+                    heap.push(tile, best, best);
+                }
+            }
+        }
+        if (goal >= 0 && goal % width >= x0 && goal % width < x1 && goal / width >= y0 && goal / width < y1) {
+            heap.push(goal, 0, 0);
+        }
+
+        while (!heap.empty()) {
+            const OpenEntry top = heap.pop();
+            if (top.g != costs[top.index]) continue;
+            const int c = top.index % width;
+            const int r = top.index / width;
+            const uint8_t sides = edgeBits(c - x0, r - y0, x1 - x0, y1 - y0);
+            for (int d = 0; sides >> d; ++d) {
+                if ((sides >> d) & 1) sideCosts[d] = std::min(sideCosts[d], top.g);
+            }
+            for (int d = 0; d < 8; ++d) {
+                const int nc = c + DX[d];
+                const int nr = r + DY[d];
+                if (nc < x0 || nc >= x1 || nr < y0 || nr >= y1 || !mask.walkable(nc, nr)) continue;
+                const int tile = top.index + offsets[d];
+                const uint32_t g = top.g + stepCost(d);
+                if (g < costs[tile]) {
+                    costs[tile] = g;
+                    heap.push(tile, g, g);
+                }
+            }
+        }
+    }
+
+    // lados do bloco (w x h) encostados no tile local (x, y)
+    static uint8_t edgeBits(int x, int y, int w, int h) {
+        const bool left = x == 0, right = x == w - 1, top = y == 0, bottom = y == h - 1;
+        uint8_t bits = 0;
+        if (right) bits |= 1 << 0;
+        if (left) bits |= 1 << 1;
+        if (bottom) bits |= 1 << 2;
+        if (top) bits |= 1 << 3;
+        if (right && bottom) bits |= 1 << 4;
+        if (left && bottom) bits |= 1 << 5;
+        if (right && top) bits |= 1 << 6;
+        if (left && top) bits |= 1 << 7;
+        return bits;
+    }
+
+    // Direção de cada tile do bloco k: o vizinho que está no menor caminho
+    // (no empate, o primeiro na ordem de DX/DY, então o campo é sempre o mesmo).
+    void orientChunk(const WalkMask& mask, int k) {
+        const int x0 = (k % chunksX) * chunkSize;
+        const int y0 = (k / chunksX) * chunkSize;
+        const int x1 = std::min(x0 + chunkSize, width);
+        const int y1 = std::min(y0 + chunkSize, height);
+        for (int r = y0; r < y1; ++r) {
+            for (int c = x0; c < x1; ++c) {
+                const int tile = c + r * width;
+                uint8_t best = NO_DIRECTION;
+                if (costs[tile] != UNREACHABLE && costs[tile] != 0 && mask.walkable(c, r)) {
+                    uint32_t bestCost = UNREACHABLE;
+                    for (int d = 0; d < 8; ++d) {
+                        const int nc = c + DX[d];
+                        const int nr = r + DY[d];
+                        if (nc < 0 || nc >= width || nr < 0 || nr >= height) continue;
+                        const uint32_t through = costs[tile + offsets[d]];
+                        if (through != UNREACHABLE && through + stepCost(d) < bestCost) {
+                            bestCost = through + stepCost(d);
+                            best = (uint8_t)d;
+                        }
+                    }
+                }
+                directions[tile] = best;
+            }
+        }
+    }
+
+    int chunkSize;
+    int width, height;
+    int chunksX, chunksY;
+    int goalCol, goalRow;
+    int offsets[8];
+    std::vector<uint32_t> costs;
+    std::vector<uint8_t> directions;
+
+    // estado do cálculo, reaproveitado entre chamadas
+    std::vector<uint32_t> keys;         // menor custo que chegou ao bloco pendente
+    std::vector<uint8_t> listed;        // bloco está em pendingList
+    std::vector<int> pendingList;
+    std::vector<int> batch;
+    std::vector<uint32_t> borderCosts;
+    std::vector<OpenList> open;     // um heap por thread
+    int lastChunkRuns;
+    int lastRounds;
+};
+
+// Campo de fluxo com dois buffers, recalculado fora do tick.
+//
+// request copia a máscara e calcula o campo do novo alvo no buffer de trás,
+// em uma thread própria que usa o pool; enquanto isso os agentes continuam
+// andando pelo campo atual. O buffer de trás só vira o atual em swap, que a
+// sessão chama em pontos fixos da simulação (o passo dos inimigos), esperando
+// se o cálculo ainda não acabou. Assim o campo usado em cada passo não depende
+// de quanto a thread demorou, e o replay continua determinístico. Sem pool o
+// cálculo é feito no próprio swap, com o mesmo resultado.
+class AsyncFlowField {
+public:
+    AsyncFlowField() : pool(nullptr), goalCol(-1), goalRow(-1), pending(false), busy(false), stale(false),
+                       running(false), stopping(false) {}
+
+    ~AsyncFlowField() {
+        stop();
+    }
+
+    AsyncFlowField(const AsyncFlowField&) = delete;
+    AsyncFlowField& operator=(const AsyncFlowField&) = delete;
+
+    const FlowField& current() const { return front; }
+
+    // há um cálculo pedido que ainda não passou por swap
+    bool isPending() const { return pending; }
+
+    // Começa o cálculo para (col, row) no buffer de trás. Só com !isPending().
+    void request(const WalkMask& mask, int col, int row, WorkerPool* workers) {
+        maskCopy = mask;
+        goalCol = col;
+        goalRow = row;
+        pool = workers;
+        pending = true;
+        stale = false;
+        if (!pool) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!running) {
+                running = true;
+                worker = std::thread(&AsyncFlowField::workerLoop, this);
+            }
+            busy = true;
+        }
+        wake.notify_one();
+    }
+
+    // O campo pedido passa a ser o atual. Retorna false se não havia pedido.
+    bool swap() {
+        if (!pending) return false;
+        if (pool) {
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this] { return !busy; });
+        } else {
+            back.compute(maskCopy, goalCol, goalRow, nullptr);
+        }
+        std::swap(front, back);
+        pending = false;
+        // a máscara mudou durante o cálculo: vale para este passo, mas o
+        // próximo pedido refaz o campo mesmo com o alvo igual
+        if (stale) front.invalidate();
+        return true;
+    }
+
+    // Calcula já, nesta thread, e descarta o que estava pendente.
+    void computeNow(const WalkMask& mask, int col, int row, WorkerPool* workers) {
+        wait();
+        pending = false;
+        front.compute(mask, col, row, workers);
+    }
+
+    // o mapa mudou: o campo atual e o pendente deixam de valer
+    void invalidate() {
+        front.invalidate();
+        if (pending) stale = true;
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!running) return;
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+        running = false;
+        stopping = false;
+        busy = false;
+        pending = false;
+    }
+
+private:
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return !busy; });
+    }
+
+    void workerLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [this] { return stopping || busy; });
+            if (stopping) return;
+            lock.unlock();
+            back.compute(maskCopy, goalCol, goalRow, pool);
+            lock.lock();
+            busy = false;
+            done.notify_all();
+        }
+    }
+
+    FlowField front;
+    FlowField back;
+    WalkMask maskCopy;
+    WorkerPool* pool;
+    int goalCol, goalRow;
+    bool pending;           // só na thread da sessão
+    bool busy;              // com mutex: a thread está calculando 'back'
+    bool stale;
+    bool running;
+    bool stopping;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+};
+
+#endif /* FlowField_h */
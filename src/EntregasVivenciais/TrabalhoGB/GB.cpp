@@ -7,7 +7,25 @@
 #include <sstream>
 #include <chrono>
 #include <cmath>
+#include <cstddef>
+#include <cstring>
 #include <map>
+#include <memory>
+#include <algorithm>
+#include <unordered_set>
+#include <ctime>
+#include <random>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -16,38 +34,205 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#include <stb_image.h>
+#include "DirtyTileTracker.h"
+#include "IsoProjection.h"
+#include "ShaderProgram.h"
+#include "GameSession.h"
+#include "TextureUpload.h"
+#include "AsyncLog.h"
 
-GLuint compile_shader(const char* source, GLenum type);
 void setupOpenGL();
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+void window_refresh_callback(GLFWwindow* window);
+double processCpuSeconds();
+int runPathBenchmark(const WalkMask& mask, int queries);
+int runEcsBenchmark(int entities);
+int runSpatialBenchmark(int maxEntities);
+int runPickingBenchmark(int points);
+int runSessions(const std::string& mapPath, int sessionCount, int ticks, int enemyCount);
+
+enum class MapRenderMode {
+    LOOP = 0,
+    INSTANCED,
+    CACHED
+};
+
+// layer é a camada de profundidade (IsoProjection::depth) da camada do mapa.
+// col e row são relativos à origem do buffer (uniforms mapOrigin e
+// diagonalBase): o mapa inteiro sem streaming, ou o chunk em streaming, então
+// cabem em 16 bits em um mundo de qualquer tamanho.
+struct TileInstance {
+    unsigned short col;
+    unsigned short row;
+    unsigned short tileId;
+    unsigned short layer;
+};
+
+// Sprite no desenho instanciado: ponto de apoio na tela (Transform) e o
+// clipe com o instante em que começou (Animation); o quadro, e com ele a
+// célula da spritesheet, é escolhido no vertex shader.
+struct SpriteInstance {
+    glm::vec2 position;
+    unsigned short clip;
+    unsigned short padding;
+    float startTime;
+};
 
-enum class AnimationType {
-    IDLE_FRONT = 0,
-    IDLE_LEFT,
-    IDLE_RIGHT,
-    IDLE_BACK
+// Spritesheet compartilhada por todas as entidades com o mesmo Sprite::sheet.
+// size e offset (do ponto de apoio ao canto de cima do quad) em pixels;
+// layer e depthBias entram na chave de profundidade (IsoProjection::depth)
+// junto com a diagonal do ponto de apoio.
+struct SpriteSheet {
+    unsigned int texture;
+    int cols;
+    int rows;
+    glm::vec2 size;
+    glm::vec2 offset;
+    int layer;
+    float depthBias;
+    std::vector<SpriteInstance> instances;
 };
 
-class GameCharacter;
-class MovementCommand;
+// Camadas de profundidade: o chão (camada 0 do mapa) embaixo de tudo; a
+// decoração (camada 1) fica na mesma dos sprites, ordenada pela diagonal, e
+// as sobreposições (camadas 2 em diante) acima deles.
+const int MAP_DEPTH_LAYER = 0;
+const int SPRITE_DEPTH_LAYER = 1;
+
+inline unsigned short mapLayerDepth(int layer) {
+    return static_cast<unsigned short>(std::min(layer, IsoProjection::DEPTH_LAYERS - 1));
+}
 
-class GameManager {
+// IsoProjection::depth nos shaders; depthParams = IsoProjection::depthParams()
+#define DEPTH_KEY_GLSL \
+    "uniform vec2 depthParams;\n" \
+    "float depthKey(float diagonal, float layer, float bias) {\n" \
+    "   return (layer * depthParams.x + diagonal + bias) * depthParams.y;\n" \
+    "}\n"
+
+// Bloco Clips (AnimationClips.h), no ponto de ligação 1: um vec4 por clipe
+// (quadros, fps, linha ou primeira fatia, modo de repetição) e o clipe de
+// cada id de tile, quatro por ivec4 (-1: tile sem animação). clipFrame é a
+// mesma conta da CPU, com a mesma folga CLIP_STEP_SLACK; tileSlice é a fatia
+// do tileset de um tile no 'time' do bloco Frame, que precisa vir antes na
+// fonte. Os 64 são MAX_ANIMATION_CLIPS.
+#define CLIP_UNIFORM_BINDING 1
+const int MAX_ANIMATION_CLIPS = 64;
+
+#define CLIP_UNIFORM_BLOCK \
+    "layout (std140) uniform Clips {\n" \
+    "   vec4 clips[64];\n" \
+    "   ivec4 tileClips[64];\n" \
+    "};\n" \
+    "int clipFrame(int clip, float elapsed) {\n" \
+    "   vec4 c = clips[clip];\n" \
+    "   int count = int(c.x);\n" \
+    "   if (count <= 1 || c.y <= 0.0) return 0;\n" \
+    "   int steps = max(int(floor(elapsed * c.y + " CLIP_STRINGIFY(CLIP_STEP_SLACK) ")), 0);\n" \
+    "   if (c.w == 1.0) return min(steps, count - 1);\n" \
+    "   if (c.w == 2.0) {\n" \
+    "       int period = 2 * (count - 1);\n" \
+    "       int k = steps % period;\n" \
+    "       return k < count ? k : period - k;\n" \
+    "   }\n" \
+    "   return steps % count;\n" \
+    "}\n" \
+    "float tileSlice(uint tileId) {\n" \
+    "   int clip = tileClips[tileId >> 2u][tileId & 3u];\n" \
+    "   return clip < 0 ? float(tileId) : clips[clip].z + float(clipFrame(clip, time));\n" \
+    "}\n"
+
+// Espelho do bloco Clips no layout std140.
+struct ClipUniforms {
+    glm::vec4 clips[MAX_ANIMATION_CLIPS];
+    glm::ivec4 tileClips[TileTypeIndex::TYPE_COUNT / 4];
+};
+
+// Tiles animados. O tileset tem um quadro só por tile, então os quadros de
+// água e lava são gerados no carregamento, deslocando a textura dentro do
+// losango na direção 'flow' (em u, v; ver IsoProjection), e guardados em
+// fatias depois das do tileset. Todos os tiles de um tipo trocam de quadro
+// juntos (clipe começando em 0), então o cache do mapa só é remendado nas
+// trocas e não a cada quadro.
+struct TileAnimation {
+    int tileId;
+    float fps;
+    glm::vec2 flow;
+};
+
+const int TILE_ANIMATION_FRAMES = 8;
+const TileAnimation TILE_ANIMATIONS[] = {
+    { GameSession::TILE_AGUA, 4.0f, glm::vec2(1.0f, 0.0f) },
+    { GameSession::TILE_LAVA, 2.0f, glm::vec2(0.0f, 1.0f) },
+};
+const int TILE_ANIMATION_COUNT = sizeof(TILE_ANIMATIONS) / sizeof(TILE_ANIMATIONS[0]);
+
+// arte das spritesheets, na ordem de Sprite::sheet
+const char* const SPRITE_SHEET_PATHS[] = {
+    "../assets/sprites/Slime1_Idle_full.png",
+    "../assets/sprites/enemies-spritesheet1.png",
+};
+
+// lado das fatias do tileset provisório (ver createPlaceholderTileset)
+const int PLACEHOLDER_TILE_WIDTH = 16;
+const int PLACEHOLDER_TILE_HEIGHT = 8;
+
+// Janela, entrada e desenho de uma GameSession; o estado do jogo é todo da
+// sessão, que avisa as mudanças do mapa pelo SessionListener.
+class GameManager : public SessionListener {
 private:
     static GameManager* instance;
 
     GLFWwindow* glfwWindow;
-    unsigned int shaderProgram;
+    ShaderProgram shaderProgram;
     unsigned int texture;
     unsigned int VAO, VBO;
-    GameCharacter* player_char;
+    ShaderProgram tileShaderProgram;
+    unsigned int instancedVAO, tileInstanceVBO;
+    ShaderProgram blitShaderProgram;
+    unsigned int blitVAO;
+    ShaderProgram spriteShaderProgram;
+    unsigned int spriteVAO = 0, spriteInstanceVBO = 0;
+    FrameUniformBuffer frameUniforms;
+    unsigned int clipUBO = 0;
+
+    // Clipes da sessão (mesmos índices de Animation::clip) seguidos dos
+    // clipes dos tiles, a partir de tile_clip_base; tile_clips é o clipe de
+    // cada id de tile, -1 sem animação.
+    AnimationClipTable animation_clips;
+    int tile_clip_base = 0;
+    std::vector<int> tile_clips;
+    bool scenery_animated = false;          // tiles animados fora da camada 0
+    double next_tile_frame_time = 0.0;
+
+    // localizações resolvidas uma vez na inicialização
+    GLint spriteModelLoc = -1;
+    GLint tileIdLoc = -1;
+    GLint tileSizeLoc = -1;
+    GLint mapOriginLoc = -1;
+    GLint diagonalBaseLoc = -1;
+    GLint layerRangeLoc = -1;
+    GLint spriteSizeLoc = -1;
+    GLint spriteOffsetLoc = -1;
+    GLint spriteDepthLoc = -1;
+    GLint spriteMapOriginLoc = -1;
+    GLint spriteTileSizeLoc = -1;
+    GLint spriteDepthParamsLoc = -1;
+    GLint tileDepthParamsLoc = -1;
+    GLint sheetDimsLoc = -1;
+    unsigned int mapCacheFBO, mapCacheTexture, mapCacheDepth;
+    GameSession session;
     class InputHandler* inputHandler;
 
-    const unsigned int SCR_WIDTH = 1920;
-    const unsigned int SCR_HEIGHT = 1080;
+    unsigned int SCR_WIDTH = 1920;
+    unsigned int SCR_HEIGHT = 1080;
 
+    IsoProjection iso;
+
+    // copiados da sessão depois do carregamento; não mudam mais
     int m_baseTileWidth = 0;
     int m_baseTileHeight = 0;
 
@@ -60,26 +245,72 @@ private:
 
     float GAME_SCALE = 2.0f;
 
-    std::vector<std::vector<int>> game_map;
-    std::vector<std::vector<int>> initial_game_map;
-
     int MAP_ROWS = 0;
     int MAP_COLS = 0;
-
-    int items_collected = 0;
-    int total_coins_on_map = 0;
-    bool game_over = false;
-    bool game_won = false;
-    bool game_ended_by_lava = false;
-    bool effect_applied = false;
-
-    const int TILE_MOEDA = 0;
-    const int TILE_CHAO = 1;
-    const int TILE_PAREDE = 2;
-    const int TILE_LAVA = 3;
-    const int TILE_INICIO = 4;
-    const int TILE_AGUA = 5;
-    const int TILE_VICTORY_EFFECT_TILE_ID = 6;
+    int map_layers = 1;                 // em streaming, só a camada 0
+
+    bool streaming = false;
+    int stream_radius = 2;
+    std::vector<StreamedChunk*> draw_chunks;
+    std::vector<TileInstance> chunk_instances;
+
+    std::vector<TileInstance> tile_instances;
+    std::vector<float> row_screen_x;
+    std::vector<float> row_screen_y;
+    DirtyTileTracker dirty_tiles;
+    size_t tile_instance_capacity = 0;
+
+    // cache da camada do mapa (modo CACHED)
+    int map_cache_width = 0;
+    int map_cache_height = 0;
+    bool map_cache_valid = false;
+    std::vector<int> map_cache_patches;
+    // passo de cada clipe de tile na última vez em que o cache foi desenhado
+    std::vector<long long> map_cache_tile_steps;
+    std::vector<int> changed_tile_types;
+    const size_t MAX_MAP_CACHE_PATCHES = 256;
+
+    MapRenderMode mapRenderMode = MapRenderMode::INSTANCED;
+    double stats_time_accum = 0.0;
+    double stats_map_time_accum = 0.0;
+    int stats_frame_count = 0;
+    long long stats_tiles_drawn = 0;
+    long long tiles_drawn = 0;
+    double last_render_time = 0.0;
+    double stats_cpu_start = 0.0;
+
+    // modo ocioso: o loop dorme até o próximo quadro de animação ou evento
+    bool idle_rendering = false;
+    bool needs_redraw = true;
+
+    // A sessão avança em ticks de passo fixo; aqui se acumula o tempo real
+    // e o desenho interpola entre os dois últimos estados (render_alpha).
+    double sim_speed = 1.0;
+    double sim_accumulator = 0.0;
+    float render_alpha = 1.0f;
+    long long stats_tick_count = 0;
+
+    // tempo real máximo simulado por frame; o excesso é descartado para que
+    // um frame lento não gere cada vez mais ticks de recuperação
+    const double MAX_CATCHUP_SECONDS = 0.25;
+
+    // Desenho das entidades: uma spritesheet por Sprite::sheet e um draw
+    // instanciado por spritesheet. Com mais de PARALLEL_TRANSFORM_ENTITIES
+    // entidades os Transforms são calculados no pool da sessão.
+    std::vector<SpriteSheet> sprite_sheets;
+    const size_t PARALLEL_TRANSFORM_ENTITIES = 16384;
+
+    // Texturas: os PNGs são decodificados fora da thread do GL (AssetLoader)
+    // e enviados por um PBO quando ficam prontos; até lá o desenho usa
+    // texturas provisórias, então o primeiro quadro não espera o disco. Com
+    // sync_assets (--sync-assets) tudo é carregado antes do primeiro quadro.
+    AssetLoader asset_loader;
+    PixelUploadBuffer pixel_upload;
+    int tileset_request = -1;
+    std::vector<int> sheet_requests;        // por Sprite::sheet
+    bool sync_assets = false;
+    bool first_frame_reported = false;
+    bool fatal_error = false;               // tileset que não carregou
 
     float vertices[30] = {
         0.0f, 1.0f, 0.0f,     0.0f, 1.0f,
@@ -95,13 +326,13 @@ private:
         "#version 330 core\n"
         "layout (location = 0) in vec3 aPos;\n"
         "layout (location = 1) in vec2 aTexCoord;\n"
-        "uniform mat4 projection;\n"
+        FRAME_UNIFORM_BLOCK
+        CLIP_UNIFORM_BLOCK
         "uniform mat4 model;\n"
-        "uniform vec4 spriteUVs;\n"
-        "out vec2 TexCoord;\n"
+        "uniform int tileId;\n"
+        "out vec3 TileCoord;\n"
         "void main() {\n"
-        "   TexCoord.x = mix(spriteUVs.x, spriteUVs.z, aTexCoord.x);\n"
-        "   TexCoord.y = mix(spriteUVs.y, spriteUVs.w, aTexCoord.y);\n"
+        "   TileCoord = vec3(aTexCoord, tileSlice(uint(tileId)));\n"
         "   gl_Position = projection * model * vec4(aPos, 1.0);\n"
         "}\n";
 
@@ -114,159 +345,228 @@ private:
         "   FragColor = texture(basic_texture, TexCoord);\n"
         "}\n";
 
+    const char* tileVertexShaderSource =
+        "#version 330 core\n"
+        "layout (location = 0) in vec3 aPos;\n"
+        "layout (location = 1) in vec2 aTexCoord;\n"
+        "layout (location = 2) in uvec4 aTile;\n"
+        FRAME_UNIFORM_BLOCK
+        CLIP_UNIFORM_BLOCK
+        "uniform vec2 tileSize;\n"
+        "uniform vec2 mapOrigin;\n"
+        "uniform float diagonalBase;\n"
+        "uniform ivec2 layerRange;\n"
+        DEPTH_KEY_GLSL
+        "out vec3 TileCoord;\n"
+        "void main() {\n"
+        "   TileCoord = vec3(aTexCoord, tileSlice(aTile.z));\n"
+        // MAP_EMPTY_TILE (célula vazia de uma camada de cenário) ou camada de
+        // profundidade fora de layerRange: fora do recorte
+        "   if (aTile.z == 255u || int(aTile.w) < layerRange.x || int(aTile.w) > layerRange.y) {\n"
+        "       gl_Position = vec4(2.0, 2.0, 2.0, 1.0);\n"
+        "       return;\n"
+        "   }\n"
+        "   float col = float(aTile.x);\n"
+        "   float row = float(aTile.y);\n"
+        "   vec2 iso = mapOrigin + vec2((col - row) * tileSize.x * 0.5, (col + row) * tileSize.y * 0.5);\n"
+        "   vec2 corner = iso - vec2(tileSize.x * 0.5, tileSize.y) + aPos.xy * tileSize;\n"
+        "   gl_Position = projection * vec4(corner, depthKey(diagonalBase + col + row, float(aTile.w), 0.0), 1.0);\n"
+        "}\n";
+
+    // Tiles: uma fatia do array de texturas por tile do tileset, então o
+    // filtro e os mipmaps nunca misturam tiles vizinhos do atlas.
+    const char* tileFragmentShaderSource =
+        "#version 330 core\n"
+        "in vec3 TileCoord;\n"
+        "uniform sampler2DArray basic_texture;\n"
+        "out vec4 FragColor;\n"
+        "void main(){\n"
+        "   vec4 color = texture(basic_texture, TileCoord);\n"
+        "   if (color.a < 0.5) discard;\n"
+        "   FragColor = color;\n"
+        "}\n";
+
+    // Entidades: um quad por instância no ponto de apoio já interpolado. A
+    // célula da spritesheet é (quadro do clipe no tempo do bloco Frame, linha
+    // do clipe). A diagonal (col + row, também interpolada) sai do y do ponto
+    // de apoio, pela inversa da projeção.
+    const char* spriteVertexShaderSource =
+        "#version 330 core\n"
+        "layout (location = 0) in vec3 aPos;\n"
+        "layout (location = 1) in vec2 aTexCoord;\n"
+        "layout (location = 2) in vec2 aPosition;\n"
+        "layout (location = 3) in uint aClip;\n"
+        "layout (location = 4) in float aStartTime;\n"
+        FRAME_UNIFORM_BLOCK
+        CLIP_UNIFORM_BLOCK
+        "uniform vec2 spriteSize;\n"
+        "uniform vec2 spriteOffset;\n"
+        "uniform vec2 spriteDepth;\n"
+        "uniform ivec2 sheetDims;\n"
+        "uniform vec2 mapOrigin;\n"
+        "uniform vec2 tileSize;\n"
+        DEPTH_KEY_GLSL
+        "out vec2 TexCoord;\n"
+        "void main() {\n"
+        "   vec2 corner = aPosition + spriteOffset + aPos.xy * spriteSize;\n"
+        "   int clip = int(aClip);\n"
+        "   vec2 cell = vec2(float(clipFrame(clip, time - aStartTime)), clips[clip].z);\n"
+        "   TexCoord = (cell + aTexCoord) / vec2(sheetDims);\n"
+        "   float diagonal = (aPosition.y - mapOrigin.y) / (tileSize.y * 0.5);\n"
+        "   gl_Position = projection * vec4(corner, depthKey(diagonal, spriteDepth.x, spriteDepth.y), 1.0);\n"
+        "}\n";
+
+    // sprites que se sobrepõem não podem se cobrir com o fundo transparente,
+    // que também escreveria profundidade
+    const char* cutoutFragmentShaderSource =
+        "#version 330 core\n"
+        "in vec2 TexCoord;\n"
+        "uniform sampler2D basic_texture;\n"
+        "out vec4 FragColor;\n"
+        "void main(){\n"
+        "   vec4 color = texture(basic_texture, TexCoord);\n"
+        "   if (color.a < 0.5) discard;\n"
+        "   FragColor = color;\n"
+        "}\n";
+
+    // quad de tela cheia gerado a partir de gl_VertexID (triangle strip)
+    const char* blitVertexShaderSource =
+        "#version 330 core\n"
+        "out vec2 TexCoord;\n"
+        "void main() {\n"
+        "   vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+        "   TexCoord = corner;\n"
+        "   gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);\n"
+        "}\n";
+
     GameManager();
 
     GameManager(const GameManager&) = delete;
     GameManager& operator=(const GameManager&) = delete;
 
-    bool loadTexture(const char* path);
-    bool loadMapConfig(const std::string& filename);
+    void requestTextures();
+    void createPlaceholderTexture(unsigned int& target);
+    void createPlaceholderTileset(int cols, int rows, unsigned int& target);
+    void uploadTexture(const DecodedImage& image, unsigned int target);
+    bool uploadTileset(const DecodedImage& image, int cols, int rows, unsigned int target);
+    void integrateTexture(const DecodedImage& image);
+    void failStartup(const char* reason);
+    void pumpTextureUploads();
+    void setupAnimationClips();
+    bool hasAnimatedTiles() const;
+    double secondsToNextTileFrame(double now) const;
+    void queueAnimatedTilePatches();
+    void uploadChunk(StreamedChunk& chunk);
+    void renderMapStreaming();
+    bool buildShaders();
+    void buildTileInstances();
+    void setupInstancedMap();
+    void flushDirtyTiles();
+    void rebuildProjection();
     void renderMap();
+    void renderMapLoop();
+    void renderMapInstanced(int firstDepthLayer = MAP_DEPTH_LAYER, int lastDepthLayer = IsoProjection::DEPTH_LAYERS - 1);
+    void renderMapCached();
+    bool ensureMapCache();
+    void patchMapCache();
+    void drawSingleTile(int r, int c);
+    void invalidateMapCache();
+    void reportFrameStats(double frameTime, double mapTime);
+    void setupSpriteRendering();
+    void renderEntities();
+    bool loadWorld(const std::string& mapPath);
+    bool chunkVisible(const StreamedChunk& chunk) const;
 
 public:
     static GameManager* getInstance();
 
     ~GameManager();
 
-    void initialize(GLFWwindow* window);
+    void initialize(GLFWwindow* window, const std::string& mapPath);
+    bool initializeHeadless(const std::string& mapPath);
+    void enableStreaming(size_t budgetBytes);
     void update(float deltaTime);
     void render();
-    void resetGame();
 
-    void handleKeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
-    void processPlayerMovement(int new_row, int new_col);
+    void queueCommand(CommandId command, uint32_t arg = 0) { session.queueCommand(command, arg); }
+    void setSimulationRate(double ticksPerSecond);
+    void setSimulationStep(double seconds) { session.setSimulationStep(seconds); }
+    void setSimulationSpeed(double speed);
+    void setSyncAssets(bool enabled) { sync_assets = enabled; }
+    long long getSimulationTick() const { return session.getSimulationTick(); }
+
+    bool startRecording(const std::string& path, const std::string& mapPath) { return session.startRecording(path, mapPath); }
+    void finishRecording() { session.finishRecording(); }
+    int runReplay(InputReplay& replay) { return session.runReplay(replay); }
+    uint64_t stateHash() const { return session.stateHash(); }
 
-    static glm::vec2 gridToIsometric(int col, int row);
+    void handleKeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+    void handleMouseButton(GLFWwindow* window, int button, int action, int mods);
+    void toggleMapRenderMode();
+
+    // SessionListener
+    void onTileChanged(int r, int c) override;
+    void onMapReplaced() override;
+    void onPlayerMoved() override;
+    void onChunkLoaded(StreamedChunk& chunk) override;
+    void onChunkEvicted(StreamedChunk& chunk) override;
+    void onFramebufferResize(int width, int height);
+
+    void setIdleRendering(bool enabled);
+    bool isIdleRendering() const { return idle_rendering; }
+    bool needsRedraw() const { return needs_redraw; }
+    bool hasFailed() const { return fatal_error; }
+    void requestRedraw() { needs_redraw = true; }
+    double secondsUntilNextUpdate() const;
 
     int getTileWidth() const { return TILE_WIDTH_SCALED; } 
     int getTileHeight() const { return TILE_HEIGHT_SCALED; }
     int getMapRows() const { return MAP_ROWS; }
     int getMapCols() const { return MAP_COLS; }
-    int getTileId(int r, int c) const;
-    void setPlayerAnimation(AnimationType type);
-    bool isGameOver() const { return game_over; }
-    bool hasGameWon() const { return game_won; }
-};
-
-class GameCharacter {
-public:
-    int row;
-    int col;
-
-    GameCharacter(
-        unsigned int sharedShaderProgram,
-        const std::string& texturePath,
-        float spriteDisplayWidth,
-        float spriteDisplayHeight,
-        int totalRows,
-        int totalCols
-    );
-
-    ~GameCharacter();
-
-    void update(float deltaTime);
-    void setGridPosition(int r, int c);
-    void draw(const glm::mat4& projection, glm::vec2 (*gridToIsometricFunc)(int, int));
-    void setAnimationFPS(float fps);
-    void setAnimationType(AnimationType type);
-    AnimationType getAnimationType() const;
-
-private:
-    GLuint VAO, VBO, EBO;
-    GLuint textureID;
-    unsigned int shaderProgram;
-
-    glm::vec2 displayScale;
-    float rotation;
-
-    int totalAnimationRows;
-    int totalAnimationCols;
-    int currentFrame;
-    double lastFrameTime;
-    float animationFPS;
-    glm::vec4 currentFrameUVs;
-
-    AnimationType currentAnimationType;
-
-    bool loadTexture(const char* file_name, GLuint* tex_id);
-    void setupMesh();
-    void calculateCurrentFrameUVs();
-};
-
-class MovementCommand {
-public:
-    virtual void execute(GameCharacter* character) = 0;
-    virtual ~MovementCommand() {}
-};
-
-class MoveUpCommand : public MovementCommand {
-public:
-    void execute(GameCharacter* character) override;
-};
-
-class MoveDownCommand : public MovementCommand {
-public:
-    void execute(GameCharacter* character) override;
-};
-
-class MoveLeftCommand : public MovementCommand {
-public:
-    void execute(GameCharacter* character) override;
-};
-
-class MoveRightCommand : public MovementCommand {
-public:
-    void execute(GameCharacter* character) override;
-};
-
-class MoveUpLeftCommand : public MovementCommand {
-public:
-    void execute(GameCharacter* character) override;
-};
-
-class MoveUpRightCommand : public MovementCommand {
-public:
-    void execute(GameCharacter* character) override;
-};
-
-class MoveDownLeftCommand : public MovementCommand {
-public:
-    void execute(GameCharacter* character) override;
-};
-
-class MoveDownRightCommand : public MovementCommand {
-public:
-    void execute(GameCharacter* character) override;
-};
-
-class ResetGameCommand : public MovementCommand {
-public:
-    void execute(GameCharacter* character) override;
+    const IsoProjection& getProjection() const { return iso; }
+    const WalkMask& getWalkMask() const { return session.getWalkMask(); }
+    bool isGameOver() const { return session.isGameOver(); }
+    bool hasGameWon() const { return session.hasGameWon(); }
 };
 
+// Teclas da janela para os comandos da sessão.
 class InputHandler {
 public:
     InputHandler();
-    ~InputHandler();
-    void handleInput(GLFWwindow* window, int key, int scancode, int action, int mods, GameCharacter* player_char);
+    void handleInput(GLFWwindow* window, int key, int scancode, int action, int mods);
 
 private:
-    std::map<int, MovementCommand*> commandMap;
+    std::map<int, CommandId> commandMap;
 };
 
 GameManager* GameManager::instance = nullptr;
 
-GameManager::GameManager() : glfwWindow(nullptr), shaderProgram(0), texture(0), VAO(0), VBO(0), player_char(nullptr), inputHandler(nullptr) {}
+GameManager::GameManager() : glfwWindow(nullptr), texture(0), VAO(0), VBO(0), instancedVAO(0), tileInstanceVBO(0), blitVAO(0), mapCacheFBO(0), mapCacheTexture(0), mapCacheDepth(0), inputHandler(nullptr) {}
 
 GameManager::~GameManager() {
-    delete player_char;
-    player_char = nullptr;
+    asset_loader.stop();
     delete inputHandler;
     inputHandler = nullptr;
-    glDeleteProgram(shaderProgram);
+    if (blitVAO != 0) glDeleteVertexArrays(1, &blitVAO);
+    if (mapCacheFBO != 0) glDeleteFramebuffers(1, &mapCacheFBO);
+    if (mapCacheTexture != 0) glDeleteTextures(1, &mapCacheTexture);
+    if (mapCacheDepth != 0) glDeleteRenderbuffers(1, &mapCacheDepth);
     if (VAO != 0) glDeleteVertexArrays(1, &VAO);
     if (VBO != 0) glDeleteBuffers(1, &VBO);
+    session.getStreamer().stop();
+    session.getStreamer().forEachResident([](StreamedChunk& chunk) {
+        if (chunk.gpuBuffer != 0) glDeleteBuffers(1, &chunk.gpuBuffer);
+    });
+    if (instancedVAO != 0) glDeleteVertexArrays(1, &instancedVAO);
+    if (tileInstanceVBO != 0) glDeleteBuffers(1, &tileInstanceVBO);
     if (texture != 0) glDeleteTextures(1, &texture);
+    if (spriteVAO != 0) glDeleteVertexArrays(1, &spriteVAO);
+    if (spriteInstanceVBO != 0) glDeleteBuffers(1, &spriteInstanceVBO);
+    if (clipUBO != 0) glDeleteBuffers(1, &clipUBO);
+    pixel_upload.release();
+    for (const SpriteSheet& sheet : sprite_sheets) {
+        if (sheet.texture != 0) glDeleteTextures(1, &sheet.texture);
+    }
 }
 
 GameManager* GameManager::getInstance() {
@@ -276,343 +576,726 @@ GameManager* GameManager::getInstance() {
     return instance;
 }
 
-void GameManager::initialize(GLFWwindow* window) {
+void GameManager::initialize(GLFWwindow* window, const std::string& mapPath) {
     glfwWindow = window;
 
-    if (!loadMapConfig("map.txt")) {
-        std::cerr << "Erro ao carregar mapa inicial!" << std::endl;
+    if (!loadWorld(mapPath)) {
+        LOG_ERROR("Erro ao carregar mapa inicial!");
         return;
     }
+    // a decodificação começa já, em paralelo com os shaders e os buffers
+    requestTextures();
 
-    TILE_WIDTH_SCALED = static_cast<int>(m_baseTileWidth * GAME_SCALE);
-    TILE_HEIGHT_SCALED = static_cast<int>(m_baseTileHeight * GAME_SCALE);
-
-    total_coins_on_map = 0;
-    int initial_player_row = -1;
-    int initial_player_col = -1;
+    setupOpenGL();
 
-    for (int r = 0; r < MAP_ROWS; ++r) {
-        for (int c = 0; c < MAP_COLS; ++c) {
-            if (game_map[r][c] == TILE_MOEDA) {
-                total_coins_on_map++;
-            }
-            if (game_map[r][c] == TILE_INICIO) {
-                if (initial_player_row == -1) {
-                    initial_player_row = r;
-                    initial_player_col = c;
-                }
-            }
-        }
+    if (!buildShaders()) {
+        LOG_ERROR("Falha ao compilar os shaders!");
+        return;
     }
-    std::cout << "Total de moedas no mapa: " << total_coins_on_map << std::endl;
-
-    setupOpenGL();
 
-    GLuint vertShader = compile_shader(vertexShaderSource, GL_VERTEX_SHADER);
-    GLuint fragShader = compile_shader(fragmentShaderSource, GL_FRAGMENT_SHADER);
+    createPlaceholderTileset(TILESET_COLS, TILESET_ROWS, texture);
+    setupAnimationClips();
 
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, fragShader);
-    glAttachShader(shaderProgram, vertShader);
-    glLinkProgram(shaderProgram);
+    setupInstancedMap();
+    setupSpriteRendering();
 
-    int success;
-    char infoLog[512];
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    if (sync_assets) {
+        DecodedImage image;
+        while (!fatal_error && asset_loader.wait(image)) integrateTexture(image);
+        if (fatal_error) return;
     }
 
-    glDeleteShader(vertShader);
-    glDeleteShader(fragShader);
+    inputHandler = new InputHandler();
 
-    if (!loadTexture(TILESET_PATH.c_str())) {
-        std::cerr << "Falha ao carregar textura do tileset!" << std::endl;
-        return;
-    }
+    LOG_INFO("Controles: W/S/A/D para mover, Q/E/Z/C para diagonais, clique esquerdo para andar até um tile, ESC para sair. R para resetar. N mostra a moeda mais proxima. F1 alterna o renderizador do mapa (loop / instanciado / cache), F2 o modo ocioso.");
+}
 
-    player_char = new GameCharacter(shaderProgram,
-                                    "../assets/sprites/Slime1_Idle_full.png",
-                                    (float)TILE_WIDTH_SCALED, (float)TILE_HEIGHT_SCALED * 2.0f,
-                                    4, 6);
-    if (initial_player_row != -1 && initial_player_col != -1) {
-        player_char->setGridPosition(initial_player_row, initial_player_col);
-    } else {
-        std::cerr << "Nenhum tile de inicio (ID " << TILE_INICIO << ") encontrado no mapa. Personagem iniciado em (0,0)." << std::endl;
-        player_char->setGridPosition(0, 0);
+// Sem GL: só a sessão, para o replay.
+bool GameManager::initializeHeadless(const std::string& mapPath) {
+    if (streaming) {
+        LOG_ERROR("Modo sem janela com --stream nao e suportado: o carregamento assincrono dos chunks nao e deterministico.");
+        return false;
+    }
+    if (!session.initialize(mapPath)) {
+        LOG_ERROR("Erro ao carregar mapa inicial!");
+        return false;
     }
-    player_char->setAnimationFPS(10.0f);
+    return true;
+}
 
-    inputHandler = new InputHandler();
+// Parte da inicialização que não depende de GL: a sessão carrega o mapa e
+// posiciona o jogador, e o desenho copia o que precisa dela.
+bool GameManager::loadWorld(const std::string& mapPath) {
+    session.setListener(this);
+    if (!session.initialize(mapPath)) return false;
+
+    const TilesetInfo& tileset = session.getTileset();
+    m_baseTileWidth = tileset.tileWidth;
+    m_baseTileHeight = tileset.tileHeight;
+    TILESET_COLS = tileset.cols;
+    TILESET_ROWS = tileset.rows;
+    TILESET_PATH = tileset.path;
+    MAP_ROWS = session.getMapRows();
+    MAP_COLS = session.getMapCols();
+    map_layers = session.getLayerCount();
 
-    std::cout << "Controles: W/S/A/D para mover, Q/E/Z/C para diagonais, ESC para sair. R para resetar." << std::endl;
+    TILE_WIDTH_SCALED = static_cast<int>(m_baseTileWidth * GAME_SCALE);
+    TILE_HEIGHT_SCALED = static_cast<int>(m_baseTileHeight * GAME_SCALE);
+    if (!streaming && (MAP_ROWS > 0xFFFF || MAP_COLS > 0xFFFF)) {
+        LOG_ERROR("Mapa %dx%d grande demais para ser carregado inteiro; use --stream", MAP_COLS, MAP_ROWS);
+        return false;
+    }
+    if (!streaming) buildTileInstances();
+    rebuildProjection();
+    return true;
 }
 
-void GameManager::update(float deltaTime) {
-    if (player_char) {
-        player_char->update(deltaTime);
+bool GameManager::buildShaders() {
+    if (!shaderProgram.build(vertexShaderSource, tileFragmentShaderSource) ||
+        !tileShaderProgram.build(tileVertexShaderSource, tileFragmentShaderSource) ||
+        !blitShaderProgram.build(blitVertexShaderSource, fragmentShaderSource) ||
+        !spriteShaderProgram.build(spriteVertexShaderSource, cutoutFragmentShaderSource)) {
+        return false;
     }
-}
 
-void GameManager::render() {
-    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    spriteModelLoc = shaderProgram.location("model");
+    tileIdLoc = shaderProgram.location("tileId");
+    tileSizeLoc = tileShaderProgram.location("tileSize");
+    mapOriginLoc = tileShaderProgram.location("mapOrigin");
+    diagonalBaseLoc = tileShaderProgram.location("diagonalBase");
+    layerRangeLoc = tileShaderProgram.location("layerRange");
+    tileDepthParamsLoc = tileShaderProgram.location("depthParams");
+    spriteSizeLoc = spriteShaderProgram.location("spriteSize");
+    spriteOffsetLoc = spriteShaderProgram.location("spriteOffset");
+    spriteDepthLoc = spriteShaderProgram.location("spriteDepth");
+    sheetDimsLoc = spriteShaderProgram.location("sheetDims");
+    spriteMapOriginLoc = spriteShaderProgram.location("mapOrigin");
+    spriteTileSizeLoc = spriteShaderProgram.location("tileSize");
+    spriteDepthParamsLoc = spriteShaderProgram.location("depthParams");
+
+    // todos os programas amostram a unidade 0; isso não muda mais
+    shaderProgram.use();
+    ShaderProgram::set(shaderProgram.location("basic_texture"), 0);
+    tileShaderProgram.use();
+    ShaderProgram::set(tileShaderProgram.location("basic_texture"), 0);
+    blitShaderProgram.use();
+    ShaderProgram::set(blitShaderProgram.location("basic_texture"), 0);
+    spriteShaderProgram.use();
+    ShaderProgram::set(spriteShaderProgram.location("basic_texture"), 0);
+    glUseProgram(0);
+
+    // o bloco Frame o ShaderProgram liga sozinho; o Clips é só deste jogo
+    const ShaderProgram* clipPrograms[] = { &shaderProgram, &tileShaderProgram, &spriteShaderProgram };
+    for (const ShaderProgram* program : clipPrograms) {
+        GLuint blockIndex = glGetUniformBlockIndex(program->getId(), "Clips");
+        if (blockIndex != GL_INVALID_INDEX) glUniformBlockBinding(program->getId(), blockIndex, CLIP_UNIFORM_BINDING);
+    }
+    return true;
+}
 
-    glUseProgram(shaderProgram);
+// Tabela de clipes que vai para o bloco Clips: os da sessão, nos mesmos
+// índices, e um por tile animado, apontando para as fatias geradas em
+// loadTilesetArray. Enviada uma vez; nada de animação muda por quadro.
+void GameManager::setupAnimationClips() {
+    animation_clips = session.getAnimationClips();
+    tile_clip_base = animation_clips.size();
+    tile_clips.assign(TileTypeIndex::TYPE_COUNT, -1);
+    const int tilesetSlices = TILESET_COLS * TILESET_ROWS;
+    for (int i = 0; i < TILE_ANIMATION_COUNT; ++i) {
+        const TileAnimation& animation = TILE_ANIMATIONS[i];
+        tile_clips[animation.tileId] = animation_clips.add({ TILE_ANIMATION_FRAMES, animation.fps,
+                                                             tilesetSlices + i * TILE_ANIMATION_FRAMES, AnimationLoop::LOOP });
+    }
+    if (animation_clips.size() > MAX_ANIMATION_CLIPS) {
+        LOG_WARN("%d clipes de animacao; so os %d primeiros cabem no bloco Clips.", animation_clips.size(), MAX_ANIMATION_CLIPS);
+    }
 
-    if (game_won && !effect_applied) {
-        for (int r = 0; r < MAP_ROWS; ++r) {
-            for (int c = 0; c < MAP_COLS; ++c) {
-                game_map[r][c] = TILE_VICTORY_EFFECT_TILE_ID;
-            }
-        }
-        effect_applied = true;
-    } else if (game_over && game_ended_by_lava && !effect_applied) {
-        for (int r = 0; r < MAP_ROWS; ++r) {
+    ClipUniforms data = {};
+    for (int i = 0; i < std::min(animation_clips.size(), MAX_ANIMATION_CLIPS); ++i) {
+        const AnimationClip& clip = animation_clips.get(i);
+        data.clips[i] = glm::vec4((float)clip.frameCount, clip.fps, (float)clip.row, (float)static_cast<int>(clip.loop));
+    }
+    for (int id = 0; id < TileTypeIndex::TYPE_COUNT; ++id) {
+        data.tileClips[id / 4][id % 4] = tile_clips[id] < MAX_ANIMATION_CLIPS ? tile_clips[id] : -1;
+    }
+    glGenBuffers(1, &clipUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, clipUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(ClipUniforms), &data, GL_STATIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, CLIP_UNIFORM_BINDING, clipUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    scenery_animated = false;
+    for (int layer = 1; layer < map_layers && !scenery_animated; ++layer) {
+        const TileGrid& grid = session.getLayer(layer);
+        for (int r = 0; r < MAP_ROWS && !scenery_animated; ++r) {
+            const TileId* row = grid.rowData(r);
             for (int c = 0; c < MAP_COLS; ++c) {
-                game_map[r][c] = TILE_LAVA;
+                if (row[c] != MAP_EMPTY_TILE && tile_clips[row[c]] >= 0) {
+                    scenery_animated = true;
+                    break;
+                }
             }
         }
-        effect_applied = true;
     }
+    map_cache_tile_steps.assign(TILE_ANIMATION_COUNT, -1);
+    next_tile_frame_time = 0.0;
+}
 
-    renderMap();
+// Algum tile animado no mapa? Em streaming não se sabe, então sim.
+bool GameManager::hasAnimatedTiles() const {
+    if (streaming || scenery_animated) return true;
+    for (int i = 0; i < TILE_ANIMATION_COUNT; ++i) {
+        if (session.getTileIndex().count(static_cast<TileId>(TILE_ANIMATIONS[i].tileId)) > 0) return true;
+    }
+    return false;
+}
 
-    if (player_char) {
-        glm::mat4 projection = glm::ortho(0.0f, (float)SCR_WIDTH, (float)SCR_HEIGHT, 0.0f, -1.0f, 1.0f);
-        player_char->draw(projection, &GameManager::gridToIsometric);
+double GameManager::secondsToNextTileFrame(double now) const {
+    double seconds = 1e9;
+    for (int i = 0; i < TILE_ANIMATION_COUNT; ++i) {
+        seconds = std::min(seconds, secondsToNextClipFrame(animation_clips.get(tile_clip_base + i), now, 1e9));
     }
+    return seconds;
+}
 
-    glfwSwapBuffers(glfwWindow);
+// Acumula o tempo real (escalado por sim_speed) e executa quantos ticks de
+// passo fixo couberem; o resto fica para o próximo frame e vira o fator de
+// interpolação do desenho.
+void GameManager::update(float deltaTime) {
+    double frameTime = std::min((double)deltaTime, MAX_CATCHUP_SECONDS);
+    const double step = session.getSimulationStep();
+    sim_accumulator += frameTime * sim_speed;
+    while (sim_accumulator >= step) {
+        session.tick();
+        sim_accumulator -= step;
+        stats_tick_count++;
+    }
+    if (session.takeChanged()) needs_redraw = true;
+    if (asset_loader.hasReady()) needs_redraw = true;
+    render_alpha = static_cast<float>(sim_accumulator / step);
+
+    // os tiles animados trocam de quadro sozinhos no shader; aqui só se
+    // avisa o modo ocioso de que é hora de redesenhar
+    const double now = session.simTime() + sim_accumulator;
+    if (!tile_clips.empty() && now >= next_tile_frame_time) {
+        if (hasAnimatedTiles()) needs_redraw = true;
+        next_tile_frame_time = now + secondsToNextTileFrame(now);
+    }
 }
 
-void GameManager::resetGame() {
-    items_collected = 0;
-    game_over = false;
-    game_won = false;
-    game_ended_by_lava = false;
-    effect_applied = false;
+void GameManager::setSimulationRate(double ticksPerSecond) {
+    if (ticksPerSecond > 0.0) session.setSimulationStep(1.0 / ticksPerSecond);
+}
 
-    if (!loadMapConfig("map.txt")) {
-        std::cerr << "Erro ao recarregar o mapa durante o reset!" << std::endl;
-        return;
-    }
+void GameManager::setSimulationSpeed(double speed) {
+    if (speed > 0.0) sim_speed = speed;
+}
 
-    TILE_WIDTH_SCALED = static_cast<int>(m_baseTileWidth * GAME_SCALE);
-    TILE_HEIGHT_SCALED = static_cast<int>(m_baseTileHeight * GAME_SCALE);
+void GameManager::setIdleRendering(bool enabled) {
+    idle_rendering = enabled;
+    needs_redraw = true;
+    last_render_time = 0.0;
+    stats_time_accum = 0.0;
+    stats_map_time_accum = 0.0;
+    stats_tiles_drawn = 0;
+    stats_frame_count = 0;
+    stats_tick_count = 0;
+    stats_cpu_start = processCpuSeconds();
+}
 
-    total_coins_on_map = 0;
-    int initial_player_row = -1;
-    int initial_player_col = -1;
+// Tempo real que o loop pode dormir: até a próxima mudança da sessão sem
+// entrada nova (GameSession::secondsToNextChange), até a próxima troca de
+// quadro dos tiles animados, ou pouco enquanto houver chunks a caminho, que
+// precisam ser integrados.
+double GameManager::secondsUntilNextUpdate() const {
+    if (needs_redraw) return 0.0;
+    double simSeconds = std::max(0.0, session.secondsToNextChange() - sim_accumulator);
+    if (!tile_clips.empty() && hasAnimatedTiles()) {
+        simSeconds = std::min(simSeconds, std::max(0.0, next_tile_frame_time - (session.simTime() + sim_accumulator)));
+    }
+    double seconds = simSeconds / sim_speed;
+    if (streaming && session.getStreamer().hasPendingLoads()) {
+        seconds = std::min(seconds, 0.01);
+    }
+    return seconds;
+}
 
-    for (int r = 0; r < MAP_ROWS; ++r) {
-        for (int c = 0; c < MAP_COLS; ++c) {
-            if (game_map[r][c] == TILE_MOEDA) {
-                total_coins_on_map++;
-            }
-            if (game_map[r][c] == TILE_INICIO) {
-                if (initial_player_row == -1) {
-                    initial_player_row = r;
-                    initial_player_col = c;
-                }
-            }
-        }
+void GameManager::rebuildProjection() {
+    if (streaming) {
+        const GameCharacter* player = session.getPlayer();
+        int focusRow = player ? player->getRow() : std::max(session.getStartRow(), 0);
+        int focusCol = player ? player->getCol() : std::max(session.getStartCol(), 0);
+        invalidateMapCache();
+        iso = IsoProjection::centeredOn((float)TILE_WIDTH_SCALED, (float)TILE_HEIGHT_SCALED, MAP_ROWS, MAP_COLS,
+                                        focusCol, focusRow, (float)SCR_WIDTH, (float)SCR_HEIGHT);
+
+        // tiles a partir do centro até a borda da tela, em cada eixo da grade,
+        // mais um anel de chunks para pré-carregar antes de o jogador chegar
+        float reach = (SCR_WIDTH / 2.0f) / (TILE_WIDTH_SCALED / 2.0f) + (SCR_HEIGHT / 2.0f) / (TILE_HEIGHT_SCALED / 2.0f);
+        stream_radius = static_cast<int>(std::ceil(reach / session.getStreamer().getChunkSize())) + 1;
+        session.setStreamRadius(stream_radius);
+        return;
     }
-    std::cout << "Total de moedas no mapa (reset): " << total_coins_on_map << std::endl;
+    invalidateMapCache();
+    iso = IsoProjection((float)TILE_WIDTH_SCALED, (float)TILE_HEIGHT_SCALED, MAP_ROWS, MAP_COLS, (float)SCR_WIDTH, (float)SCR_HEIGHT);
+    row_screen_x.resize(MAP_COLS);
+    row_screen_y.resize(MAP_COLS);
+}
 
-    if (player_char) {
-        if (initial_player_row != -1 && initial_player_col != -1) {
-            player_char->setGridPosition(initial_player_row, initial_player_col);
-        } else {
-            player_char->setGridPosition(0, 0);
-        }
-        player_char->setAnimationType(AnimationType::IDLE_FRONT);
+void GameManager::onFramebufferResize(int width, int height) {
+    if (width <= 0 || height <= 0) return;
+    SCR_WIDTH = static_cast<unsigned int>(width);
+    SCR_HEIGHT = static_cast<unsigned int>(height);
+    rebuildProjection();
+    needs_redraw = true;
+}
+
+void GameManager::toggleMapRenderMode() {
+    if (mapRenderMode == MapRenderMode::LOOP) {
+        mapRenderMode = MapRenderMode::INSTANCED;
+        LOG_INFO("Renderizador do mapa: instanciado (1 draw call)");
+    } else if (mapRenderMode == MapRenderMode::INSTANCED) {
+        mapRenderMode = MapRenderMode::CACHED;
+        invalidateMapCache();
+        LOG_INFO("Renderizador do mapa: cache em framebuffer (1 blit por quadro)");
+    } else {
+        mapRenderMode = MapRenderMode::LOOP;
+        LOG_INFO("Renderizador do mapa: loop por tile");
     }
-    std::cout << "Jogo resetado!" << std::endl;
+    stats_time_accum = 0.0;
+    stats_map_time_accum = 0.0;
+    stats_tiles_drawn = 0;
+    stats_frame_count = 0;
+    stats_tick_count = 0;
+    stats_cpu_start = processCpuSeconds();
 }
 
-void GameManager::handleKeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
-    if (inputHandler && player_char) {
-        inputHandler->handleInput(window, key, scancode, action, mods, player_char);
+void GameManager::reportFrameStats(double frameTime, double mapTime) {
+    stats_time_accum += frameTime;
+    stats_map_time_accum += mapTime;
+    stats_tiles_drawn += tiles_drawn;
+    stats_frame_count++;
+
+    if (stats_time_accum >= 2.0) {
+        const char* modeName = mapRenderMode == MapRenderMode::LOOP ? "loop"
+                             : mapRenderMode == MapRenderMode::INSTANCED ? "instanciado" : "cache";
+        double cpuSeconds = processCpuSeconds();
+        LOG_INFO("[%s, %s] %dx%d frame: %g ms, renderMap (CPU): %g ms, %g fps, %g ticks/s, tiles desenhados: %lld de %lld, CPU: %g%%",
+                 modeName, idle_rendering ? "ocioso" : "continuo", MAP_ROWS, MAP_COLS,
+                 stats_time_accum * 1000.0 / stats_frame_count, stats_map_time_accum * 1000.0 / stats_frame_count,
+                 stats_frame_count / stats_time_accum, stats_tick_count / stats_time_accum,
+                 stats_tiles_drawn / stats_frame_count, (long long)MAP_ROWS * MAP_COLS * map_layers,
+                 100.0 * (cpuSeconds - stats_cpu_start) / stats_time_accum);
+        stats_time_accum = 0.0;
+        stats_map_time_accum = 0.0;
+        stats_tiles_drawn = 0;
+        stats_frame_count = 0;
+        stats_tick_count = 0;
+        stats_cpu_start = cpuSeconds;
     }
 }
 
-void GameManager::processPlayerMovement(int new_row, int new_col) {
-    if (player_char) {
-        if (new_row >= 0 && new_row < MAP_ROWS && new_col >= 0 && new_col < MAP_COLS) {
-            int target_tile_id = game_map[new_row][new_col];
+void GameManager::render() {
+    pumpTextureUploads();
 
-            if (target_tile_id == TILE_PAREDE) {
-                std::cout << "Tile (" << new_col << ", " << new_row << ") não é caminhável (Parede)." << std::endl;
-                return;
-            }
-            if (target_tile_id == TILE_AGUA) {
-                std::cout << "Tile (" << new_col << ", " << new_row << ") não é caminhável (Água)." << std::endl;
-                return;
-            }
-            if (target_tile_id == TILE_LAVA) {
-                game_over = true;
-                game_ended_by_lava = true;
-                std::cout << "Você morreu na lava! Fim de jogo." << std::endl;
-                return;
-            }
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-            player_char->setGridPosition(new_row, new_col);
-            std::cout << "Player movido para (" << player_char->col << ", " << player_char->row << ")" << std::endl;
+    glm::mat4 projection = glm::ortho(0.0f, (float)SCR_WIDTH, (float)SCR_HEIGHT, 0.0f, -1.0f, 1.0f);
+    // tempo da simulação (não do relógio), interpolado como o resto do desenho
+    float simTime = static_cast<float>((session.getSimulationTick() + render_alpha) * session.getSimulationStep());
+    frameUniforms.update(projection, (float)SCR_WIDTH, (float)SCR_HEIGHT, simTime);
 
-            if (target_tile_id == TILE_MOEDA) {
-                items_collected++;
-                game_map[player_char->row][player_char->col] = TILE_CHAO;
-                std::cout << "Moeda coletada! Total: " << items_collected << std::endl;
+    auto mapStart = std::chrono::high_resolution_clock::now();
+    renderMap();
+    double mapTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - mapStart).count();
+    renderEntities();
 
-                if (items_collected == total_coins_on_map) {
-                    game_won = true;
-                    std::cout << "Parabens! Voce coletou todas as moedas e venceu o jogo!" << std::endl;
-                }
-            }
-        }
+    glfwSwapBuffers(glfwWindow);
+    needs_redraw = false;
+    if (!first_frame_reported) {
+        first_frame_reported = true;
+        LOG_INFO("Primeiro quadro %.1f ms depois do glfwInit (%d textura(s) ainda carregando)", glfwGetTime() * 1000.0,
+                 asset_loader.pendingCount());
+    }
+
+    double now = glfwGetTime();
+    if (last_render_time > 0.0) {
+        reportFrameStats(now - last_render_time, mapTime);
     }
+    last_render_time = now;
 }
 
-int GameManager::getTileId(int r, int c) const {
-    if (r >= 0 && r < MAP_ROWS && c >= 0 && c < MAP_COLS) {
-        return game_map[r][c];
+void GameManager::handleKeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    needs_redraw = true;
+    if (key == GLFW_KEY_F1 && action == GLFW_PRESS) {
+        toggleMapRenderMode();
+        return;
+    }
+    if (key == GLFW_KEY_N && action == GLFW_PRESS) {
+        session.reportNearestCoin();
+        return;
+    }
+    if (key == GLFW_KEY_F2 && action == GLFW_PRESS) {
+        setIdleRendering(!idle_rendering);
+        LOG_INFO("Loop principal: %s", idle_rendering ? "ocioso (redesenha sob demanda)" : "continuo");
+        return;
+    }
+    if (inputHandler) {
+        inputHandler->handleInput(window, key, scancode, action, mods);
     }
-    return -1;
 }
 
-void GameManager::setPlayerAnimation(AnimationType type) {
-    if (player_char) {
-        player_char->setAnimationType(type);
+void GameManager::handleMouseButton(GLFWwindow* window, int button, int action, int mods) {
+    if (button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS) return;
+    if (streaming) {
+        LOG_WARN("Clique para mover nao disponivel com --stream.");
+        return;
+    }
+
+    // o cursor vem em coordenadas da janela; a projeção usa as do framebuffer
+    double x, y;
+    int windowWidth, windowHeight;
+    glfwGetCursorPos(window, &x, &y);
+    glfwGetWindowSize(window, &windowWidth, &windowHeight);
+    if (windowWidth <= 0 || windowHeight <= 0) return;
+    x *= (double)SCR_WIDTH / windowWidth;
+    y *= (double)SCR_HEIGHT / windowHeight;
+
+    int col, row;
+    if (iso.pick((int)std::floor(x), (int)std::floor(y), col, row)) {
+        queueCommand(CommandId::MOVE_TO, static_cast<uint32_t>(session.getMap().index(col, row)));
+        needs_redraw = true;
     }
 }
 
-bool GameManager::loadTexture(const char* path) {
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+// Tileset e spritesheets pedidos ao AssetLoader; os ids dizem, na chegada,
+// para qual textura vai cada imagem. onReady acorda o loop de eventos do
+// modo ocioso (glfwPostEmptyEvent pode ser chamado de qualquer thread).
+void GameManager::requestTextures() {
+    asset_loader.setOnReady([] { glfwPostEmptyEvent(); });
+    tileset_request = asset_loader.request(TILESET_PATH);
+    sheet_requests.clear();
+    for (const char* path : SPRITE_SHEET_PATHS) sheet_requests.push_back(asset_loader.request(path));
+}
+
+// Spritesheet provisória: um texel transparente, então a entidade só
+// aparece quando a arte chega.
+void GameManager::createPlaceholderTexture(unsigned int& target) {
+    glGenTextures(1, &target);
+    glBindTexture(GL_TEXTURE_2D, target);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-    int width, height, nrChannels;
-    unsigned char* data = stbi_load(path, &width, &height, &nrChannels, 0);
-    if (data) {
-        GLenum format = GL_RGB;
-        if (nrChannels == 4) format = GL_RGBA;
-        else if (nrChannels == 3) format = GL_RGB;
-        else {
-            std::cerr << "Formato de imagem nao suportado para textura: " << nrChannels << " canais." << std::endl;
-            stbi_image_free(data);
-            return false;
-        }
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        std::cout << "Textura carregada: " << path << " (Width: " << width << ", Height: " << height << ", Channels: " << nrChannels << ")" << std::endl;
-        stbi_image_free(data);
-        return true;
-    } else {
-        std::cerr << "Falha ao carregar textura: " << path << std::endl;
-        return false;
+    const unsigned char texel[4] = { 0, 0, 0, 0 };
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texel);
+}
+
+// Troca a provisória pela imagem decodificada (pelo PBO); o nome da textura
+// não muda.
+void GameManager::uploadTexture(const DecodedImage& image, unsigned int target) {
+    pixel_upload.uploadTexture2D(image, target);
+    LOG_INFO("Textura carregada: %s (Width: %d, Height: %d)", image.path.c_str(), image.width, image.height);
+}
+
+// Quadro 'frame' de um tile animado: cada pixel do losango pega a cor do
+// pixel deslocado frame / frames do losango na direção 'flow', em u, v (o
+// losango vira o quadrado [0, 1]^2, como no recorte do IsoProjection), com
+// volta nas bordas. O alfa continua o do pixel, então o contorno não muda.
+static void shiftTileFrame(const unsigned char* tile, int width, int height, glm::vec2 flow, int frame, int frames,
+                           std::vector<unsigned char>& out) {
+    out.assign(tile, tile + (size_t)width * height * 4);
+    const glm::vec2 shift = flow * ((float)frame / frames);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const float a = (x + 0.5f) / width * 2.0f - 1.0f;
+            const float b = (y + 0.5f) / height * 2.0f - 1.0f;
+            float u = (a + b + 1.0f) * 0.5f;
+            float v = (b - a + 1.0f) * 0.5f;
+            if (u < 0.0f || u > 1.0f || v < 0.0f || v > 1.0f) continue;
+            u -= shift.x;
+            v -= shift.y;
+            u -= std::floor(u);
+            v -= std::floor(v);
+            const int sx = std::min(std::max((int)((u - v + 1.0f) * 0.5f * width), 0), width - 1);
+            const int sy = std::min(std::max((int)((u + v) * 0.5f * height), 0), height - 1);
+            const unsigned char* source = tile + ((size_t)sy * width + sx) * 4;
+            if (source[3] < 128) continue;
+            unsigned char* target = &out[((size_t)y * width + x) * 4];
+            target[0] = source[0];
+            target[1] = source[1];
+            target[2] = source[2];
+        }
+    }
+}
+
+// Tileset provisório, no mesmo formato do definitivo: cada fatia é um
+// losango liso em um tom que depende do id do tile (os quadros dos tiles
+// animados repetem o do tile), então o mapa já aparece no primeiro quadro.
+void GameManager::createPlaceholderTileset(int cols, int rows, unsigned int& target) {
+    const int tilesetSlices = cols * rows;
+    const int slices = tilesetSlices + TILE_ANIMATION_COUNT * TILE_ANIMATION_FRAMES;
+    const int width = PLACEHOLDER_TILE_WIDTH, height = PLACEHOLDER_TILE_HEIGHT;
+    std::vector<unsigned char> pixels((size_t)width * height * 4 * slices, 0);
+    for (int slice = 0; slice < slices; ++slice) {
+        const int tileId = slice < tilesetSlices ? slice : TILE_ANIMATIONS[(slice - tilesetSlices) / TILE_ANIMATION_FRAMES].tileId;
+        const unsigned char shade = (unsigned char)(96 + (tileId * 37) % 128);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                const float a = (x + 0.5f) / width * 2.0f - 1.0f;
+                const float b = (y + 0.5f) / height * 2.0f - 1.0f;
+                if (std::fabs(a) + std::fabs(b) > 1.0f) continue;
+                unsigned char* texel = &pixels[(((size_t)slice * height + y) * width + x) * 4];
+                texel[0] = (unsigned char)(shade * 3 / 4);
+                texel[1] = shade;
+                texel[2] = (unsigned char)(shade * 7 / 8);
+                texel[3] = 255;
+            }
+        }
     }
+
+    glGenTextures(1, &target);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, target);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, slices, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
 }
 
-bool GameManager::loadMapConfig(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Erro ao abrir arquivo: " << filename << std::endl;
+// Tileset como GL_TEXTURE_2D_ARRAY, uma fatia por tile (fatia = id do tile).
+// Cada fatia é copiada direto da imagem, com GL_UNPACK_ROW_LENGTH pulando o
+// resto da linha do atlas. Como as bordas e os mipmaps de uma fatia não
+// enxergam as vizinhas, não há sangramento entre tiles do atlas. Depois das
+// fatias do atlas vêm os TILE_ANIMATION_FRAMES quadros de cada TILE_ANIMATIONS,
+// gerados aqui e enviados direto, já sem o PBO.
+bool GameManager::uploadTileset(const DecodedImage& image, int cols, int rows, unsigned int target) {
+    const char* path = image.path.c_str();
+    const int width = image.width, height = image.height;
+    const unsigned char* data = image.pixels.get();
+    const int tileWidth = cols > 0 ? width / cols : 0;
+    const int tileHeight = rows > 0 ? height / rows : 0;
+    if (tileWidth <= 0 || tileHeight <= 0) {
+        LOG_ERROR("Tileset %s (%dx%d) nao divide em %dx%d tiles.", path, width, height, cols, rows);
         return false;
     }
 
-    std::string line;
-    std::string temp_tileset_path;
-    int temp_tileset_cols, temp_tileset_rows, temp_tile_width, temp_tile_height;
-    int temp_map_rows, temp_map_cols;
+    // mesmo nome da provisória, que é redimensionada; os parâmetros ficam
+    glBindTexture(GL_TEXTURE_2D_ARRAY, target);
+    const int slices = cols * rows + TILE_ANIMATION_COUNT * TILE_ANIMATION_FRAMES;
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, tileWidth, tileHeight, slices, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+    pixel_upload.stage(image);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, width);
+    for (int slice = 0; slice < cols * rows; ++slice) {
+        const int x = (slice % cols) * tileWidth;
+        const int y = (slice / cols) * tileHeight;
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, slice, tileWidth, tileHeight, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                        pixel_upload.source(image, ((size_t)y * width + x) * 4));
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    pixel_upload.finish();
+
+    std::vector<unsigned char> tile((size_t)tileWidth * tileHeight * 4);
+    std::vector<unsigned char> frame;
+    for (int i = 0; i < TILE_ANIMATION_COUNT; ++i) {
+        const TileAnimation& animation = TILE_ANIMATIONS[i];
+        if (animation.tileId >= cols * rows) continue;
+        const int x = (animation.tileId % cols) * tileWidth;
+        const int y = (animation.tileId / cols) * tileHeight;
+        for (int row = 0; row < tileHeight; ++row) {
+            memcpy(&tile[(size_t)row * tileWidth * 4], data + ((size_t)(y + row) * width + x) * 4, (size_t)tileWidth * 4);
+        }
+        for (int f = 0; f < TILE_ANIMATION_FRAMES; ++f) {
+            shiftTileFrame(tile.data(), tileWidth, tileHeight, animation.flow, f, TILE_ANIMATION_FRAMES, frame);
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, cols * rows + i * TILE_ANIMATION_FRAMES + f, tileWidth, tileHeight, 1,
+                            GL_RGBA, GL_UNSIGNED_BYTE, frame.data());
+        }
+    }
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
 
-    std::getline(file, line);
-    std::istringstream iss_tileset(line);
-    std::string key_tileset;
-    iss_tileset >> key_tileset >> temp_tileset_path >> temp_tileset_cols >> temp_tileset_rows >> temp_tile_width >> temp_tile_height;
+    LOG_INFO("Tileset carregado: %s (%d fatias de %dx%d, %d de tiles animados)", path, cols * rows, tileWidth, tileHeight,
+             TILE_ANIMATION_COUNT * TILE_ANIMATION_FRAMES);
+    return true;
+}
 
-    std::getline(file, line);
-    std::istringstream iss_dim(line);
-    std::string key_dim;
-    iss_dim >> key_dim >> temp_map_rows >> temp_map_cols;
+// Imagens já decodificadas viram texturas, no começo de cada quadro.
+void GameManager::pumpTextureUploads() {
+    DecodedImage image;
+    while (asset_loader.pop(image)) integrateTexture(image);
+}
 
-    m_baseTileWidth = temp_tile_width;
-    m_baseTileHeight = temp_tile_height;
+// Sem o tileset não há mapa para desenhar: como no carregamento síncrono
+// antigo, o jogo não segue. Spritesheets que falham ficam na provisória.
+void GameManager::integrateTexture(const DecodedImage& image) {
+    needs_redraw = true;
+    if (image.id == tileset_request) {
+        if (!image.pixels || !uploadTileset(image, TILESET_COLS, TILESET_ROWS, texture)) {
+            failStartup("Falha ao carregar textura do tileset!");
+            return;
+        }
+        // o cache do mapa foi desenhado com o tileset provisório
+        invalidateMapCache();
+    } else if (image.pixels) {
+        for (size_t sheet = 0; sheet < sheet_requests.size() && sheet < sprite_sheets.size(); ++sheet) {
+            if (sheet_requests[sheet] == image.id) uploadTexture(image, sprite_sheets[sheet].texture);
+        }
+    }
+    if (asset_loader.pendingCount() == 0) {
+        LOG_INFO("Texturas carregadas %.1f ms depois do glfwInit", glfwGetTime() * 1000.0);
+    }
+}
 
-    TILESET_COLS = temp_tileset_cols;
-    TILESET_ROWS = temp_tileset_rows;
-    TILESET_PATH = temp_tileset_path;
-    MAP_ROWS = temp_map_rows;
-    MAP_COLS = temp_map_cols;
+// Fecha a janela; o loop principal termina e main retorna erro.
+void GameManager::failStartup(const char* reason) {
+    LOG_ERROR("%s", reason);
+    fatal_error = true;
+    asset_loader.stop();
+    if (glfwWindow) glfwSetWindowShouldClose(glfwWindow, true);
+}
 
-    std::getline(file, line);
+void GameManager::enableStreaming(size_t budgetBytes) {
+    streaming = true;
+    session.enableStreaming(budgetBytes, sizeof(TileInstance));
+}
 
-    game_map.clear();
-    game_map.resize(MAP_ROWS, std::vector<int>(MAP_COLS));
+// Um tile trocado na sessão: a instância dele é reenviada e o cache do mapa
+// remendado; em streaming o chunk inteiro volta a ser enviado.
+void GameManager::onTileChanged(int r, int c) {
+    if (streaming) {
+        invalidateMapCache();
+        return;
+    }
+    const int index = session.getMap().index(c, r);
+    dirty_tiles.markCell(index);
+    if (map_cache_valid) map_cache_patches.push_back(index);
+}
 
-    for (int r = 0; r < MAP_ROWS; ++r) {
-        std::string row_str;
-        if (!std::getline(file, row_str)) {
-            std::cerr << "Dados do mapa incompletos durante recarregamento." << std::endl;
-            file.close();
-            return false;
-        }
-        size_t first = row_str.find_first_not_of(" \t\n\r");
-        size_t last = row_str.find_last_not_of(" \t\n\r");
-        if (std::string::npos != first) {
-            row_str = row_str.substr(first, (last - first + 1));
-        } else {
-            row_str = "";
-        }
+void GameManager::onMapReplaced() {
+    invalidateMapCache();
+    if (!streaming) dirty_tiles.markAll();
+    needs_redraw = true;
+}
 
-        if ((int)row_str.length() != MAP_COLS) {
-            std::cerr << "Largura da linha do mapa incorreta durante recarregamento. Esperado " << MAP_COLS << ", obtido " << row_str.length() << " na linha: \"" << row_str << "\"" << std::endl;
-            file.close();
-            return false;
-        }
-        for (int c = 0; c < MAP_COLS; ++c) {
-            game_map[r][c] = row_str[c] - '0';
-        }
+// em streaming a câmera segue o jogador
+void GameManager::onPlayerMoved() {
+    if (streaming) rebuildProjection();
+}
+
+void GameManager::onChunkLoaded(StreamedChunk& chunk) {
+    chunk.gpuDirty = true;
+    invalidateMapCache();
+    needs_redraw = true;
+}
+
+void GameManager::onChunkEvicted(StreamedChunk& chunk) {
+    invalidateMapCache();
+    if (chunk.gpuBuffer != 0) {
+        glDeleteBuffers(1, &chunk.gpuBuffer);
+        chunk.gpuBuffer = 0;
     }
-    file.close();
-    std::cout << "Configuração do mapa carregada." << std::endl;
-    return true;
 }
 
-glm::vec2 GameManager::gridToIsometric(int col, int row) {
-    float isoX_raw = (col - row) * (GameManager::getInstance()->getTileWidth() / 2.0f);
-    float isoY_raw = (col + row) * (GameManager::getInstance()->getTileHeight() / 2.0f);
+void GameManager::uploadChunk(StreamedChunk& chunk) {
+    int chunkSize = session.getStreamer().getChunkSize();
+    chunk_instances.clear();
+    for (int i = 0; i < chunkSize * chunkSize; ++i) {
+        TileId tile = chunk.tiles[i];
+        if (tile == MAP_EMPTY_TILE) continue;
+        TileInstance inst;
+        inst.col = static_cast<unsigned short>(i % chunkSize);
+        inst.row = static_cast<unsigned short>(i / chunkSize);
+        inst.tileId = tile;
+        inst.layer = MAP_DEPTH_LAYER;
+        chunk_instances.push_back(inst);
+    }
 
-    float min_iso_x_map = -(GameManager::getInstance()->getMapRows() - 1) * (GameManager::getInstance()->getTileWidth() / 2.0f);
-    float max_iso_x_map = (GameManager::getInstance()->getMapCols() - 1) * (GameManager::getInstance()->getTileWidth() / 2.0f);
-    float min_iso_y_map = 0.0f;
-    float max_iso_y_map = (GameManager::getInstance()->getMapCols() + GameManager::getInstance()->getMapRows() - 2) * (GameManager::getInstance()->getTileHeight() / 2.0f) + GameManager::getInstance()->getTileHeight();
+    if (chunk.gpuBuffer == 0) {
+        glGenBuffers(1, &chunk.gpuBuffer);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, chunk.gpuBuffer);
+    glBufferData(GL_ARRAY_BUFFER, chunk_instances.size() * sizeof(TileInstance), chunk_instances.data(), GL_DYNAMIC_DRAW);
+    chunk.gpuInstanceCount = static_cast<int>(chunk_instances.size());
+    chunk.gpuDirty = false;
+}
 
-    float map_visual_width = max_iso_x_map - min_iso_x_map;
-    float map_visual_height = max_iso_y_map - min_iso_y_map;
+void GameManager::renderMapStreaming() {
+    tileShaderProgram.use();
+    glBindVertexArray(instancedVAO);
 
-    float map_center_x = min_iso_x_map + map_visual_width / 2.0f;
-    float map_center_y = min_iso_y_map + map_visual_height / 2.0f;
+    ShaderProgram::set(tileSizeLoc, glm::vec2((float)TILE_WIDTH_SCALED, (float)TILE_HEIGHT_SCALED));
+    ShaderProgram::set(tileDepthParamsLoc, iso.depthParams());
+    ShaderProgram::set(layerRangeLoc, glm::ivec2(MAP_DEPTH_LAYER, IsoProjection::DEPTH_LAYERS - 1));
+    const int chunkSize = session.getStreamer().getChunkSize();
 
-    float globalOffsetX = (GameManager::getInstance()->SCR_WIDTH / 2.0f) - map_center_x;
-    float globalOffsetY = (GameManager::getInstance()->SCR_HEIGHT / 2.0f) - map_center_y;
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+
+    // a profundidade ordena os tiles, então os chunks vão na ordem do cache
+    draw_chunks.clear();
+    session.getStreamer().forEachResident([this](StreamedChunk& chunk) { draw_chunks.push_back(&chunk); });
+
+    for (StreamedChunk* chunk : draw_chunks) {
+        if (!chunkVisible(*chunk)) continue;
+        if (chunk->gpuDirty) uploadChunk(*chunk);
+        if (chunk->gpuInstanceCount == 0) continue;
+        tiles_drawn += chunk->gpuInstanceCount;
+        // as instâncias do chunk são relativas ao seu tile (0, 0)
+        const int col0 = chunk->cx * chunkSize;
+        const int row0 = chunk->cy * chunkSize;
+        ShaderProgram::set(mapOriginLoc, iso.toScreen(col0, row0));
+        ShaderProgram::set(diagonalBaseLoc, (float)col0 + (float)row0);
+        glBindBuffer(GL_ARRAY_BUFFER, chunk->gpuBuffer);
+        glVertexAttribIPointer(2, 4, GL_UNSIGNED_SHORT, sizeof(TileInstance), (void*)0);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, chunk->gpuInstanceCount);
+    }
 
-    float isoX = isoX_raw + globalOffsetX;
-    float isoY = isoY_raw + globalOffsetY;
+    glBindBuffer(GL_ARRAY_BUFFER, tileInstanceVBO);
+    glVertexAttribIPointer(2, 4, GL_UNSIGNED_SHORT, sizeof(TileInstance), (void*)0);
+    glBindVertexArray(0);
+}
 
-    return glm::vec2(isoX, isoY);
+bool GameManager::chunkVisible(const StreamedChunk& chunk) const {
+    int chunkSize = session.getStreamer().getChunkSize();
+    int rowBegin, rowEnd;
+    if (!iso.visibleRows(0.0f, 0.0f, (float)SCR_WIDTH, (float)SCR_HEIGHT, rowBegin, rowEnd)) return false;
+    rowBegin = std::max(rowBegin, chunk.cy * chunkSize);
+    rowEnd = std::min(rowEnd, (chunk.cy + 1) * chunkSize);
+    for (int r = rowBegin; r < rowEnd; ++r) {
+        int colBegin, colEnd;
+        if (iso.visibleColumns(r, 0.0f, 0.0f, (float)SCR_WIDTH, (float)SCR_HEIGHT, colBegin, colEnd) &&
+            colBegin < (chunk.cx + 1) * chunkSize && colEnd > chunk.cx * chunkSize) {
+            return true;
+        }
+    }
+    return false;
 }
 
-void GameManager::renderMap() {
-    glm::mat4 projection = glm::ortho(0.0f, (float)SCR_WIDTH, (float)SCR_HEIGHT, 0.0f, -1.0f, 1.0f);
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+// As camadas de um tile ficam lado a lado no buffer ((r * cols + c) * camadas
+// + camada), então qualquer trecho de linhas visíveis cobre todas as camadas
+// e continua sendo um só draw. Células vazias das camadas de cenário também
+// têm instância; o vertex shader as joga para fora do recorte.
+void GameManager::buildTileInstances() {
+    tile_instances.resize((size_t)MAP_ROWS * MAP_COLS * map_layers);
+    for (int r = 0; r < MAP_ROWS; ++r) {
+        for (int c = 0; c < MAP_COLS; ++c) {
+            for (int layer = 0; layer < map_layers; ++layer) {
+                TileInstance& inst = tile_instances[((size_t)r * MAP_COLS + c) * map_layers + layer];
+                inst.col = static_cast<unsigned short>(c);
+                inst.row = static_cast<unsigned short>(r);
+                inst.tileId = session.getLayer(layer).get(c, r);
+                inst.layer = mapLayerDepth(layer);
+            }
+        }
+    }
+    dirty_tiles.resize(MAP_ROWS * MAP_COLS);
+}
 
+void GameManager::setupInstancedMap() {
     if (VAO == 0) {
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
@@ -624,310 +1307,1047 @@ void GameManager::renderMap() {
         glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
         glEnableVertexAttribArray(1);
     }
-    glBindVertexArray(VAO);
 
-    int modelLoc = glGetUniformLocation(shaderProgram, "model");
-    int spriteUVsLoc = glGetUniformLocation(shaderProgram, "spriteUVs");
+    glGenVertexArrays(1, &instancedVAO);
+    glGenBuffers(1, &tileInstanceVBO);
+    glBindVertexArray(instancedVAO);
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glUniform1i(glGetUniformLocation(shaderProgram, "basic_texture"), 0);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
 
-    for (int r = 0; r < MAP_ROWS; ++r) {
-        for (int c = 0; c < MAP_COLS; ++c) {
-            int tileId = game_map[r][c];
-            glm::vec2 pos = gridToIsometric(c, r);
-            float u_min = (float)(tileId % TILESET_COLS) / TILESET_COLS;
-            float v_min = (float)(tileId / TILESET_COLS) / TILESET_ROWS;
-            float u_max = (float)(tileId % TILESET_COLS + 1) / TILESET_COLS;
-            float v_max = (float)(tileId / TILESET_COLS + 1) / TILESET_ROWS;
+    glBindBuffer(GL_ARRAY_BUFFER, tileInstanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, tile_instances.size() * sizeof(TileInstance), tile_instances.data(), GL_DYNAMIC_DRAW);
+    tile_instance_capacity = tile_instances.size();
+    glVertexAttribIPointer(2, 4, GL_UNSIGNED_SHORT, sizeof(TileInstance), (void*)0);
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
 
-            glUniform4f(spriteUVsLoc, u_min, v_min, u_max, v_max);
+    glBindVertexArray(0);
+    dirty_tiles.consume();
+}
 
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, glm::vec3(pos.x - TILE_WIDTH_SCALED / 2.0f, pos.y - TILE_HEIGHT_SCALED, 0.0f));
-            model = glm::scale(model, glm::vec3((float)TILE_WIDTH_SCALED, (float)TILE_HEIGHT_SCALED, 1.0f));
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-            glDrawArrays(GL_TRIANGLES, 0, 6);
+void GameManager::flushDirtyTiles() {
+    if (dirty_tiles.empty()) return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, tileInstanceVBO);
+    if (tile_instance_capacity != tile_instances.size()) {
+        dirty_tiles.consume();
+        glBufferData(GL_ARRAY_BUFFER, tile_instances.size() * sizeof(TileInstance), tile_instances.data(), GL_DYNAMIC_DRAW);
+        tile_instance_capacity = tile_instances.size();
+        return;
+    }
+
+    // só a camada 0 muda durante o jogo
+    const TileId* tiles = session.getMap().data();
+    for (const DirtyTileTracker::Range& range : dirty_tiles.consume()) {
+        for (int i = range.begin; i < range.end; ++i) {
+            tile_instances[(size_t)i * map_layers].tileId = tiles[i];
         }
+        glBufferSubData(GL_ARRAY_BUFFER,
+                        (size_t)range.begin * map_layers * sizeof(TileInstance),
+                        (size_t)(range.end - range.begin) * map_layers * sizeof(TileInstance),
+                        &tile_instances[(size_t)range.begin * map_layers]);
     }
 }
 
+// Spritesheets na ordem de Sprite::sheet. Os tamanhos são da arte: o slime
+// ocupa a largura do tile e duas alturas, os inimigos 20x20 pixels escalados,
+// apoiados um quarto de tile acima do canto de baixo do losango.
+void GameManager::setupSpriteRendering() {
+    const float tileW = (float)TILE_WIDTH_SCALED;
+    const float tileH = (float)TILE_HEIGHT_SCALED;
+    const float enemySize = 20.0f * GAME_SCALE;
+    SpriteSheet player = { 0, 6, 4, glm::vec2(tileW, tileH * 2.0f), glm::vec2(-tileW * 0.5f, -tileH * 1.5f), SPRITE_DEPTH_LAYER, 0.5f, {} };
+    SpriteSheet enemies = { 0, GameSession::ENEMY_FRAMES, GameSession::ENEMY_KINDS, glm::vec2(enemySize), glm::vec2(-enemySize * 0.5f, -tileH * 0.25f - enemySize), SPRITE_DEPTH_LAYER, 0.25f, {} };
+    sprite_sheets.push_back(player);
+    sprite_sheets.push_back(enemies);
+    for (SpriteSheet& sheet : sprite_sheets) createPlaceholderTexture(sheet.texture);
+
+    glGenVertexArrays(1, &spriteVAO);
+    glGenBuffers(1, &spriteInstanceVBO);
+    glBindVertexArray(spriteVAO);
 
-GameCharacter::GameCharacter(unsigned int sharedShaderProgram, const std::string& texturePath, float spriteDisplayWidth, float spriteDisplayHeight, int totalRows, int totalCols) :
-    shaderProgram(sharedShaderProgram), displayScale(spriteDisplayWidth, spriteDisplayHeight), rotation(0.0f), totalAnimationRows(totalRows), totalAnimationCols(totalCols), currentFrame(0), animationFPS(10.0f), currentAnimationType(AnimationType::IDLE_FRONT), row(0), col(0) {
-    loadTexture(texturePath.c_str(), &textureID);
-    setupMesh();
-    calculateCurrentFrameUVs();
-    lastFrameTime = glfwGetTime();
-}
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
 
-GameCharacter::~GameCharacter() {
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
-    glDeleteTextures(1, &textureID);
-}
+    glBindBuffer(GL_ARRAY_BUFFER, spriteInstanceVBO);
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
+    glEnableVertexAttribArray(4);
+    glVertexAttribDivisor(4, 1);
 
-void GameCharacter::update(float deltaTime) {
-    double currentTime = glfwGetTime();
-    if (currentTime - lastFrameTime >= 1.0 / animationFPS) {
-        currentFrame = (currentFrame + 1) % totalAnimationCols;
-        calculateCurrentFrameUVs();
-        lastFrameTime = currentTime;
-    }
+    glBindVertexArray(0);
 }
 
-void GameCharacter::setGridPosition(int r, int c) {
-    row = r;
-    col = c;
-}
+// Um draw instanciado por spritesheet. Os Transforms são interpolados aqui,
+// uma vez por quadro; as instâncias de todas as spritesheets vão juntas em um
+// único envio e cada draw aponta os atributos para o seu trecho do buffer.
+void GameManager::renderEntities() {
+    EntityWorld& world = session.getWorld();
+    if (spriteVAO == 0 || world.size() == 0) return;
+
+    WorkerPool* pool = world.size() >= PARALLEL_TRANSFORM_ENTITIES ? session.getWorkerPool() : nullptr;
+    updateTransforms(world, iso, render_alpha, pool);
+
+    size_t total = 0;
+    for (SpriteSheet& sheet : sprite_sheets) sheet.instances.clear();
+    world.each<Transform, Animation, Sprite>([&](Transform& transform, Animation& animation, Sprite& sprite) {
+        if (sprite.sheet < 0 || sprite.sheet >= (int)sprite_sheets.size()) return;
+        SpriteInstance instance = { transform.position, (unsigned short)animation.clip, 0, (float)animation.startTime };
+        sprite_sheets[sprite.sheet].instances.push_back(instance);
+        total++;
+    });
+    if (total == 0) return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, spriteInstanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, total * sizeof(SpriteInstance), nullptr, GL_STREAM_DRAW);
+    size_t offset = 0;
+    for (const SpriteSheet& sheet : sprite_sheets) {
+        if (sheet.instances.empty()) continue;
+        glBufferSubData(GL_ARRAY_BUFFER, offset * sizeof(SpriteInstance), sheet.instances.size() * sizeof(SpriteInstance), sheet.instances.data());
+        offset += sheet.instances.size();
+    }
 
-void GameCharacter::draw(const glm::mat4& projection, glm::vec2 (*gridToIsometricFunc)(int, int)) {
-    glUseProgram(shaderProgram);
+    spriteShaderProgram.use();
+    ShaderProgram::set(spriteMapOriginLoc, iso.origin());
+    ShaderProgram::set(spriteTileSizeLoc, glm::vec2((float)TILE_WIDTH_SCALED, (float)TILE_HEIGHT_SCALED));
+    ShaderProgram::set(spriteDepthParamsLoc, iso.depthParams());
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glUniform1i(glGetUniformLocation(shaderProgram, "basic_texture"), 0);
-
-    glUniform4f(glGetUniformLocation(shaderProgram, "spriteUVs"),
-                currentFrameUVs.x, currentFrameUVs.y, currentFrameUVs.z, currentFrameUVs.w);
+    glBindVertexArray(spriteVAO);
+    offset = 0;
+    for (const SpriteSheet& sheet : sprite_sheets) {
+        if (sheet.instances.empty()) continue;
+        const size_t base = offset * sizeof(SpriteInstance);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)base);
+        glVertexAttribIPointer(3, 1, GL_UNSIGNED_SHORT, sizeof(SpriteInstance), (void*)(base + offsetof(SpriteInstance, clip)));
+        glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)(base + offsetof(SpriteInstance, startTime)));
+        ShaderProgram::set(spriteSizeLoc, sheet.size);
+        ShaderProgram::set(spriteOffsetLoc, sheet.offset);
+        ShaderProgram::set(spriteDepthLoc, glm::vec2((float)sheet.layer, sheet.depthBias));
+        ShaderProgram::set(sheetDimsLoc, glm::ivec2(sheet.cols, sheet.rows));
+        glBindTexture(GL_TEXTURE_2D, sheet.texture);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, (GLsizei)sheet.instances.size());
+        offset += sheet.instances.size();
+    }
+    glBindVertexArray(0);
+}
 
-    glm::vec2 screen_pos = gridToIsometricFunc(col, row);
+void GameManager::renderMap() {
+    tiles_drawn = 0;
+
+    if (mapRenderMode == MapRenderMode::CACHED) {
+        renderMapCached();
+    } else if (streaming) {
+        renderMapStreaming();
+    } else if (mapRenderMode == MapRenderMode::INSTANCED) {
+        renderMapInstanced();
+    } else {
+        renderMapLoop();
+    }
+}
 
-    glm::mat4 model = glm::mat4(1.0f);
-    float adjustedX = screen_pos.x - (displayScale.x / 2.0f) + (GameManager::getInstance()->getTileWidth() / 2.0f);
-    float adjustedY = screen_pos.y - displayScale.y + (GameManager::getInstance()->getTileHeight() / 2.0f) + GameManager::getInstance()->getTileHeight();
+// Só as instâncias com camada de profundidade em [firstDepthLayer,
+// lastDepthLayer]; as outras o vertex shader joga para fora do recorte.
+void GameManager::renderMapInstanced(int firstDepthLayer, int lastDepthLayer) {
+    if (tile_instances.empty()) return;
 
+    tileShaderProgram.use();
+    glBindVertexArray(instancedVAO);
 
-    model = glm::translate(model, glm::vec3(adjustedX, adjustedY, 0.02f));
-    model = glm::translate(model, glm::vec3(0.5f * displayScale.x, 0.5f * displayScale.y, 0.0f));
-    model = glm::rotate(model, glm::radians(rotation), glm::vec3(0.0f, 0.0f, 1.0f));
-    model = glm::translate(model, glm::vec3(-0.5f * displayScale.x, -0.5f * displayScale.y, 0.0f));
-    model = glm::scale(model, glm::vec3(displayScale, 1.0f));
+    flushDirtyTiles();
 
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    ShaderProgram::set(tileSizeLoc, glm::vec2((float)TILE_WIDTH_SCALED, (float)TILE_HEIGHT_SCALED));
+    ShaderProgram::set(mapOriginLoc, iso.origin());
+    ShaderProgram::set(diagonalBaseLoc, 0.0f);
+    ShaderProgram::set(layerRangeLoc, glm::ivec2(firstDepthLayer, lastDepthLayer));
+    ShaderProgram::set(tileDepthParamsLoc, iso.depthParams());
 
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+
+    // Cada linha visível é um trecho contíguo do buffer de instâncias, com
+    // todas as camadas; como o GL 3.3 não tem base instance, o atributo por
+    // instância é reapontado para o início do trecho. Linhas inteiras
+    // consecutivas viram um só draw.
+    int rowBegin, rowEnd;
+    if (iso.visibleRows(0.0f, 0.0f, (float)SCR_WIDTH, (float)SCR_HEIGHT, rowBegin, rowEnd)) {
+        glBindBuffer(GL_ARRAY_BUFFER, tileInstanceVBO);
+        int runBegin = 0, runEnd = 0;
+        for (int r = rowBegin; r <= rowEnd; ++r) {
+            int colBegin = 0, colEnd = 0;
+            bool visible = r < rowEnd && iso.visibleColumns(r, 0.0f, 0.0f, (float)SCR_WIDTH, (float)SCR_HEIGHT, colBegin, colEnd);
+            int begin = (r * MAP_COLS + colBegin) * map_layers;
+            if (visible && begin == runEnd && runEnd > runBegin) {
+                runEnd = (r * MAP_COLS + colEnd) * map_layers;
+                continue;
+            }
+            if (runEnd > runBegin) {
+                glVertexAttribIPointer(2, 4, GL_UNSIGNED_SHORT, sizeof(TileInstance), (void*)(runBegin * sizeof(TileInstance)));
+                glDrawArraysInstanced(GL_TRIANGLES, 0, 6, runEnd - runBegin);
+                tiles_drawn += runEnd - runBegin;
+            }
+            runBegin = visible ? begin : 0;
+            runEnd = visible ? (r * MAP_COLS + colEnd) * map_layers : 0;
+        }
+        glVertexAttribIPointer(2, 4, GL_UNSIGNED_SHORT, sizeof(TileInstance), (void*)0);
+    }
     glBindVertexArray(0);
 }
 
-void GameCharacter::setAnimationFPS(float fps) {
-    animationFPS = fps;
-}
+void GameManager::renderMapLoop() {
+    shaderProgram.use();
+    glBindVertexArray(VAO);
 
-void GameCharacter::setAnimationType(AnimationType type) {
-    if (currentAnimationType != type) {
-        currentAnimationType = type;
-        currentFrame = 0;
-        lastFrameTime = glfwGetTime();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+
+    int rowBegin, rowEnd;
+    if (!iso.visibleRows(0.0f, 0.0f, (float)SCR_WIDTH, (float)SCR_HEIGHT, rowBegin, rowEnd)) return;
+
+    for (int r = rowBegin; r < rowEnd; ++r) {
+        int colBegin, colEnd;
+        if (!iso.visibleColumns(r, 0.0f, 0.0f, (float)SCR_WIDTH, (float)SCR_HEIGHT, colBegin, colEnd)) continue;
+        iso.projectRow(r, colBegin, colEnd - colBegin, row_screen_x.data(), row_screen_y.data());
+        for (int layer = 0; layer < map_layers; ++layer) {
+            const TileId* row = session.getLayer(layer).rowData(r);
+            for (int c = colBegin; c < colEnd; ++c) {
+                int tileId = row[c];
+                if (tileId == MAP_EMPTY_TILE) continue;
+                glm::vec2 pos(row_screen_x[c - colBegin], row_screen_y[c - colBegin]);
+                ShaderProgram::set(tileIdLoc, tileId);
+
+                glm::mat4 model = glm::mat4(1.0f);
+                model = glm::translate(model, glm::vec3(pos.x - TILE_WIDTH_SCALED / 2.0f, pos.y - TILE_HEIGHT_SCALED,
+                                                        iso.depth((float)(c + r), mapLayerDepth(layer), 0.0f)));
+                model = glm::scale(model, glm::vec3((float)TILE_WIDTH_SCALED, (float)TILE_HEIGHT_SCALED, 1.0f));
+                ShaderProgram::set(spriteModelLoc, model);
+                glDrawArrays(GL_TRIANGLES, 0, 6);
+                tiles_drawn++;
+            }
+        }
     }
 }
 
-AnimationType GameCharacter::getAnimationType() const {
-    return currentAnimationType;
+void GameManager::invalidateMapCache() {
+    map_cache_valid = false;
+    map_cache_patches.clear();
 }
 
-bool GameCharacter::loadTexture(const char* file_name, GLuint* tex_id) {
-    int x, y, n;
-    int force_channels = 4;
-    unsigned char* image_data = stbi_load(file_name, &x, &y, &n, force_channels);
-    if (!image_data) {
-        fprintf(stderr, "ERROR: could not load %s\n", file_name);
-        return false;
+// Cria (ou recria, se a janela mudou de tamanho) a textura que guarda a camada
+// do mapa. O framebuffer padrão é multisample, então o cache é uma textura
+// comum desenhada na tela com um quad, e não um glBlitFramebuffer.
+bool GameManager::ensureMapCache() {
+    if (mapCacheFBO != 0 && map_cache_width == (int)SCR_WIDTH && map_cache_height == (int)SCR_HEIGHT) {
+        return true;
     }
 
-    glGenTextures(1, tex_id);
-    glBindTexture(GL_TEXTURE_2D, *tex_id);
+    if (mapCacheFBO == 0) {
+        glGenFramebuffers(1, &mapCacheFBO);
+        glGenTextures(1, &mapCacheTexture);
+        glGenRenderbuffers(1, &mapCacheDepth);
+        glGenVertexArrays(1, &blitVAO);
+    }
+    glBindTexture(GL_TEXTURE_2D, mapCacheTexture);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-
-    GLfloat max_aniso = 0.0f;
-    glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_aniso);
-    if (max_aniso > 0.0f) {
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, max_aniso);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, mapCacheFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mapCacheTexture, 0);
+    // profundidade própria: o mapa também é desenhado no cache sem ordem fixa
+    glBindRenderbuffer(GL_RENDERBUFFER, mapCacheDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, SCR_WIDTH, SCR_HEIGHT);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, mapCacheDepth);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        LOG_WARN("Framebuffer do cache do mapa incompleto (status 0x%x). Voltando ao renderizador instanciado.", (unsigned)status);
+        mapRenderMode = MapRenderMode::INSTANCED;
+        return false;
     }
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, x, y, 0, GL_RGBA, GL_UNSIGNED_BYTE, image_data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    stbi_image_free(image_data);
-    std::cout << "Textura carregada com sucesso: " << file_name << std::endl;
+    map_cache_width = SCR_WIDTH;
+    map_cache_height = SCR_HEIGHT;
+    invalidateMapCache();
     return true;
 }
 
-void GameCharacter::setupMesh() {
-    float quad_vertices[] = {
-        -0.5f,  0.5f, 0.0f,   0.0f, 1.0f,
-         0.5f,  0.5f, 0.0f,   1.0f, 1.0f,
-         0.5f, -0.5f, 0.0f,   1.0f, 0.0f,
-        -0.5f, -0.5f, 0.0f,   0.0f, 0.0f
-    };
-    unsigned int quad_indices[] = {
-        0, 1, 2,
-        0, 2, 3
-    };
+void GameManager::renderMapCached() {
+    if (!ensureMapCache()) {
+        renderMap();
+        return;
+    }
+
+    queueAnimatedTilePatches();
+    if (!map_cache_valid || !map_cache_patches.empty()) {
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glBindFramebuffer(GL_FRAMEBUFFER, mapCacheFBO);
+        glViewport(0, 0, map_cache_width, map_cache_height);
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+
+        if (!map_cache_valid) {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            if (streaming) {
+                renderMapStreaming();
+            } else {
+                renderMapInstanced(MAP_DEPTH_LAYER, MAP_DEPTH_LAYER);
+            }
+            map_cache_patches.clear();
+            map_cache_valid = true;
+        } else {
+            patchMapCache();
+        }
 
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    }
 
-    glBindVertexArray(VAO);
+    // Cópia 1:1 sem blending, para não alterar o alfa já composto no cache,
+    // e sem escrever profundidade: o cache só tem a camada 0, que fica
+    // embaixo de tudo. As camadas de cenário vêm depois, ao vivo, e se
+    // ordenam com os sprites pela profundidade, como nos outros modos.
+    blitShaderProgram.use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, mapCacheTexture);
+    glDisable(GL_BLEND);
+    glDepthMask(GL_FALSE);
+    glBindVertexArray(blitVAO);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray(0);
+    glDepthMask(GL_TRUE);
+    glEnable(GL_BLEND);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(quad_vertices), quad_vertices, GL_STATIC_DRAW);
+    if (!streaming && map_layers > 1) renderMapInstanced(MAP_DEPTH_LAYER + 1, IsoProjection::DEPTH_LAYERS - 1);
+}
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(quad_indices), quad_indices, GL_STATIC_DRAW);
+// Tiles animados no cache: quando um clipe de tile troca de quadro (no
+// tempo do bloco Frame), os tiles visíveis daquele tipo entram como remendos,
+// achados pelo índice por tipo sem percorrer o mapa. Com remendos demais ou
+// em streaming, o cache é refeito inteiro. As camadas de cenário não estão no
+// cache, então os tiles animados nelas não o invalidam.
+void GameManager::queueAnimatedTilePatches() {
+    const double time = frameUniforms.get().time;
+    changed_tile_types.clear();
+    for (int i = 0; i < (int)map_cache_tile_steps.size(); ++i) {
+        const long long steps = clipSteps(animation_clips.get(tile_clip_base + i), time);
+        if (steps == map_cache_tile_steps[i]) continue;
+        map_cache_tile_steps[i] = steps;
+        changed_tile_types.push_back(TILE_ANIMATIONS[i].tileId);
+    }
+    if (changed_tile_types.empty() || !map_cache_valid) return;
+    if (streaming) {
+        invalidateMapCache();
+        return;
+    }
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    // retângulo da grade que contém o losango visível
+    int rowBegin, rowEnd;
+    if (!iso.visibleRows(0.0f, 0.0f, (float)SCR_WIDTH, (float)SCR_HEIGHT, rowBegin, rowEnd)) return;
+    int colBegin = MAP_COLS, colEnd = 0;
+    for (int r = rowBegin; r < rowEnd; ++r) {
+        int begin, end;
+        if (!iso.visibleColumns(r, 0.0f, 0.0f, (float)SCR_WIDTH, (float)SCR_HEIGHT, begin, end)) continue;
+        colBegin = std::min(colBegin, begin);
+        colEnd = std::max(colEnd, end);
+    }
+    const TileTypeIndex& index = session.getTileIndex();
+    for (int tileId : changed_tile_types) {
+        index.forEachInRect(static_cast<TileId>(tileId), colBegin, rowBegin, colEnd - 1, rowEnd - 1, [&](int c, int r) {
+            map_cache_patches.push_back(session.getMap().index(c, r));
+        });
+        if (map_cache_patches.size() > MAX_MAP_CACHE_PATCHES) {
+            invalidateMapCache();
+            return;
+        }
+    }
+}
 
+// Redesenha só a área dos tiles alterados. O scissor cobre os pixels cujo
+// centro cai no quad do tile; os únicos quads que se sobrepõem a ele são os
+// da vizinhança 3x3, redesenhados sobre cor e profundidade limpas no recorte.
+void GameManager::patchMapCache() {
+    shaderProgram.use();
+    glBindVertexArray(VAO);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+
+    glEnable(GL_SCISSOR_TEST);
+    for (int index : map_cache_patches) {
+        int r = index / MAP_COLS;
+        int c = index % MAP_COLS;
+        glm::vec2 pos = iso.toScreen(c, r);
+
+        // y da tela cresce para baixo, o do framebuffer para cima
+        int x0 = (int)std::ceil(pos.x - TILE_WIDTH_SCALED / 2.0f - 0.5f);
+        int x1 = (int)std::ceil(pos.x + TILE_WIDTH_SCALED / 2.0f - 0.5f);
+        int y0 = (int)std::ceil(map_cache_height - pos.y - 0.5f);
+        int y1 = (int)std::ceil(map_cache_height - pos.y + TILE_HEIGHT_SCALED - 0.5f);
+        x0 = std::max(x0, 0);
+        y0 = std::max(y0, 0);
+        x1 = std::min(x1, map_cache_width);
+        y1 = std::min(y1, map_cache_height);
+        if (x0 >= x1 || y0 >= y1) continue;
+
+        glScissor(x0, y0, x1 - x0, y1 - y0);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        for (int nr = std::max(r - 1, 0); nr <= std::min(r + 1, MAP_ROWS - 1); ++nr) {
+            for (int nc = std::max(c - 1, 0); nc <= std::min(c + 1, MAP_COLS - 1); ++nc) {
+                drawSingleTile(nr, nc);
+            }
+        }
+    }
+    glDisable(GL_SCISSOR_TEST);
     glBindVertexArray(0);
+    map_cache_patches.clear();
 }
 
-void GameCharacter::calculateCurrentFrameUVs() {
-    float frameWidthNormalized = 1.0f / totalAnimationCols;
-    float frameHeightNormalized = 1.0f / totalAnimationRows;
+// só a camada 0, a única que fica no cache
+void GameManager::drawSingleTile(int r, int c) {
+    glm::vec2 pos = iso.toScreen(c, r);
+    int tileId = session.getMap().get(c, r);
+    if (tileId == MAP_EMPTY_TILE) return;
+    ShaderProgram::set(tileIdLoc, tileId);
+
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(pos.x - TILE_WIDTH_SCALED / 2.0f, pos.y - TILE_HEIGHT_SCALED,
+                                            iso.depth((float)(c + r), MAP_DEPTH_LAYER, 0.0f)));
+    model = glm::scale(model, glm::vec3((float)TILE_WIDTH_SCALED, (float)TILE_HEIGHT_SCALED, 1.0f));
+    ShaderProgram::set(spriteModelLoc, model);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    tiles_drawn++;
+}
 
-    float u_min = currentFrame * frameWidthNormalized;
-    float u_max = u_min + frameWidthNormalized;
 
-    float v_min = static_cast<int>(currentAnimationType) * frameHeightNormalized;
-    float v_max = v_min + frameHeightNormalized;
 
-    currentFrameUVs = glm::vec4(u_min, v_min, u_max, v_max);
+InputHandler::InputHandler() {
+    commandMap[GLFW_KEY_W] = CommandId::MOVE_UP;
+    commandMap[GLFW_KEY_S] = CommandId::MOVE_DOWN;
+    commandMap[GLFW_KEY_A] = CommandId::MOVE_LEFT;
+    commandMap[GLFW_KEY_D] = CommandId::MOVE_RIGHT;
+    commandMap[GLFW_KEY_Q] = CommandId::MOVE_UP_LEFT;
+    commandMap[GLFW_KEY_E] = CommandId::MOVE_UP_RIGHT;
+    commandMap[GLFW_KEY_Z] = CommandId::MOVE_DOWN_LEFT;
+    commandMap[GLFW_KEY_C] = CommandId::MOVE_DOWN_RIGHT;
+    commandMap[GLFW_KEY_R] = CommandId::RESET;
 }
 
+void InputHandler::handleInput(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    if (action != GLFW_PRESS && action != GLFW_REPEAT) return;
 
-void MoveUpCommand::execute(GameCharacter* character) {
-    GameManager::getInstance()->processPlayerMovement(character->row - 1, character->col);
-    GameManager::getInstance()->setPlayerAnimation(AnimationType::IDLE_BACK);
-}
+    if (key == GLFW_KEY_ESCAPE) {
+        glfwSetWindowShouldClose(window, true);
+        return;
+    }
 
-void MoveDownCommand::execute(GameCharacter* character) {
-    GameManager::getInstance()->processPlayerMovement(character->row + 1, character->col);
-    GameManager::getInstance()->setPlayerAnimation(AnimationType::IDLE_FRONT);
+    // executado no próximo tick da simulação, não no callback
+    if (commandMap.count(key)) {
+        GameManager::getInstance()->queueCommand(commandMap[key]);
+    }
 }
 
-void MoveLeftCommand::execute(GameCharacter* character) {
-    GameManager::getInstance()->processPlayerMovement(character->row, character->col - 1);
-    GameManager::getInstance()->setPlayerAnimation(AnimationType::IDLE_LEFT);
-}
 
-void MoveRightCommand::execute(GameCharacter* character) {
-    GameManager::getInstance()->processPlayerMovement(character->row, character->col + 1);
-    GameManager::getInstance()->setPlayerAnimation(AnimationType::IDLE_RIGHT);
+void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+    glViewport(0, 0, width, height);
+    GameManager::getInstance()->onFramebufferResize(width, height);
 }
 
-void MoveUpLeftCommand::execute(GameCharacter* character) {
-    GameManager::getInstance()->processPlayerMovement(character->row - 1, character->col - 1);
-    GameManager::getInstance()->setPlayerAnimation(AnimationType::IDLE_LEFT);
+void processInput(GLFWwindow* window) {
 }
 
-void MoveUpRightCommand::execute(GameCharacter* character) {
-    GameManager::getInstance()->processPlayerMovement(character->row - 1, character->col + 1);
-    GameManager::getInstance()->setPlayerAnimation(AnimationType::IDLE_RIGHT);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    GameManager::getInstance()->handleKeyCallback(window, key, scancode, action, mods);
 }
 
-void MoveDownLeftCommand::execute(GameCharacter* character) {
-    GameManager::getInstance()->processPlayerMovement(character->row + 1, character->col - 1);
-    GameManager::getInstance()->setPlayerAnimation(AnimationType::IDLE_LEFT);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
+    GameManager::getInstance()->handleMouseButton(window, button, action, mods);
 }
 
-void MoveDownRightCommand::execute(GameCharacter* character) {
-    GameManager::getInstance()->processPlayerMovement(character->row + 1, character->col + 1);
-    GameManager::getInstance()->setPlayerAnimation(AnimationType::IDLE_RIGHT);
+void window_refresh_callback(GLFWwindow* window) {
+    GameManager::getInstance()->requestRedraw();
 }
 
-void ResetGameCommand::execute(GameCharacter* character) {
-    GameManager::getInstance()->resetGame();
+// Tempo de CPU do processo (todas as threads), para o uso de CPU das estatísticas.
+double processCpuSeconds() {
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) return 0.0;
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    return (double)(k.QuadPart + u.QuadPart) * 1e-7;
+#else
+    return (double)std::clock() / CLOCKS_PER_SEC;
+#endif
 }
 
-InputHandler::InputHandler() {
-    commandMap[GLFW_KEY_W] = new MoveUpCommand();
-    commandMap[GLFW_KEY_S] = new MoveDownCommand();
-    commandMap[GLFW_KEY_A] = new MoveLeftCommand();
-    commandMap[GLFW_KEY_D] = new MoveRightCommand();
-    commandMap[GLFW_KEY_Q] = new MoveUpLeftCommand();
-    commandMap[GLFW_KEY_E] = new MoveUpRightCommand();
-    commandMap[GLFW_KEY_Z] = new MoveDownLeftCommand();
-    commandMap[GLFW_KEY_C] = new MoveDownRightCommand();
-    commandMap[GLFW_KEY_R] = new ResetGameCommand();
+void setupOpenGL() {
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glEnable(GL_DEPTH_TEST);
+    // chaves iguais (a mesma diagonal) ficam com o último desenhado, como antes
+    glDepthFunc(GL_LEQUAL);
 }
 
-InputHandler::~InputHandler() {
-    for (auto const& [key, val] : commandMap) {
-        delete val;
+// Mapa sintético para o benchmark: obstáculos aleatórios e muros horizontais
+// com poucas passagens, para forçar desvios longos.
+void buildBenchmarkMask(WalkMask& mask, int size) {
+    std::mt19937 rng(1234);
+    mask.resize(size, size);
+    for (int r = 0; r < size; ++r) {
+        for (int c = 0; c < size; ++c) {
+            bool wall = rng() % 100 < 10;
+            if (r % 128 == 64 && c % 128 > 4) wall = true;
+            mask.set(c, r, !wall);
+        }
     }
 }
 
-void InputHandler::handleInput(GLFWwindow* window, int key, int scancode, int action, int mods, GameCharacter* player_char) {
-    if (action != GLFW_PRESS && action != GLFW_REPEAT) return;
-
-    if (key == GLFW_KEY_ESCAPE) {
-        glfwSetWindowShouldClose(window, true);
-        return;
+// Consultas de caminho por segundo entre pares aleatórios de tiles caminháveis,
+// com o A* direto e com a busca hierárquica, mais o custo de reparar o grafo
+// hierárquico depois de trocar alguns tiles.
+int runPathBenchmark(const WalkMask& mask, int queries) {
+    std::mt19937 rng(42);
+    std::vector<int> pairs;
+    pairs.reserve(queries * 4);
+    while ((int)pairs.size() < queries * 4) {
+        int c = rng() % mask.getWidth();
+        int r = rng() % mask.getHeight();
+        if (!mask.walkable(c, r)) continue;
+        pairs.push_back(c);
+        pairs.push_back(r);
     }
-
-    if (GameManager::getInstance()->isGameOver() || GameManager::getInstance()->hasGameWon()) {
-        if (key == GLFW_KEY_R) { 
-             if (commandMap.count(key)) {
-                commandMap[key]->execute(player_char);
-            }
+    typedef std::chrono::high_resolution_clock Clock;
+    std::cout << "Benchmark de caminhos em " << mask.getWidth() << "x" << mask.getHeight() << ", " << queries << " consultas" << std::endl;
+
+    PathFinder finder;
+    std::vector<int> path;
+    std::vector<size_t> optimal(queries, 0);
+    int found = 0;
+    long long expanded = 0, length = 0;
+    auto start = Clock::now();
+    for (int q = 0; q < queries; ++q) {
+        const int* p = &pairs[q * 4];
+        if (finder.findPath(mask, p[0], p[1], p[2], p[3], path)) {
+            found++;
+            length += path.size();
+            optimal[q] = path.size();
         }
-        return;
+        expanded += finder.getLastExpanded();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "  A*: " << seconds * 1000.0 << " ms (" << (seconds > 0.0 ? queries / seconds : 0.0) << " consultas/s), encontrados: "
+              << found << ", comprimento medio: " << (found ? length / found : 0)
+              << " tiles, tiles expandidos por consulta: " << (queries ? expanded / queries : 0) << std::endl;
+
+    HierarchicalPathFinder hierarchical;
+    start = Clock::now();
+    hierarchical.build(mask);
+    double buildSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "  HPA*: grafo com " << hierarchical.getNodeCount() << " entradas em " << hierarchical.getClusterCount()
+              << " clusters, montado em " << buildSeconds * 1000.0 << " ms" << std::endl;
+
+    found = 0;
+    expanded = length = 0;
+    long long optimalLength = 0;
+    start = Clock::now();
+    for (int q = 0; q < queries; ++q) {
+        const int* p = &pairs[q * 4];
+        if (hierarchical.findPath(mask, p[0], p[1], p[2], p[3], path)) {
+            found++;
+            length += path.size();
+            optimalLength += optimal[q];
+        }
+        expanded += hierarchical.getLastExpanded();
+    }
+    seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "  HPA*: " << seconds * 1000.0 << " ms (" << (seconds > 0.0 ? queries / seconds : 0.0) << " consultas/s), encontrados: "
+              << found << ", comprimento medio: " << (found ? length / found : 0) << " tiles ("
+              << (optimalLength ? 100.0 * length / optimalLength - 100.0 : 0.0) << "% acima do A*), entradas expandidas por consulta: "
+              << (queries ? expanded / queries : 0) << std::endl;
+
+    // reparo: troca um tile por vez e mede só o recálculo dos clusters
+    WalkMask edited = mask;
+    const int edits = 100;
+    double repairSeconds = 0.0;
+    for (int i = 0; i < edits; ++i) {
+        int c = rng() % edited.getWidth();
+        int r = rng() % edited.getHeight();
+        edited.set(c, r, !edited.walkable(c, r));
+        hierarchical.tileChanged(c, r);
+        start = Clock::now();
+        hierarchical.repair(edited);
+        repairSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    std::cout << "  HPA*: reparo apos trocar um tile: " << repairSeconds * 1000.0 / edits << " ms em media" << std::endl;
+
+    // campo de fluxo dos inimigos, com uma thread e com todas
+    for (int pass = 0; pass < 2; ++pass) {
+        WorkerPool pool(pass == 0 ? 1 : 0);
+        if (pass == 1 && pool.getThreadCount() == 1) break;
+        FlowField field;
+        const int fields = 10;
+        long long chunkRuns = 0;
+        start = Clock::now();
+        for (int i = 0; i < fields; ++i) {
+            const int* p = &pairs[(i % queries) * 4];
+            field.compute(mask, p[0], p[1], &pool);
+            chunkRuns += field.getLastChunkRuns();
+        }
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        std::cout << "  Campo de fluxo, " << pool.getThreadCount() << " thread(s): " << seconds * 1000.0 / fields << " ms por calculo, "
+                  << chunkRuns / fields << " execucoes de bloco para " << field.getChunkCount() << " blocos" << std::endl;
     }
+    return 0;
+}
 
-    if (commandMap.count(key)) {
-        commandMap[key]->execute(player_char);
+// Custo por quadro dos sistemas das entidades com N inimigos no mapa
+// sintético: passo pelo campo de fluxo, animação, Transforms interpolados e
+// a montagem das instâncias do desenho. Os Transforms são medidos em uma
+// thread e, havendo mais núcleos, no pool.
+int runEcsBenchmark(int entities) {
+    typedef std::chrono::high_resolution_clock Clock;
+    const int size = 1024;
+    WalkMask mask;
+    buildBenchmarkMask(mask, size);
+    FlowField field;
+    field.compute(mask, size / 2, size / 2, nullptr);
+    IsoProjection iso(64.0f, 32.0f, size, size, 1920.0f, 1080.0f);
+
+    EntityWorld world;
+    SpatialHash hash;
+    std::mt19937 rng(1337);
+    while ((int)world.size() < entities) {
+        int col = rng() % size;
+        int row = rng() % size;
+        if (!mask.walkable(col, row)) continue;
+        GridPosition grid = { col, row };
+        PreviousGridPosition previous = { col, row };
+        Transform transform = { iso.toScreen(col, row) };
+        Animation animation = { (int)(rng() % 12), -(double)(world.size() % 2) / 4.0 };
+        Sprite sprite = { 1 };
+        if (hash.countAt(col, row) > 0) continue;
+        Entity entity = world.create(grid, previous, transform, animation, sprite, EnemyTag());
+        hash.insert(entity.index, col, row);
     }
+    std::cout << "Benchmark do ECS: " << world.size() << " entidades em " << world.getArchetypeCount() << " arquetipo(s), mapa "
+              << size << "x" << size << std::endl;
+
+    std::vector<SpriteInstance> instances;
+    instances.reserve(entities);
+    for (int pass = 0; pass < 2; ++pass) {
+        WorkerPool pool(pass == 0 ? 1 : 0);
+        if (pass == 1 && pool.getThreadCount() == 1) break;
+        const int frames = 120;
+        double logicSeconds = 0.0, drawSeconds = 0.0;
+        for (int frame = 0; frame < frames; ++frame) {
+            auto start = Clock::now();
+            savePreviousPositions(world);
+            followFlowField(world, field, hash);
+            auto middle = Clock::now();
+            updateTransforms(world, iso, 0.5f, pass == 0 ? nullptr : &pool);
+            instances.clear();
+            world.each<Transform, Animation>([&](Transform& transform, Animation& animation) {
+                SpriteInstance instance = { transform.position, (unsigned short)animation.clip, 0, (float)animation.startTime };
+                instances.push_back(instance);
+            });
+            auto end = Clock::now();
+            logicSeconds += std::chrono::duration<double>(middle - start).count();
+            drawSeconds += std::chrono::duration<double>(end - middle).count();
+        }
+        std::cout << "  " << pool.getThreadCount() << " thread(s): logica " << logicSeconds * 1000.0 / frames
+                  << " ms por quadro, Transforms e instancias " << drawSeconds * 1000.0 / frames << " ms por quadro ("
+                  << (logicSeconds + drawSeconds > 0.0 ? frames * (double)world.size() / (logicSeconds + drawSeconds) / 1e6 : 0.0)
+                  << " milhoes de entidades/s)" << std::endl;
+    }
+    return 0;
 }
 
+// Vazão do hash espacial com 1k, 10k, ... até maxEntities entidades em
+// posições aleatórias de uma grade de 1024x1024: inserção, movimento de um
+// tile, consultas de retângulo 9x9 e de vizinho mais próximo, e a checagem
+// de colisões entre todas (pares no mesmo tile), contra o O(n^2) ingênuo
+// enquanto ele ainda termina em tempo razoável.
+int runSpatialBenchmark(int maxEntities) {
+    typedef std::chrono::high_resolution_clock Clock;
+    const int size = 1024;
+    const int queries = 100000;
+    std::cout << "Benchmark do hash espacial em " << size << "x" << size << ", " << queries << " consultas por tamanho" << std::endl;
+
+    std::vector<int> counts;
+    for (int n = 1000; n < maxEntities; n *= 10) counts.push_back(n);
+    counts.push_back(maxEntities);
+
+    for (int n : counts) {
+        std::mt19937 rng(7);
+        std::vector<int> cols(n), rows(n);
+        for (int i = 0; i < n; ++i) {
+            cols[i] = rng() % size;
+            rows[i] = rng() % size;
+        }
 
-void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    glViewport(0, 0, width, height);
-}
+        SpatialHash hash;
+        auto start = Clock::now();
+        for (int i = 0; i < n; ++i) hash.insert((uint32_t)i, cols[i], rows[i]);
+        double insertSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        const int rounds = 4;
+        start = Clock::now();
+        for (int round = 0; round < rounds; ++round) {
+            for (int i = 0; i < n; ++i) {
+                cols[i] = std::min(size - 1, std::max(0, cols[i] + (int)(rng() % 3) - 1));
+                rows[i] = std::min(size - 1, std::max(0, rows[i] + (int)(rng() % 3) - 1));
+                hash.move((uint32_t)i, cols[i], rows[i]);
+            }
+        }
+        double moveSeconds = std::chrono::duration<double>(Clock::now() - start).count();
 
-void processInput(GLFWwindow* window) {
-}
+        long long found = 0;
+        start = Clock::now();
+        for (int q = 0; q < queries; ++q) {
+            int c = rng() % size, r = rng() % size;
+            hash.forEachInRect(c - 4, r - 4, c + 4, r + 4, [&](uint32_t, int, int) { found++; });
+        }
+        double rectSeconds = std::chrono::duration<double>(Clock::now() - start).count();
 
-void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
-    GameManager::getInstance()->handleKeyCallback(window, key, scancode, action, mods);
+        int nearestFound = 0;
+        start = Clock::now();
+        for (int q = 0; q < queries; ++q) {
+            nearestFound += hash.nearest(rng() % size, rng() % size, 64) != SpatialHash::NONE ? 1 : 0;
+        }
+        double nearestSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        // pares de entidades no mesmo tile
+        long long pairs = 0;
+        start = Clock::now();
+        for (int i = 0; i < n; ++i) pairs += hash.countAt(cols[i], rows[i]) - 1;
+        pairs /= 2;
+        double collideSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::cout << "  " << n << " entidades: insercao " << (insertSeconds > 0.0 ? n / insertSeconds / 1e6 : 0.0) << " M/s, movimento "
+                  << (moveSeconds > 0.0 ? (double)n * rounds / moveSeconds / 1e6 : 0.0) << " M/s, retangulo 9x9 "
+                  << (rectSeconds > 0.0 ? queries / rectSeconds / 1e6 : 0.0) << " M consultas/s (" << (double)found / queries
+                  << " por consulta), mais proximo " << (nearestSeconds > 0.0 ? queries / nearestSeconds / 1e6 : 0.0)
+                  << " M consultas/s (" << 100.0 * nearestFound / queries << "% com resposta), colisoes " << collideSeconds * 1000.0
+                  << " ms (" << pairs << " pares)";
+        if (n <= 20000) {
+            long long naivePairs = 0;
+            start = Clock::now();
+            for (int i = 0; i < n; ++i) {
+                for (int j = i + 1; j < n; ++j) naivePairs += (cols[i] == cols[j] && rows[i] == rows[j]) ? 1 : 0;
+            }
+            double naiveSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+            std::cout << ", O(n^2): " << naiveSeconds * 1000.0 << " ms (" << naivePairs << " pares)";
+        }
+        std::cout << std::endl;
+    }
+    return 0;
 }
 
-void setupOpenGL() {
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LESS);
+// Escolha do tile sob o cursor em um mapa de 1024x1024 com tiles de 64x32
+// numa tela de 1920x1080. Primeiro a cobertura: cada pixel da tela vai para
+// um tile só, todo tile inteiro na tela recebe exatamente a área do losango
+// em pixels, e os pixels em que o toGrid (float) discorda são contados. Depois
+// a vazão com 'points' pontos sorteados: toGrid, pick e pickMany.
+int runPickingBenchmark(int points) {
+    typedef std::chrono::high_resolution_clock Clock;
+    const int size = 1024;
+    const int tileW = 64, tileH = 32;
+    const int width = 1920, height = 1080;
+    IsoProjection iso = IsoProjection::centeredOn((float)tileW, (float)tileH, size, size, size / 2, size / 2, (float)width, (float)height);
+    std::cout << "Benchmark da escolha de tile: mapa " << size << "x" << size << ", tiles de " << tileW << "x" << tileH
+              << ", tela de " << width << "x" << height << std::endl;
+
+    // pixels por tile, em uma janela de tiles que cobre a tela
+    int rowBegin, rowEnd;
+    iso.visibleRows(0.0f, 0.0f, (float)width, (float)height, rowBegin, rowEnd);
+    int colBegin = size, colEnd = 0;
+    for (int r = rowBegin; r < rowEnd; ++r) {
+        int begin, end;
+        if (!iso.visibleColumns(r, 0.0f, 0.0f, (float)width, (float)height, begin, end)) continue;
+        colBegin = std::min(colBegin, begin);
+        colEnd = std::max(colEnd, end);
+    }
+    const int spanCols = colEnd - colBegin, spanRows = rowEnd - rowBegin;
+    std::vector<int> area((size_t)spanCols * spanRows, 0);
+    long long outside = 0, floatMismatches = 0;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            int col, row, floatCol, floatRow;
+            iso.pick(x, y, col, row);
+            iso.toGrid(x + 0.5f, y + 0.5f, floatCol, floatRow);
+            if (col != floatCol || row != floatRow) floatMismatches++;
+            if (col < colBegin || col >= colEnd || row < rowBegin || row >= rowEnd) {
+                outside++;
+                continue;
+            }
+            area[(size_t)(row - rowBegin) * spanCols + (col - colBegin)]++;
+        }
+    }
+    // tiles com o losango inteiro dentro da tela
+    int whole = 0, exact = 0;
+    for (int r = rowBegin; r < rowEnd; ++r) {
+        for (int c = colBegin; c < colEnd; ++c) {
+            glm::vec2 pos = iso.toScreen(c, r);
+            if (pos.x - tileW / 2.0f < 0.0f || pos.x + tileW / 2.0f > width || pos.y - tileH < 0.0f || pos.y > height) continue;
+            whole++;
+            if (area[(size_t)(r - rowBegin) * spanCols + (c - colBegin)] == tileW * tileH / 2) exact++;
+        }
+    }
+    std::cout << "  cobertura: " << exact << " de " << whole << " tiles inteiros com " << tileW * tileH / 2
+              << " pixels, " << outside << " pixels fora da janela de tiles, toGrid (float) discorda em "
+              << floatMismatches << " pixels" << std::endl;
+
+    std::mt19937 rng(11);
+    std::vector<int> xs(points), ys(points), cols(points), rows(points);
+    for (int i = 0; i < points; ++i) {
+        xs[i] = rng() % width;
+        ys[i] = rng() % height;
+    }
+    long long checksum = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < points; ++i) {
+        int col, row;
+        if (iso.toGrid(xs[i] + 0.5f, ys[i] + 0.5f, col, row)) checksum += col + row;
+    }
+    double floatSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    start = Clock::now();
+    for (int i = 0; i < points; ++i) {
+        int col, row;
+        if (iso.pick(xs[i], ys[i], col, row)) checksum += col + row;
+    }
+    double pickSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    start = Clock::now();
+    iso.pickMany(xs.data(), ys.data(), points, cols.data(), rows.data());
+    double manySeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    for (int i = 0; i < points; ++i) checksum += cols[i] + rows[i];
+
+    std::cout << "  " << points << " pontos: toGrid " << (floatSeconds > 0.0 ? points / floatSeconds / 1e6 : 0.0)
+              << " M/s, pick " << (pickSeconds > 0.0 ? points / pickSeconds / 1e6 : 0.0) << " M/s, pickMany "
+              << (manySeconds > 0.0 ? points / manySeconds / 1e6 : 0.0) << " M/s (soma " << checksum << ")" << std::endl;
+    return exact == whole ? 0 : 1;
 }
 
-GLuint compile_shader(const char* source, GLenum type) {
-    GLuint shader = glCreateShader(type);
-    glShaderSource(shader, 1, &source, NULL);
-    glCompileShader(shader);
+// Jogador automático do --sessions: a cada BOT_THINK_TICKS ticks anda para
+// uma direção sorteada ou, uma vez em quatro, clica em um tile sorteado (o
+// A* da sessão); depois de vitória ou derrota, reseta. Cada bot tem semente
+// própria, então o resultado não depende de qual thread avançou a sessão.
+struct SessionBot {
+    static const int BOT_THINK_TICKS = 8;
+    std::mt19937 rng;
+    int wins = 0;
+    int losses = 0;
+
+    explicit SessionBot(uint32_t seed) : rng(seed) {}
+
+    void act(GameSession& session) {
+        if (session.getSimulationTick() % BOT_THINK_TICKS != 0) return;
+        if (session.isGameOver() || session.hasGameWon()) {
+            (session.hasGameWon() ? wins : losses)++;
+            session.queueCommand(CommandId::RESET);
+            return;
+        }
+        if (rng() % 4 == 0) {
+            const uint32_t tiles = (uint32_t)session.getMapRows() * session.getMapCols();
+            session.queueCommand(CommandId::MOVE_TO, rng() % tiles);
+        } else {
+            session.queueCommand(static_cast<CommandId>(rng() % 8));
+        }
+    }
+};
 
-    int success;
-    char infoLog[512];
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(shader, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::COMPILATION_FAILED\n" << infoLog << std::endl;
+// Avança N sessões independentes no mesmo mapa por T ticks, com um bot em
+// cada uma, e mede sessões-ticks por segundo. Uma passada em uma thread e,
+// havendo mais núcleos, outra no pool com roubo de trabalho; os ticks vão em
+// lotes de SESSION_BATCH_TICKS por sessão, então cada thread fica com as
+// mesmas sessões (e os dados delas no cache) de um lote para o outro. O hash
+// de todas as sessões no fim precisa ser o mesmo nas duas passadas.
+int runSessions(const std::string& mapPath, int sessionCount, int ticks, int enemyCount) {
+    typedef std::chrono::high_resolution_clock Clock;
+    const int SESSION_BATCH_TICKS = 60;
+
+    GameSession source;
+    source.setQuiet(true);
+    source.setParallel(false);
+    if (!source.initialize(mapPath)) {
+        LOG_ERROR("Erro ao carregar mapa %s", mapPath.c_str());
+        return -1;
+    }
+    std::cout << "Sessoes sem janela: " << sessionCount << " no mapa " << mapPath << " (" << source.getMapCols() << "x"
+              << source.getMapRows() << "), " << ticks << " ticks cada, " << enemyCount << " inimigos por sessao" << std::endl;
+
+    const int cores = std::max(1, (int)std::thread::hardware_concurrency());
+    uint64_t hashes[2] = { 0, 0 };
+    const int passes = cores > 1 ? 2 : 1;
+    for (int pass = 0; pass < passes; ++pass) {
+        WorkerPool pool(pass == 0 ? 1 : cores);
+
+        auto setupStart = Clock::now();
+        std::vector<std::unique_ptr<GameSession>> sessions;
+        std::vector<SessionBot> bots;
+        sessions.reserve(sessionCount);
+        bots.reserve(sessionCount);
+        for (int i = 0; i < sessionCount; ++i) {
+            sessions.emplace_back(new GameSession());
+            GameSession& session = *sessions.back();
+            session.setQuiet(true);
+            session.setParallel(false);
+            session.initializeFrom(source);
+            if (enemyCount > 0) session.queueCommand(CommandId::SPAWN_ENEMIES, static_cast<uint32_t>(enemyCount));
+            bots.push_back(SessionBot(static_cast<uint32_t>(i) + 1));
+        }
+        double setupSeconds = std::chrono::duration<double>(Clock::now() - setupStart).count();
+
+        auto start = Clock::now();
+        long long steals = 0;
+        for (int done = 0; done < ticks; done += SESSION_BATCH_TICKS) {
+            const int batch = std::min(SESSION_BATCH_TICKS, ticks - done);
+            pool.parallelForStealing(sessionCount, [&](int i, int) {
+                GameSession& session = *sessions[i];
+                for (int t = 0; t < batch; ++t) {
+                    bots[i].act(session);
+                    session.tick();
+                }
+            });
+            steals += pool.getLastSteals();
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        uint64_t hash = fnv1a(nullptr, 0);
+        int wins = 0, losses = 0;
+        for (int i = 0; i < sessionCount; ++i) {
+            uint64_t sessionHash = sessions[i]->stateHash();
+            hash = fnv1a(&sessionHash, sizeof(sessionHash), hash);
+            wins += bots[i].wins;
+            losses += bots[i].losses;
+        }
+        hashes[pass] = hash;
+
+        const double sessionTicks = (double)sessionCount * ticks;
+        std::cout << "  " << pool.getThreadCount() << " thread(s): " << seconds * 1000.0 << " ms, "
+                  << (seconds > 0.0 ? sessionTicks / seconds : 0.0) << " sessoes-ticks/s ("
+                  << (seconds > 0.0 ? sessionTicks * source.getSimulationStep() / seconds : 0.0) << "x o tempo real somado), "
+                  << steals << " roubos; criacao " << setupSeconds * 1000.0 << " ms; " << wins << " vitorias, " << losses
+                  << " derrotas; hash " << std::hex << hash << std::dec << std::endl;
     }
-    return shader;
+    if (passes == 2 && hashes[0] != hashes[1]) {
+        std::cerr << "Estado final diferente entre as passadas: as sessoes nao sao independentes." << std::endl;
+        return 1;
+    }
+    return 0;
 }
 
-int main() {
+int main(int argc, char** argv) {
     std::cout << "---- Jogo Iniciado ----" << std::endl;
 
+    std::string mapPath = "map.txt";
+    bool mapGiven = false;
+    std::string recordPath, replayPath;
+    int benchQueries = 0;
+    int benchEntities = 0;
+    int benchSpatial = 0;
+    int benchPicking = 0;
+    int enemyCount = 0;
+    int sessionCount = 0;
+    int sessionTicks = 3600;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--stream") {
+            GameManager::getInstance()->enableStreaming(64u << 20);
+        } else if (arg == "--stream-budget" && i + 1 < argc) {
+            GameManager::getInstance()->enableStreaming(static_cast<size_t>(atoi(argv[++i])) << 20);
+        } else if (arg == "--idle") {
+            GameManager::getInstance()->setIdleRendering(true);
+        } else if (arg == "--sync-assets") {
+            GameManager::getInstance()->setSyncAssets(true);
+        } else if (arg == "--tick-rate" && i + 1 < argc) {
+            GameManager::getInstance()->setSimulationRate(atof(argv[++i]));
+        } else if (arg == "--sim-speed" && i + 1 < argc) {
+            GameManager::getInstance()->setSimulationSpeed(atof(argv[++i]));
+        } else if (arg == "--record" && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (arg == "--bench-paths" && i + 1 < argc) {
+            benchQueries = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--bench-ecs" && i + 1 < argc) {
+            benchEntities = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--bench-spatial" && i + 1 < argc) {
+            benchSpatial = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--bench-picking" && i + 1 < argc) {
+            benchPicking = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--enemies" && i + 1 < argc) {
+            enemyCount = std::max(0, atoi(argv[++i]));
+        } else if (arg == "--sessions" && i + 1 < argc) {
+            sessionCount = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--ticks" && i + 1 < argc) {
+            sessionTicks = std::max(1, atoi(argv[++i]));
+        } else {
+            mapPath = arg;
+            mapGiven = true;
+        }
+    }
+
+    // Benchmark do A*: no mapa dado, ou em um mapa sintético de 1024x1024.
+    if (benchQueries > 0) {
+        GameManager* game = GameManager::getInstance();
+        int result = 0;
+        if (mapGiven) {
+            result = game->initializeHeadless(mapPath) ? runPathBenchmark(game->getWalkMask(), benchQueries) : -1;
+        } else {
+            WalkMask mask;
+            buildBenchmarkMask(mask, 1024);
+            result = runPathBenchmark(mask, benchQueries);
+        }
+        delete game;
+        return result;
+    }
+
+    if (benchEntities > 0) {
+        return runEcsBenchmark(benchEntities);
+    }
+    if (benchSpatial > 0) {
+        return runSpatialBenchmark(benchSpatial);
+    }
+    if (benchPicking > 0) {
+        return runPickingBenchmark(benchPicking);
+    }
+    if (sessionCount > 0) {
+        return runSessions(mapPath, sessionCount, sessionTicks, enemyCount);
+    }
+
+    // Replay: sem janela nem contexto GL, só a lógica em passo fixo.
+    if (!replayPath.empty()) {
+        InputReplay replay;
+        std::string error;
+        if (!replay.open(replayPath, error)) {
+            std::cerr << "Erro ao abrir replay " << replayPath << ": " << error << std::endl;
+            return -1;
+        }
+        if (!mapGiven) mapPath = replay.getHeader().mapPath;
+
+        GameManager* game = GameManager::getInstance();
+        game->setSimulationStep(replay.getHeader().tickStep);
+        int result = game->initializeHeadless(mapPath) ? game->runReplay(replay) : -1;
+        delete game;
+        return result;
+    }
+
     if (!glfwInit()) {
-        std::cerr << "Falha ao inicializar GLFW" << std::endl;
+        LOG_ERROR("Falha ao inicializar GLFW");
         return -1;
     }
 
@@ -939,36 +2359,62 @@ int main() {
 
     GLFWwindow* window = glfwCreateWindow(1920, 1080, "Trabalho GB - Conrado Maia e Gabriel Figueiredo", NULL, NULL);
     if (!window) {
-        std::cerr << "Falha ao criar janela GLFW" << std::endl;
+        LOG_ERROR("Falha ao criar janela GLFW");
         glfwTerminate();
         return -1;
     }
     glfwMakeContextCurrent(window);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetKeyCallback(window, key_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
+    glfwSetWindowRefreshCallback(window, window_refresh_callback);
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cerr << "Falha ao inicializar GLAD" << std::endl;
+        LOG_ERROR("Falha ao inicializar GLAD");
         return -1;
     }
 
-    GameManager::getInstance()->initialize(window);
+    GameManager::getInstance()->initialize(window, mapPath);
+    if (!recordPath.empty()) {
+        GameManager::getInstance()->startRecording(recordPath, mapPath);
+    }
+    // como comando, para entrar na gravação e o replay criar os mesmos inimigos
+    if (enemyCount > 0) {
+        GameManager::getInstance()->queueCommand(CommandId::SPAWN_ENEMIES, static_cast<uint32_t>(enemyCount));
+    }
 
     double lastFrameTime = glfwGetTime();
 
     while (!glfwWindowShouldClose(window)) {
+        GameManager* game = GameManager::getInstance();
+
+        // No modo ocioso o loop dorme até um evento de entrada ou o próximo
+        // quadro de animação, e só redesenha quando algo mudou.
+        if (game->isIdleRendering()) {
+            double timeout = game->secondsUntilNextUpdate();
+            if (timeout > 0.0) {
+                glfwWaitEventsTimeout(timeout);
+            } else {
+                glfwPollEvents();
+            }
+        } else {
+            glfwPollEvents();
+        }
+
         double currentFrameTime = glfwGetTime();
         float deltaTime = static_cast<float>(currentFrameTime - lastFrameTime);
         lastFrameTime = currentFrameTime;
 
-        glfwPollEvents();
-
-        GameManager::getInstance()->update(deltaTime);
-        GameManager::getInstance()->render();
+        game->update(deltaTime);
+        if (!game->isIdleRendering() || game->needsRedraw()) {
+            game->render();
+        }
     }
 
+    GameManager::getInstance()->finishRecording();
+    const int result = GameManager::getInstance()->hasFailed() ? -1 : 0;
     delete GameManager::getInstance();
     glfwTerminate();
 
-    return 0;
+    return result;
 }
\ No newline at end of file
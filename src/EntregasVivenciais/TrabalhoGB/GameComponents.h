@@ -0,0 +1,101 @@
+#ifndef GameComponents_h
+#define GameComponents_h
+
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+#include "AnimationClips.h"
+#include "Ecs.h"
+#include "FlowField.h"
+#include "IsoProjection.h"
+#include "SpatialHash.h"
+
+// Componentes e sistemas das entidades do GB (jogador e inimigos). Nada aqui
+// usa GL: o desenho só lê Transform, Animation e Sprite.
+
+struct GridPosition {
+    int col;
+    int row;
+};
+
+// posição no início do tick, para interpolar o desenho até GridPosition
+struct PreviousGridPosition {
+    int col;
+    int row;
+};
+
+// ponto de apoio na tela (o canto de baixo do losango do tile), já interpolado
+struct Transform {
+    glm::vec2 position;
+};
+
+// índice na AnimationClipTable e o tempo simulado em que o clipe começou;
+// o quadro é calculado por quem precisa dele (o shader, ou clipFrame)
+struct Animation {
+    int clip;
+    double startTime;
+};
+
+// índice na tabela de spritesheets de quem desenha
+struct Sprite {
+    int sheet;
+};
+
+struct PlayerTag {};
+struct EnemyTag {};
+
+// Início do tick: a posição atual passa a ser a anterior. Devolve quantas
+// entidades ainda estavam sendo interpoladas.
+inline int savePreviousPositions(EntityWorld& world) {
+    int moving = 0;
+    world.each<GridPosition, PreviousGridPosition>([&](GridPosition& grid, PreviousGridPosition& previous) {
+        moving += (grid.col != previous.col || grid.row != previous.row) ? 1 : 0;
+        previous.col = grid.col;
+        previous.row = grid.row;
+    });
+    return moving;
+}
+
+// Tempo simulado, a partir de 'now', até a próxima troca de quadro de
+// qualquer entidade. Só o modo ocioso pergunta isso, uma vez por troca.
+inline double secondsToNextFrame(const EntityWorld& world, const AnimationClipTable& clips, double now) {
+    double seconds = 1e9;
+    world.each<Animation>([&](const Animation& animation) {
+        seconds = std::min(seconds, secondsToNextClipFrame(clips.get(animation.clip), now - animation.startTime, 1e9));
+    });
+    return seconds;
+}
+
+// Um passo de cada inimigo pela direção do campo no tile em que está. Um
+// inimigo não entra em tile ocupado por outra entidade, a não ser o alvo do
+// campo (o jogador); o hash acompanha cada passo. Devolve quantos andaram.
+inline int followFlowField(EntityWorld& world, const FlowField& field, SpatialHash& hash) {
+    const int goalCol = field.getGoalCol();
+    const int goalRow = field.getGoalRow();
+    int moved = 0;
+    world.eachEntity<GridPosition, EnemyTag>([&](Entity entity, GridPosition& grid, EnemyTag&) {
+        int col = grid.col, row = grid.row;
+        if (!field.step(col, row)) return;
+        if ((col != goalCol || row != goalRow) && hash.countAt(col, row) > 0) return;
+        grid.col = col;
+        grid.row = row;
+        hash.move(entity.index, col, row);
+        moved++;
+    });
+    return moved;
+}
+
+// Posição de tela de cada entidade entre a do tick anterior e a atual.
+inline void updateTransforms(EntityWorld& world, const IsoProjection& iso, float alpha, WorkerPool* pool) {
+    auto interpolate = [&](const GridPosition& grid, const PreviousGridPosition& previous, Transform& transform) {
+        transform.position = glm::mix(iso.toScreen(previous.col, previous.row), iso.toScreen(grid.col, grid.row), alpha);
+    };
+    if (pool) {
+        world.eachParallel<GridPosition, PreviousGridPosition, Transform>(*pool, interpolate);
+    } else {
+        world.each<GridPosition, PreviousGridPosition, Transform>(interpolate);
+    }
+}
+
+#endif /* GameComponents_h */
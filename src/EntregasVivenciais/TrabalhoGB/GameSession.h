@@ -0,0 +1,1175 @@
+#ifndef GameSession_h
+#define GameSession_h
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "TileGrid.h"
+#include "MapFile.h"
+#include "ChunkStreamer.h"
+#include "InputLog.h"
+#include "GameComponents.h"
+#include "HierarchicalPathFinder.h"
+#include "PathFinder.h"
+#include "TileTypeIndex.h"
+#include "WorkerPool.h"
+#include "AsyncLog.h"
+
+// Estado e regras de uma partida do GB (mapa, jogador, moedas, lava, vitória,
+// inimigos), sem GL nem GLFW. O GameManager desenha e alimenta uma sessão a
+// partir da janela; o modo --sessions roda milhares delas ao mesmo tempo,
+// cada uma avançada por uma thread de cada vez.
+
+enum class AnimationType {
+    IDLE_FRONT = 0,
+    IDLE_LEFT,
+    IDLE_RIGHT,
+    IDLE_BACK
+};
+
+// Comandos do jogador; o valor é o gravado no log de entradas (InputLog.h).
+enum class CommandId : unsigned char {
+    MOVE_UP = 0,
+    MOVE_DOWN,
+    MOVE_LEFT,
+    MOVE_RIGHT,
+    MOVE_UP_LEFT,
+    MOVE_UP_RIGHT,
+    MOVE_DOWN_LEFT,
+    MOVE_DOWN_RIGHT,
+    RESET,
+    MOVE_TO,            // clique: o argumento é o índice do tile de destino
+    SPAWN_ENEMIES,      // --enemies: o argumento é a quantidade
+    COUNT
+};
+
+struct QueuedCommand {
+    CommandId id;
+    uint32_t arg;
+};
+
+// Tileset descrito no arquivo do mapa; só quem desenha usa.
+struct TilesetInfo {
+    std::string path;
+    int cols = 0;
+    int rows = 0;
+    int tileWidth = 0;
+    int tileHeight = 0;
+};
+
+// Avisos da sessão para quem desenha. Chamados dentro de tick(), na thread
+// que avança a sessão.
+class SessionListener {
+public:
+    virtual ~SessionListener() {}
+    virtual void onTileChanged(int /*r*/, int /*c*/) {}
+    virtual void onMapReplaced() {}                         // reset ou preenchimento do mapa inteiro
+    virtual void onPlayerMoved() {}
+    virtual void onChunkLoaded(StreamedChunk& /*chunk*/) {}
+    virtual void onChunkEvicted(StreamedChunk& /*chunk*/) {}
+};
+
+// Acesso à entidade do jogador no EntityWorld da sessão. Não tem estado
+// próprio: posição e animação são componentes, e o desenho é o mesmo das
+// outras entidades (GameManager::renderEntities).
+class GameCharacter {
+public:
+    GameCharacter(EntityWorld& world, SpatialHash& hash, Entity entity) : world(&world), hash(&hash), entity(entity) {}
+
+    Entity getEntity() const { return entity; }
+    int getRow() const { return world->get<GridPosition>(entity)->row; }
+    int getCol() const { return world->get<GridPosition>(entity)->col; }
+
+    // posiciona sem interpolar (início e reset)
+    void setGridPosition(int r, int c) {
+        GridPosition* grid = world->get<GridPosition>(entity);
+        PreviousGridPosition* previous = world->get<PreviousGridPosition>(entity);
+        grid->row = r;
+        grid->col = c;
+        previous->row = r;
+        previous->col = c;
+        hash->move(entity.index, c, r);
+    }
+
+    // movimento dentro de um tick: o desenho interpola a partir da posição anterior
+    void moveTo(int r, int c) {
+        GridPosition* grid = world->get<GridPosition>(entity);
+        grid->row = r;
+        grid->col = c;
+        hash->move(entity.index, c, r);
+    }
+
+    bool isInterpolating() const {
+        const GridPosition* grid = world->get<GridPosition>(entity);
+        const PreviousGridPosition* previous = world->get<PreviousGridPosition>(entity);
+        return grid->row != previous->row || grid->col != previous->col;
+    }
+
+    // O clipe do jogador é o próprio AnimationType. Só recomeça do primeiro
+    // quadro se o clipe mudar; devolve se mudou.
+    bool setAnimationType(AnimationType type, double now) {
+        Animation* animation = world->get<Animation>(entity);
+        if (animation->clip == static_cast<int>(type)) return false;
+        animation->clip = static_cast<int>(type);
+        animation->startTime = now;
+        return true;
+    }
+
+    AnimationType getAnimationType() const { return static_cast<AnimationType>(world->get<Animation>(entity)->clip); }
+    double getAnimationStart() const { return world->get<Animation>(entity)->startTime; }
+
+private:
+    EntityWorld* world;
+    SpatialHash* hash;
+    Entity entity;
+};
+
+class GameSession;
+
+// Os comandos não têm estado, então uma instância de cada serve a todas as
+// sessões (commandFor).
+class MovementCommand {
+public:
+    virtual void execute(GameSession& session) const = 0;
+    // comandos que continuam valendo depois de vitória ou derrota
+    virtual bool allowedAfterGameEnd() const { return false; }
+    virtual ~MovementCommand() {}
+};
+
+class MoveUpCommand : public MovementCommand {
+public:
+    void execute(GameSession& session) const override;
+};
+
+class MoveDownCommand : public MovementCommand {
+public:
+    void execute(GameSession& session) const override;
+};
+
+class MoveLeftCommand : public MovementCommand {
+public:
+    void execute(GameSession& session) const override;
+};
+
+class MoveRightCommand : public MovementCommand {
+public:
+    void execute(GameSession& session) const override;
+};
+
+class MoveUpLeftCommand : public MovementCommand {
+public:
+    void execute(GameSession& session) const override;
+};
+
+class MoveUpRightCommand : public MovementCommand {
+public:
+    void execute(GameSession& session) const override;
+};
+
+class MoveDownLeftCommand : public MovementCommand {
+public:
+    void execute(GameSession& session) const override;
+};
+
+class MoveDownRightCommand : public MovementCommand {
+public:
+    void execute(GameSession& session) const override;
+};
+
+class ResetGameCommand : public MovementCommand {
+public:
+    void execute(GameSession& session) const override;
+    bool allowedAfterGameEnd() const override { return true; }
+};
+
+// nullptr para MOVE_TO e SPAWN_ENEMIES, tratados pela própria sessão
+inline const MovementCommand* commandFor(CommandId id) {
+    static const MoveUpCommand up;
+    static const MoveDownCommand down;
+    static const MoveLeftCommand left;
+    static const MoveRightCommand right;
+    static const MoveUpLeftCommand upLeft;
+    static const MoveUpRightCommand upRight;
+    static const MoveDownLeftCommand downLeft;
+    static const MoveDownRightCommand downRight;
+    static const ResetGameCommand reset;
+    static const MovementCommand* const commands[static_cast<int>(CommandId::COUNT)] = {
+        &up, &down, &left, &right, &upLeft, &upRight, &downLeft, &downRight, &reset, nullptr, nullptr
+    };
+    return commands[static_cast<int>(id)];
+}
+
+class GameSession {
+public:
+    static constexpr int TILE_MOEDA = 0;
+    static constexpr int TILE_CHAO = 1;
+    static constexpr int TILE_PAREDE = 2;
+    static constexpr int TILE_LAVA = 3;
+    static constexpr int TILE_INICIO = 4;
+    static constexpr int TILE_AGUA = 5;
+    static constexpr int TILE_VICTORY_EFFECT_TILE_ID = 6;
+
+    // índices de Sprite::sheet; a tabela de spritesheets é de quem desenha
+    static constexpr int SHEET_PLAYER = 0;
+    static constexpr int SHEET_ENEMIES = 1;
+    static constexpr int ENEMY_KINDS = 12;                 // linhas da spritesheet
+    static constexpr int ENEMY_FRAMES = 2;
+
+    GameSession() : entity_hash(2, 4), player_char(nullptr), listener(nullptr) {
+        registerAnimationClips();
+    }
+
+    ~GameSession() {
+        streamer.stop();
+        delete player_char;
+    }
+
+    GameSession(const GameSession&) = delete;
+    GameSession& operator=(const GameSession&) = delete;
+
+    // Antes de initialize: o mapa passa a ser lido sob demanda de um .gbmap.
+    // extraBytesPerTile é o que quem desenha guarda por tile de cada chunk.
+    void enableStreaming(size_t budgetBytes, size_t extraBytesPerTile) {
+        streaming = true;
+        stream_budget_bytes = budgetBytes;
+        stream_extra_bytes = extraBytesPerTile;
+    }
+
+    bool initialize(const std::string& mapPath) {
+        bool loaded = streaming ? openStreamingMap(mapPath) : loadMapConfig(mapPath);
+        if (!loaded) return false;
+        if (streaming) {
+            findStreamingStart();
+        } else {
+            scanInitialMap();
+            rebuildWalkMask();
+            initial_walk_mask = std::make_shared<const WalkMask>(walk_mask);
+            initial_hierarchical_finder = std::make_shared<const HierarchicalPathFinder>(hierarchical_finder);
+        }
+        if (!quiet) LOG_INFO("Total de moedas no mapa: %d", total_coins_on_map);
+        createPlayer();
+        placePlayer();
+        return true;
+    }
+
+    // Mesmo mapa de outra sessão já inicializada, sem ler o arquivo de novo.
+    // Sem streaming.
+    void initializeFrom(const GameSession& source) {
+        tileset = source.tileset;
+        MAP_ROWS = source.MAP_ROWS;
+        MAP_COLS = source.MAP_COLS;
+        initial_game_map.copyFrom(source.initial_game_map);
+        game_map.copyFrom(initial_game_map);
+        scenery_layers = source.scenery_layers;
+        initial_tile_index = source.initial_tile_index;
+        tile_index = initial_tile_index;
+        total_coins_on_map = source.total_coins_on_map;
+        start_row = source.start_row;
+        start_col = source.start_col;
+        sim_step = source.sim_step;
+        resizeEntityHash();
+        // máscara e grafo prontos da fonte: nenhum HPA* refeito por sessão
+        initial_walk_mask = source.initial_walk_mask;
+        initial_hierarchical_finder = source.initial_hierarchical_finder;
+        restoreInitialWalkMask();
+        createPlayer();
+        placePlayer();
+    }
+
+    void setListener(SessionListener* value) { listener = value; }
+    // sem pool, o campo de fluxo é calculado na thread que avança a sessão
+    void setParallel(bool enabled) { parallel = enabled; }
+    void setVerbose(bool enabled) { verbose = enabled; }
+    // nada no console, nem os avisos de fim de jogo
+    void setQuiet(bool enabled) {
+        quiet = enabled;
+        if (quiet) verbose = false;
+    }
+    void setStreamRadius(int radius) { stream_radius = radius; }
+
+    void setSimulationStep(double seconds) {
+        if (seconds > 0.0) sim_step = seconds;
+    }
+    double getSimulationStep() const { return sim_step; }
+    long long getSimulationTick() const { return sim_tick; }
+    // tempo simulado; é o relógio das animações (Animation::startTime)
+    double simTime() const { return sim_tick * sim_step; }
+    const AnimationClipTable& getAnimationClips() const { return animation_clips; }
+
+    void queueCommand(CommandId command, uint32_t arg = 0) {
+        QueuedCommand queued = { command, arg };
+        pending_commands.push_back(queued);
+    }
+
+    void tick() {
+        if (savePreviousPositions(world) > 0) {
+            changed = true;
+        }
+        enemies_moved = false;
+
+        // comandos de entrada são aplicados no tick, na ordem em que chegaram
+        for (const QueuedCommand& queued : pending_commands) {
+            if (queued.id == CommandId::MOVE_TO || queued.id == CommandId::SPAWN_ENEMIES) {
+                recorder.record(static_cast<uint64_t>(sim_tick), static_cast<uint8_t>(queued.id), queued.arg);
+                if (queued.id == CommandId::SPAWN_ENEMIES) spawnEnemies(static_cast<int>(queued.arg));
+                else if (!game_over && !game_won) startPathTo(static_cast<int>(queued.arg));
+                continue;
+            }
+            recorder.record(static_cast<uint64_t>(sim_tick), static_cast<uint8_t>(queued.id));
+            // uma tecla de movimento cancela o caminho do clique
+            player_path.clear();
+            const MovementCommand* command = commandFor(queued.id);
+            if ((game_over || game_won) && !command->allowedAfterGameEnd()) continue;
+            command->execute(*this);
+        }
+        pending_commands.clear();
+        advancePath();
+        updateEnemies();
+
+        if (game_won && !effect_applied) {
+            fillMap(TILE_VICTORY_EFFECT_TILE_ID);
+            effect_applied = true;
+        } else if (game_over && game_ended_by_lava && !effect_applied) {
+            fillMap(TILE_LAVA);
+            effect_applied = true;
+        }
+
+        if (streaming && player_char) {
+            streamer.update(player_char->getRow(), player_char->getCol(), stream_radius);
+            streamer.pump(4);
+        }
+        sim_tick++;
+        // as animações não têm estado por tick: só se avisa quem desenha
+        // quando alguma delas troca de quadro
+        if (simTime() >= nextFrameTime()) {
+            changed = true;
+            next_frame_known = false;
+        }
+    }
+
+    // se algo visível mudou desde a última chamada
+    bool takeChanged() {
+        bool value = changed;
+        changed = false;
+        return value;
+    }
+
+    // Tempo simulado até algo mudar sem entrada nova: a troca de quadro de
+    // alguma entidade, o próximo passo dos inimigos, ou o próximo tick se o
+    // jogador ou os inimigos ainda estão sendo interpolados ou há comandos na fila.
+    double secondsToNextChange() const {
+        if (!player_char) return 0.0;
+        double simSeconds = std::max(0.0, nextFrameTime() - simTime());
+        if (player_char->isInterpolating() || !pending_commands.empty() || !player_path.empty() || enemies_moved) {
+            simSeconds = std::min(simSeconds, sim_step);
+        }
+        if (enemy_count > 0 && !game_over && !game_won) {
+            simSeconds = std::min(simSeconds, (enemy_cooldown + 1) * sim_step);
+        }
+        return simSeconds;
+    }
+
+    void processPlayerMovement(int new_row, int new_col) {
+        if (!player_char) return;
+        if (new_row < 0 || new_row >= MAP_ROWS || new_col < 0 || new_col >= MAP_COLS) return;
+        int target_tile_id = getTileId(new_row, new_col);
+
+        if (target_tile_id < 0) {
+            return;
+        }
+        if (target_tile_id == TILE_PAREDE) {
+            if (verbose) LOG_DEBUG("Tile (%d, %d) não é caminhável (Parede).", new_col, new_row);
+            return;
+        }
+        if (target_tile_id == TILE_AGUA) {
+            if (verbose) LOG_DEBUG("Tile (%d, %d) não é caminhável (Água).", new_col, new_row);
+            return;
+        }
+        if (target_tile_id == TILE_LAVA) {
+            game_over = true;
+            game_ended_by_lava = true;
+            if (!quiet) LOG_INFO("Você morreu na lava! Fim de jogo.");
+            return;
+        }
+
+        player_char->moveTo(new_row, new_col);
+        checkEnemyContact();
+        if (listener) listener->onPlayerMoved();
+        if (verbose) LOG_DEBUG("Player movido para (%d, %d)", player_char->getCol(), player_char->getRow());
+
+        if (target_tile_id == TILE_MOEDA) {
+            items_collected++;
+            setTile(player_char->getRow(), player_char->getCol(), TILE_CHAO);
+            if (verbose) LOG_DEBUG("Moeda coletada! Total: %d", items_collected);
+
+            const bool allCollected = streaming ? items_collected == total_coins_on_map
+                                                : tile_index.count(static_cast<TileId>(TILE_MOEDA)) == 0;
+            if (allCollected) {
+                game_won = true;
+                if (!quiet) LOG_INFO("Parabens! Voce coletou todas as moedas e venceu o jogo!");
+            }
+        }
+    }
+
+    void setPlayerAnimation(AnimationType type) {
+        if (player_char && player_char->setAnimationType(type, simTime())) {
+            next_frame_known = false;
+        }
+    }
+
+    void resetGame() {
+        items_collected = 0;
+        game_over = false;
+        game_won = false;
+        game_ended_by_lava = false;
+        effect_applied = false;
+
+        if (streaming) {
+            streamer.resetEdits();
+            findStreamingStart();
+        } else {
+            game_map.copyFrom(initial_game_map);
+            tile_index = initial_tile_index;
+            restoreInitialWalkMask();
+        }
+        if (listener) listener->onMapReplaced();
+
+        if (player_char) {
+            if (start_row != -1 && start_col != -1) {
+                player_char->setGridPosition(start_row, start_col);
+            } else {
+                player_char->setGridPosition(0, 0);
+            }
+            setPlayerAnimation(AnimationType::IDLE_FRONT);
+            if (listener) listener->onPlayerMoved();
+        }
+        if (enemy_count > 0) spawnEnemies(enemy_count);
+        if (!quiet) LOG_INFO("Jogo resetado!");
+    }
+
+    int getTileId(int r, int c) const {
+        if (r >= 0 && r < MAP_ROWS && c >= 0 && c < MAP_COLS) {
+            if (streaming) {
+                TileId tile = streamer.getTile(r, c);
+                return tile == MAP_EMPTY_TILE ? -1 : tile;
+            }
+            return game_map.get(c, r);
+        }
+        return -1;
+    }
+
+    // Consulta do índice por tipo, sem percorrer o mapa: a moeda mais próxima do
+    // jogador e quanta lava há em volta dele.
+    void reportNearestCoin() const {
+        if (streaming || !player_char) return;
+        const int col = player_char->getCol();
+        const int row = player_char->getRow();
+        const int lava = tile_index.countInRect(static_cast<TileId>(TILE_LAVA), col - LAVA_WARNING_RADIUS, row - LAVA_WARNING_RADIUS,
+                                                col + LAVA_WARNING_RADIUS, row + LAVA_WARNING_RADIUS);
+        int coinCol, coinRow;
+        if (tile_index.nearest(static_cast<TileId>(TILE_MOEDA), col, row, coinCol, coinRow)) {
+            LOG_INFO("Moeda mais proxima em (%d, %d), restam %d; %d tile(s) de lava a ate %d tiles.", coinCol, coinRow,
+                     tile_index.count(static_cast<TileId>(TILE_MOEDA)), lava, LAVA_WARNING_RADIUS);
+        } else {
+            LOG_INFO("Nenhuma moeda restante; %d tile(s) de lava a ate %d tiles.", lava, LAVA_WARNING_RADIUS);
+        }
+    }
+
+    bool startRecording(const std::string& path, const std::string& mapPath) {
+        std::string error;
+        if (!recorder.open(path, sim_step, mapPath, error)) {
+            LOG_ERROR("Erro ao iniciar gravacao: %s", error.c_str());
+            return false;
+        }
+        LOG_INFO("Gravando entradas em %s", path.c_str());
+        return true;
+    }
+
+    void finishRecording() {
+        if (recorder.isOpen()) {
+            recorder.finish(static_cast<uint64_t>(sim_tick), stateHash());
+        }
+    }
+
+    // Executa o log inteiro, tão rápido quanto a CPU permitir.
+    int runReplay(InputReplay& replay) {
+        verbose = false;
+        auto start = std::chrono::high_resolution_clock::now();
+        uint8_t command;
+        uint32_t arg;
+        while (static_cast<uint64_t>(sim_tick) < replay.getEndTick()) {
+            while (replay.pop(static_cast<uint64_t>(sim_tick), command, arg)) {
+                if (command >= static_cast<uint8_t>(CommandId::COUNT)) {
+                    LOG_ERROR("Comando invalido no log: %d", (int)command);
+                    return 1;
+                }
+                queueCommand(static_cast<CommandId>(command), arg);
+            }
+            tick();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        // o resultado vai direto para o console, depois do que ficou no log
+        AsyncLog::get().flush();
+        std::cout << "Replay: " << sim_tick << " ticks, " << replay.eventCount() << " comandos em " << seconds * 1000.0 << " ms ("
+                  << (seconds > 0.0 ? sim_tick / seconds : 0.0) << " ticks/s, "
+                  << (seconds > 0.0 ? sim_tick * sim_step / seconds : 0.0) << "x o tempo real)" << std::endl;
+
+        uint64_t hash = stateHash();
+        if (hash != replay.getStateHash()) {
+            std::cerr << "Estado final divergente: esperado " << std::hex << replay.getStateHash() << ", obtido " << hash << std::dec << std::endl;
+            return 1;
+        }
+        std::cout << "Estado final confere com a gravacao (moedas: " << items_collected << "/" << total_coins_on_map << ")" << std::endl;
+        return 0;
+    }
+
+    // Resumo do estado da lógica para conferir replays.
+    uint64_t stateHash() const {
+        int values[9] = { (int)sim_tick, items_collected, total_coins_on_map, game_over, game_won, -1, -1, -1,
+                          (int)(player_path.size() - std::min(path_next, player_path.size())) };
+        if (player_char) {
+            values[5] = player_char->getRow();
+            values[6] = player_char->getCol();
+            const int clip = static_cast<int>(player_char->getAnimationType());
+            values[7] = clip * 100 + clipFrame(animation_clips.get(clip), simTime() - player_char->getAnimationStart());
+        }
+        uint64_t hash = fnv1a(values, sizeof(values));
+        if (!streaming) {
+            hash = fnv1a(game_map.data(), game_map.size(), hash);
+        }
+        // inimigos na ordem de armazenamento, que só depende dos comandos
+        world.each<GridPosition, EnemyTag>([&](const GridPosition& grid, const EnemyTag&) {
+            hash = fnv1a(&grid, sizeof(grid), hash);
+        });
+        return hash;
+    }
+
+    const TilesetInfo& getTileset() const { return tileset; }
+    int getMapRows() const { return MAP_ROWS; }
+    int getMapCols() const { return MAP_COLS; }
+    const TileGrid& getMap() const { return game_map; }
+    // Camada 0 é o mapa do jogo; as outras (decoração, sobreposição...) vêm
+    // das camadas seguintes de um .gbmap e só são desenhadas.
+    int getLayerCount() const { return 1 + (scenery_layers ? (int)scenery_layers->size() : 0); }
+    const TileGrid& getLayer(int layer) const { return layer == 0 ? game_map : (*scenery_layers)[layer - 1]; }
+    const WalkMask& getWalkMask() const { return walk_mask; }
+    // tiles da camada 0 por tipo; sem mapa em streaming
+    const TileTypeIndex& getTileIndex() const { return tile_index; }
+    bool isStreaming() const { return streaming; }
+    ChunkStreamer& getStreamer() { return streamer; }
+    const ChunkStreamer& getStreamer() const { return streamer; }
+    // quem desenha escreve os Transforms
+    EntityWorld& getWorld() { return world; }
+    const GameCharacter* getPlayer() const { return player_char; }
+    WorkerPool* getWorkerPool() const { return worker_pool.get(); }
+    int getStartRow() const { return start_row; }
+    int getStartCol() const { return start_col; }
+    int getItemsCollected() const { return items_collected; }
+    int getTotalCoins() const { return total_coins_on_map; }
+    bool isGameOver() const { return game_over; }
+    bool hasGameWon() const { return game_won; }
+
+private:
+    // O mapa carregado inteiro é indexado em int (TileGrid::index, os
+    // índices do GB, do TileTypeIndex e do MOVE_TO): col + row * cols, e o
+    // buffer de instâncias com todas as camadas, precisam caber em INT_MAX.
+    // Mapas maiores só em streaming, que indexa por chunk.
+    bool mapFitsInIntIndex(int cols, int rows, int layers) const {
+        if ((size_t)cols * rows * layers <= (size_t)INT_MAX) return true;
+        LOG_ERROR("Mapa %dx%d com %d camada(s) grande demais para ser carregado inteiro; use --stream", cols, rows, layers);
+        return false;
+    }
+
+    bool loadMapConfig(const std::string& filename) {
+        if (filename.size() > 6 && filename.compare(filename.size() - 6, 6, ".gbmap") == 0) {
+            return loadBinaryMap(filename);
+        }
+
+        std::ifstream file(filename);
+        if (!file.is_open()) {
+            LOG_ERROR("Erro ao abrir arquivo: %s", filename.c_str());
+            return false;
+        }
+
+        std::string line;
+        std::string temp_tileset_path;
+        int temp_tileset_cols, temp_tileset_rows, temp_tile_width, temp_tile_height;
+        int temp_map_rows = 0, temp_map_cols = 0;
+
+        std::getline(file, line);
+        std::istringstream iss_tileset(line);
+        std::string key_tileset;
+        iss_tileset >> key_tileset >> temp_tileset_path >> temp_tileset_cols >> temp_tileset_rows >> temp_tile_width >> temp_tile_height;
+
+        std::getline(file, line);
+        std::istringstream iss_dim(line);
+        std::string key_dim;
+        if (!(iss_dim >> key_dim >> temp_map_rows >> temp_map_cols) || temp_map_rows <= 0 || temp_map_cols <= 0) {
+            LOG_ERROR("Dimensoes do mapa invalidas: \"%s\"", line.c_str());
+            return false;
+        }
+
+        tileset.tileWidth = temp_tile_width;
+        tileset.tileHeight = temp_tile_height;
+        tileset.cols = temp_tileset_cols;
+        tileset.rows = temp_tileset_rows;
+        tileset.path = temp_tileset_path;
+        MAP_ROWS = temp_map_rows;
+        MAP_COLS = temp_map_cols;
+        if (!mapFitsInIntIndex(MAP_COLS, MAP_ROWS, 1)) return false;
+
+        std::getline(file, line);
+
+        initial_game_map.resize(MAP_COLS, MAP_ROWS);
+
+        for (int r = 0; r < MAP_ROWS; ++r) {
+            std::string row_str;
+            if (!std::getline(file, row_str)) {
+                LOG_ERROR("Dados do mapa incompletos durante recarregamento.");
+                file.close();
+                return false;
+            }
+            size_t first = row_str.find_first_not_of(" \t\n\r");
+            size_t last = row_str.find_last_not_of(" \t\n\r");
+            if (std::string::npos != first) {
+                row_str = row_str.substr(first, (last - first + 1));
+            } else {
+                row_str = "";
+            }
+
+            if ((int)row_str.length() != MAP_COLS) {
+                LOG_ERROR("Largura da linha do mapa incorreta durante recarregamento. Esperado %d, obtido %zu na linha: \"%s\"",
+                          MAP_COLS, row_str.length(), row_str.c_str());
+                file.close();
+                return false;
+            }
+            for (int c = 0; c < MAP_COLS; ++c) {
+                // um dígito por tile; qualquer outro caractere viraria um id sem sentido
+                if (row_str[c] < '0' || row_str[c] > '9') {
+                    LOG_ERROR("Tile invalido '%c' em (%d, %d)", row_str[c], c, r);
+                    return false;
+                }
+                initial_game_map.set(c, r, static_cast<TileId>(row_str[c] - '0'));
+            }
+        }
+        file.close();
+        game_map.copyFrom(initial_game_map);
+        if (!quiet) LOG_INFO("Configuração do mapa carregada.");
+        return true;
+    }
+
+    bool loadBinaryMap(const std::string& filename) {
+        MapFileReader reader;
+        std::string error;
+        if (!reader.open(filename, error)) {
+            LOG_ERROR("Erro ao abrir mapa binario %s: %s", filename.c_str(), error.c_str());
+            return false;
+        }
+
+        const MapFileHeader& header = reader.getHeader();
+        tileset.tileWidth = header.tileWidth;
+        tileset.tileHeight = header.tileHeight;
+        tileset.cols = header.tilesetCols;
+        tileset.rows = header.tilesetRows;
+        tileset.path = reader.getTilesetPath();
+        MAP_ROWS = reader.getRows();
+        MAP_COLS = reader.getCols();
+        if (!mapFitsInIntIndex(MAP_COLS, MAP_ROWS, reader.getLayerCount())) return false;
+
+        if (!reader.readLayer(0, initial_game_map)) {
+            LOG_ERROR("Chunk corrompido no mapa binario %s", filename.c_str());
+            return false;
+        }
+        game_map.copyFrom(initial_game_map);
+
+        std::shared_ptr<std::vector<TileGrid>> scenery(new std::vector<TileGrid>(reader.getLayerCount() - 1));
+        for (int layer = 1; layer < reader.getLayerCount(); ++layer) {
+            if (!reader.readLayer(layer, (*scenery)[layer - 1])) {
+                LOG_ERROR("Chunk corrompido na camada %d do mapa binario %s", layer, filename.c_str());
+                return false;
+            }
+        }
+        scenery_layers = scenery;
+        if (!quiet) LOG_INFO("Mapa binario carregado: %dx%d, %d camada(s)", MAP_COLS, MAP_ROWS, getLayerCount());
+        return true;
+    }
+
+    bool openStreamingMap(const std::string& filename) {
+        std::string error;
+        if (!streamer.open(filename, stream_budget_bytes, error)) {
+            LOG_ERROR("Erro ao abrir mapa para streaming %s: %s", filename.c_str(), error.c_str());
+            return false;
+        }
+
+        const MapFileHeader& header = streamer.getReader().getHeader();
+        tileset.tileWidth = header.tileWidth;
+        tileset.tileHeight = header.tileHeight;
+        tileset.cols = header.tilesetCols;
+        tileset.rows = header.tilesetRows;
+        tileset.path = streamer.getReader().getTilesetPath();
+        MAP_ROWS = streamer.getRows();
+        MAP_COLS = streamer.getCols();
+        // total do mapa inteiro, da contagem gravada no arquivo, e não só dos
+        // chunks já vistos
+        total_coins_on_map = (int)std::min<uint64_t>(streamer.getReader().getTileCount(0, (TileId)TILE_MOEDA), INT_MAX);
+
+        streamer.setExtraBytesPerTile(stream_extra_bytes);
+        streamer.setOnChunkLoaded([this](StreamedChunk& chunk) { onChunkLoaded(chunk); });
+        streamer.setOnChunkEvicted([this](StreamedChunk& chunk) {
+            if (listener) listener->onChunkEvicted(chunk);
+        });
+
+        LOG_INFO("Mapa em streaming: %dx%d, chunks de %d, orcamento de %zu MB", MAP_COLS, MAP_ROWS, streamer.getChunkSize(),
+                 stream_budget_bytes >> 20);
+        return true;
+    }
+
+    // O mapa inteiro não é varrido em streaming: o jogador começa no tile de início
+    // do chunk central (ou no primeiro chão dele), carregado de forma síncrona
+    // apenas durante a inicialização.
+    void findStreamingStart() {
+        int chunkSize = streamer.getChunkSize();
+        int cx = (MAP_COLS / 2) / chunkSize;
+        int cy = (MAP_ROWS / 2) / chunkSize;
+        StreamedChunk* chunk = streamer.loadNow(cx, cy);
+
+        start_row = -1;
+        start_col = -1;
+        int floor_row = -1, floor_col = -1;
+        if (chunk) {
+            for (int i = 0; i < chunkSize * chunkSize && start_row == -1; ++i) {
+                int r = cy * chunkSize + i / chunkSize;
+                int c = cx * chunkSize + i % chunkSize;
+                if (r >= MAP_ROWS || c >= MAP_COLS) continue;
+                if (chunk->tiles[i] == TILE_INICIO) {
+                    start_row = r;
+                    start_col = c;
+                } else if (chunk->tiles[i] == TILE_CHAO && floor_row == -1) {
+                    floor_row = r;
+                    floor_col = c;
+                }
+            }
+        }
+        if (start_row == -1 && floor_row != -1) {
+            start_row = floor_row;
+            start_col = floor_col;
+        }
+    }
+
+    void onChunkLoaded(StreamedChunk& chunk) {
+        changed = true;
+        if (listener) listener->onChunkLoaded(chunk);
+    }
+
+    // A única passada pelo mapa: monta o índice por tipo, de onde saem o total
+    // de moedas e o tile de início.
+    void scanInitialMap() {
+        initial_tile_index.build(initial_game_map);
+        tile_index = initial_tile_index;
+        total_coins_on_map = initial_tile_index.count(static_cast<TileId>(TILE_MOEDA));
+        if (!initial_tile_index.first(static_cast<TileId>(TILE_INICIO), start_col, start_row)) {
+            start_row = -1;
+            start_col = -1;
+        }
+        resizeEntityHash();
+    }
+
+    // Um balde por célula do mapa, até 2^16: com milhares de sessões em mapas
+    // pequenos, o tamanho padrão do hash pesaria mais que o resto da sessão.
+    void resizeEntityHash() {
+        const long long cells = ((long long)(MAP_COLS + 3) / 4) * ((MAP_ROWS + 3) / 4);
+        int bits = 4;
+        while (bits < 16 && (1LL << bits) < cells) bits++;
+        entity_hash = SpatialHash(2, bits);
+    }
+
+    // Spritesheet do jogador: 6 quadros por linha, uma linha por AnimationType;
+    // a dos inimigos: ENEMY_FRAMES quadros por linha, uma linha por tipo.
+    void registerAnimationClips() {
+        for (int type = 0; type <= static_cast<int>(AnimationType::IDLE_BACK); ++type) {
+            animation_clips.add({ 6, 10.0f, type, AnimationLoop::LOOP });
+        }
+        enemy_clip_base = animation_clips.size();
+        for (int kind = 0; kind < ENEMY_KINDS; ++kind) {
+            animation_clips.add({ ENEMY_FRAMES, ENEMY_ANIMATION_FPS, kind, AnimationLoop::LOOP });
+        }
+    }
+
+    double nextFrameTime() const {
+        if (!next_frame_known) {
+            const double now = simTime();
+            next_frame_time = now + secondsToNextFrame(world, animation_clips, now);
+            next_frame_known = true;
+        }
+        return next_frame_time;
+    }
+
+    void createPlayer() {
+        GridPosition grid = { 0, 0 };
+        PreviousGridPosition previous = { 0, 0 };
+        Transform transform = { glm::vec2(0.0f) };
+        Animation animation = { static_cast<int>(AnimationType::IDLE_FRONT), simTime() };
+        Sprite sprite = { SHEET_PLAYER };
+        Entity entity = world.create(grid, previous, transform, animation, sprite, PlayerTag());
+        entity_hash.insert(entity.index, grid.col, grid.row);
+        player_char = new GameCharacter(world, entity_hash, entity);
+        next_frame_known = false;
+    }
+
+    void placePlayer() {
+        if (start_row != -1 && start_col != -1) {
+            player_char->setGridPosition(start_row, start_col);
+        } else {
+            if (!quiet) LOG_WARN("Nenhum tile de inicio (ID %d) encontrado no mapa. Personagem iniciado em (0,0).", TILE_INICIO);
+            player_char->setGridPosition(0, 0);
+        }
+    }
+
+    void setTile(int r, int c, int tileId) {
+        if (r < 0 || r >= MAP_ROWS || c < 0 || c >= MAP_COLS) return;
+        if (streaming) {
+            streamer.setTile(r, c, static_cast<TileId>(tileId));
+            if (listener) listener->onTileChanged(r, c);
+            return;
+        }
+        const TileId before = game_map.get(c, r);
+        if (before == tileId) return;
+        game_map.set(c, r, static_cast<TileId>(tileId));
+        tile_index.set(c, r, before, static_cast<TileId>(tileId));
+        if (walk_mask.walkable(c, r) != isWalkableTile(tileId)) {
+            walk_mask.set(c, r, isWalkableTile(tileId));
+            hierarchical_finder.tileChanged(c, r);
+            flow_field.invalidate();
+        }
+        if (listener) listener->onTileChanged(r, c);
+    }
+
+    void fillMap(int tileId) {
+        if (streaming) {
+            streamer.fillAll(static_cast<TileId>(tileId));
+        } else {
+            game_map.fill(static_cast<TileId>(tileId));
+            tile_index.fill(static_cast<TileId>(tileId));
+            walk_mask.fill(isWalkableTile(tileId));
+            // só acontece no fim do jogo: o mapa uniforme não precisa de grafo,
+            // e o reset volta com o do mapa inicial
+            hierarchical_finder.clear();
+            flow_field.invalidate();
+            player_path.clear();
+        }
+        if (listener) listener->onMapReplaced();
+    }
+
+    bool isWalkableTile(int tileId) const {
+        // lava é caminhável para o teclado, mas o caminho automático a evita
+        return tileId >= 0 && tileId != TILE_PAREDE && tileId != TILE_AGUA && tileId != TILE_LAVA;
+    }
+
+    void rebuildWalkMask() {
+        walk_mask.resize(MAP_COLS, MAP_ROWS);
+        for (int r = 0; r < MAP_ROWS; ++r) {
+            const TileId* tiles = game_map.rowData(r);
+            for (int c = 0; c < MAP_COLS; ++c) {
+                if (isWalkableTile(tiles[c])) walk_mask.set(c, r, true);
+            }
+        }
+        if ((size_t)MAP_ROWS * MAP_COLS >= (size_t)HIERARCHICAL_PATH_TILES) hierarchical_finder.build(walk_mask);
+        else hierarchical_finder = HierarchicalPathFinder();
+        flow_field.invalidate();
+        player_path.clear();
+    }
+
+    // Máscara e grafo do mapa inicial, montados uma vez em initialize: o
+    // reset não refaz o HPA*, que leva segundos nos mapas grandes. Só lidos,
+    // então as sessões do mesmo mapa (initializeFrom) os compartilham.
+    void restoreInitialWalkMask() {
+        walk_mask = *initial_walk_mask;
+        hierarchical_finder = *initial_hierarchical_finder;
+        flow_field.invalidate();
+        player_path.clear();
+    }
+
+    void startPathTo(int target) {
+        player_path.clear();
+        if (streaming || walk_mask.empty() || !player_char || game_over || game_won) return;
+        int goalCol = target % MAP_COLS;
+        int goalRow = target / MAP_COLS;
+        if (target < 0 || goalRow >= MAP_ROWS) return;
+
+        bool found = hierarchical_finder.isBuilt()
+            ? hierarchical_finder.findPath(walk_mask, player_char->getCol(), player_char->getRow(), goalCol, goalRow, player_path)
+            : path_finder.findPath(walk_mask, player_char->getCol(), player_char->getRow(), goalCol, goalRow, player_path);
+        if (!found) {
+            if (verbose) LOG_DEBUG("Sem caminho até (%d, %d).", goalCol, goalRow);
+            return;
+        }
+        path_next = 0;
+        path_cooldown = 0;
+    }
+
+    // Um passo do caminho: o mesmo comando de uma tecla, para valerem as mesmas
+    // regras (moedas, animação).
+    void advancePath() {
+        if (player_path.empty() || game_over || game_won || !player_char) return;
+        if (path_cooldown > 0) {
+            path_cooldown--;
+            return;
+        }
+
+        int next = player_path[path_next];
+        int dr = next / MAP_COLS - player_char->getRow();
+        int dc = next % MAP_COLS - player_char->getCol();
+        CommandId id;
+        if (dr < 0) id = dc < 0 ? CommandId::MOVE_UP_LEFT : (dc > 0 ? CommandId::MOVE_UP_RIGHT : CommandId::MOVE_UP);
+        else if (dr > 0) id = dc < 0 ? CommandId::MOVE_DOWN_LEFT : (dc > 0 ? CommandId::MOVE_DOWN_RIGHT : CommandId::MOVE_DOWN);
+        else id = dc < 0 ? CommandId::MOVE_LEFT : CommandId::MOVE_RIGHT;
+
+        int beforeRow = player_char->getRow();
+        int beforeCol = player_char->getCol();
+        commandFor(id)->execute(*this);
+
+        // o tile pode ter mudado desde o cálculo do caminho
+        if ((player_char->getRow() == beforeRow && player_char->getCol() == beforeCol) || ++path_next >= player_path.size()) {
+            player_path.clear();
+            return;
+        }
+        path_cooldown = std::max(0, (int)std::lround(PATH_STEP_SECONDS / sim_step) - 1);
+    }
+
+    // Espalha os inimigos longe do jogador. Chamado pelo comando SPAWN_ENEMIES
+    // (gravado no log, então o replay cria os mesmos) e de novo no reset.
+    void spawnEnemies(int count) {
+        enemy_count = count;
+        world.eachEntity<EnemyTag>([&](Entity entity, EnemyTag&) { entity_hash.erase(entity.index); });
+        world.destroyEach<EnemyTag>();
+        flow_field.invalidate();
+        changed = true;
+        next_frame_known = false;
+        if (count <= 0 || !player_char) return;
+        if (streaming) {
+            if (!quiet) LOG_WARN("Inimigos nao disponiveis com --stream.");
+            return;
+        }
+        if (parallel && !worker_pool) worker_pool.reset(new WorkerPool());
+
+        // Tiles caminháveis a pelo menos ENEMY_SPAWN_DISTANCE tiles do jogador
+        // em algum dos eixos. A semente é fixa, então o replay sorteia os mesmos.
+        const int playerCol = player_char->getCol();
+        const int playerRow = player_char->getRow();
+        std::mt19937 rng(ENEMY_SEED);
+        long long attempts = (long long)count * 64;
+        int spawned = 0;
+        while (spawned < count && attempts-- > 0) {
+            int col = (int)(rng() % (uint32_t)MAP_COLS);
+            int row = (int)(rng() % (uint32_t)MAP_ROWS);
+            if (!walk_mask.walkable(col, row)) continue;
+            if (std::abs(col - playerCol) < ENEMY_SPAWN_DISTANCE && std::abs(row - playerRow) < ENEMY_SPAWN_DISTANCE) continue;
+            if (entity_hash.countAt(col, row) > 0) continue;
+            GridPosition grid = { col, row };
+            PreviousGridPosition previous = { col, row };
+            Transform transform = { glm::vec2(0.0f) };
+            // quadro inicial alternado para que vizinhos não pulsem juntos
+            const int kind = (int)(rng() % (uint32_t)ENEMY_KINDS);
+            Animation animation = { enemy_clip_base + kind, simTime() - (spawned % ENEMY_FRAMES) / (double)ENEMY_ANIMATION_FPS };
+            Sprite sprite = { SHEET_ENEMIES };
+            Entity entity = world.create(grid, previous, transform, animation, sprite, EnemyTag());
+            entity_hash.insert(entity.index, col, row);
+            spawned++;
+        }
+        enemy_cooldown = std::max(0, (int)std::lround(ENEMY_STEP_SECONDS / sim_step) - 1);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        flow_field.computeNow(walk_mask, player_char->getCol(), player_char->getRow(), worker_pool.get());
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        if (verbose) {
+            const FlowField& field = flow_field.current();
+            LOG_DEBUG("%d inimigos; campo de fluxo de %dx%d calculado em %g ms (%d execucoes em %d blocos, %d threads)", spawned,
+                      MAP_COLS, MAP_ROWS, seconds * 1000.0, field.getLastChunkRuns(), field.getChunkCount(),
+                      worker_pool ? worker_pool->getThreadCount() : 1);
+        }
+    }
+
+    // Fim de jogo se o jogador divide o tile com outra entidade (um inimigo).
+    // Chamado depois do passo dos inimigos e de cada movimento do jogador.
+    void checkEnemyContact() {
+        if (enemy_count <= 0 || !player_char || game_over || game_won) return;
+        if (entity_hash.countAt(player_char->getCol(), player_char->getRow()) > 1) {
+            game_over = true;
+            if (!quiet) LOG_INFO("Um inimigo alcancou voce! Fim de jogo.");
+        }
+    }
+
+    // O campo acompanha o tile do jogador; cada inimigo anda um tile pela
+    // direção do tile em que está. O campo do tile novo é calculado em
+    // segundo plano e só entra no passo seguinte dos inimigos; se o jogador
+    // andou de novo nesse meio tempo, o pedido seguinte sai logo depois.
+    void updateEnemies() {
+        if (enemy_count <= 0 || !player_char || game_over || game_won) return;
+        requestFlowField();
+        if (enemy_cooldown > 0) {
+            enemy_cooldown--;
+            return;
+        }
+        enemy_cooldown = std::max(0, (int)std::lround(ENEMY_STEP_SECONDS / sim_step) - 1);
+
+        if (flow_field.swap()) requestFlowField();
+        if (followFlowField(world, flow_field.current(), entity_hash) > 0) {
+            enemies_moved = true;
+            changed = true;
+        }
+        checkEnemyContact();
+    }
+
+    void requestFlowField() {
+        if (flow_field.isPending() || flow_field.current().isComputedFor(player_char->getCol(), player_char->getRow())) return;
+        flow_field.request(walk_mask, player_char->getCol(), player_char->getRow(), worker_pool.get());
+    }
+
+    TilesetInfo tileset;
+    TileGrid game_map;
+    TileGrid initial_game_map;
+    // camadas de cenário, só lidas: compartilhadas entre as sessões do mesmo mapa
+    std::shared_ptr<const std::vector<TileGrid>> scenery_layers;
+
+    // tiles por tipo (moedas, lava, início...) de game_map, atualizado a cada
+    // setTile; o inicial é o do mapa carregado, restaurado no reset. Sem
+    // mapa em streaming.
+    TileTypeIndex tile_index;
+    TileTypeIndex initial_tile_index;
+
+    int MAP_ROWS = 0;
+    int MAP_COLS = 0;
+
+    bool streaming = false;
+    size_t stream_budget_bytes = 64u << 20;
+    size_t stream_extra_bytes = 0;
+    int stream_radius = 2;
+    ChunkStreamer streamer;
+
+    // Jogador e inimigos são entidades de 'world'; player_char é só um
+    // atalho para a entidade do jogador. entity_hash indexa as entidades
+    // pelo tile em que estão, para as colisões entre elas.
+    EntityWorld world;
+    SpatialHash entity_hash;
+    GameCharacter* player_char;
+    SessionListener* listener;
+
+    // Passo fixo: a lógica avança em ticks de sim_step segundos; quanto tempo
+    // real cada tick representa é decisão de quem chama tick().
+    double sim_step = 1.0 / 60.0;
+    long long sim_tick = 0;
+    std::vector<QueuedCommand> pending_commands;
+    InputRecorder recorder;
+    bool verbose = true;
+    bool quiet = false;
+    bool changed = true;
+
+    // Clipes do jogador (um por AnimationType, no mesmo índice) e dos
+    // inimigos (um por linha da spritesheet, a partir de enemy_clip_base).
+    // next_frame_time é a próxima troca de quadro de qualquer entidade,
+    // recalculada só quando passa ou quando um clipe muda.
+    AnimationClipTable animation_clips;
+    int enemy_clip_base = 0;
+    mutable double next_frame_time = 0.0;
+    mutable bool next_frame_known = false;
+
+    // Clique para mover: caminho calculado pelo A* sobre walk_mask e seguido
+    // um tile a cada PATH_STEP_SECONDS. Sem mapa em streaming. Em mapas a
+    // partir de HIERARCHICAL_PATH_TILES tiles a busca é a hierárquica.
+    WalkMask walk_mask;
+    std::shared_ptr<const WalkMask> initial_walk_mask;
+    PathFinder path_finder;
+    HierarchicalPathFinder hierarchical_finder;
+    std::shared_ptr<const HierarchicalPathFinder> initial_hierarchical_finder;
+    const int HIERARCHICAL_PATH_TILES = 256 * 256;
+    std::vector<int> player_path;
+    size_t path_next = 0;
+    int path_cooldown = 0;
+    const double PATH_STEP_SECONDS = 0.12;
+
+    // Inimigos (--enemies N): seguem o campo de fluxo até o jogador, um tile
+    // a cada ENEMY_STEP_SECONDS. O campo só é recalculado quando o jogador
+    // troca de tile ou a caminhabilidade do mapa muda, fora do tick (o pool
+    // vem antes para ser destruído depois da thread do campo). Sem mapa em
+    // streaming.
+    std::unique_ptr<WorkerPool> worker_pool;
+    AsyncFlowField flow_field;
+    bool parallel = true;
+    int enemy_count = 0;
+    int enemy_cooldown = 0;
+    bool enemies_moved = false;
+    const double ENEMY_STEP_SECONDS = 0.3;
+    const float ENEMY_ANIMATION_FPS = 4.0f;
+    const int ENEMY_SPAWN_DISTANCE = 12;
+    const uint32_t ENEMY_SEED = 1337;
+
+    int start_row = -1;
+    int start_col = -1;
+
+    int items_collected = 0;
+    int total_coins_on_map = 0;
+    bool game_over = false;
+    bool game_won = false;
+    bool game_ended_by_lava = false;
+    bool effect_applied = false;
+
+    const int LAVA_WARNING_RADIUS = 5;
+};
+
+inline void MoveUpCommand::execute(GameSession& session) const {
+    session.processPlayerMovement(session.getPlayer()->getRow() - 1, session.getPlayer()->getCol());
+    session.setPlayerAnimation(AnimationType::IDLE_BACK);
+}
+
+inline void MoveDownCommand::execute(GameSession& session) const {
+    session.processPlayerMovement(session.getPlayer()->getRow() + 1, session.getPlayer()->getCol());
+    session.setPlayerAnimation(AnimationType::IDLE_FRONT);
+}
+
+inline void MoveLeftCommand::execute(GameSession& session) const {
+    session.processPlayerMovement(session.getPlayer()->getRow(), session.getPlayer()->getCol() - 1);
+    session.setPlayerAnimation(AnimationType::IDLE_LEFT);
+}
+
+inline void MoveRightCommand::execute(GameSession& session) const {
+    session.processPlayerMovement(session.getPlayer()->getRow(), session.getPlayer()->getCol() + 1);
+    session.setPlayerAnimation(AnimationType::IDLE_RIGHT);
+}
+
+inline void MoveUpLeftCommand::execute(GameSession& session) const {
+    session.processPlayerMovement(session.getPlayer()->getRow() - 1, session.getPlayer()->getCol() - 1);
+    session.setPlayerAnimation(AnimationType::IDLE_LEFT);
+}
+
+inline void MoveUpRightCommand::execute(GameSession& session) const {
+    session.processPlayerMovement(session.getPlayer()->getRow() - 1, session.getPlayer()->getCol() + 1);
+    session.setPlayerAnimation(AnimationType::IDLE_RIGHT);
+}
+
+inline void MoveDownLeftCommand::execute(GameSession& session) const {
+    session.processPlayerMovement(session.getPlayer()->getRow() + 1, session.getPlayer()->getCol() - 1);
+    session.setPlayerAnimation(AnimationType::IDLE_LEFT);
+}
+
+inline void MoveDownRightCommand::execute(GameSession& session) const {
+    session.processPlayerMovement(session.getPlayer()->getRow() + 1, session.getPlayer()->getCol() + 1);
+    session.setPlayerAnimation(AnimationType::IDLE_RIGHT);
+}
+
+inline void ResetGameCommand::execute(GameSession& session) const {
+    session.resetGame();
+}
+
+#endif /* GameSession_h */
@@ -0,0 +1,625 @@
+#ifndef HierarchicalPathFinder_h
+#define HierarchicalPathFinder_h
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "PathFinder.h"
+
+// Busca hierárquica (HPA*) para mapas grandes.
+//
+// O mapa é dividido em clusters quadrados. Nas bordas entre clusters vizinhos
+// ficam as entradas: pares de tiles caminháveis, um de cada lado, por onde o
+// caminho pode passar de um cluster ao outro (uma no meio de cada trecho
+// livre da borda, ou uma em cada ponta nos trechos longos). Cada cluster
+// guarda o custo do caminho interno entre cada par das suas entradas. Uma
+// consulta liga a partida e o destino às entradas dos seus clusters, faz um
+// A* nesse grafo pequeno e depois refina cada trecho com uma busca restrita a
+// um cluster. O resultado pode ser um pouco mais longo que o ótimo.
+//
+// Quando um tile muda de caminhável para bloqueado (ou o contrário), só o
+// cluster dele é recalculado, mais os vizinhos se o tile estiver na borda.
+// O reparo é feito na próxima consulta (ou em repair()), então várias
+// mudanças seguidas custam um reparo só.
+class HierarchicalPathFinder {
+public:
+    static constexpr uint32_t UNREACHABLE = 0xFFFFFFFFu;
+
+    explicit HierarchicalPathFinder(int clusterSize = 32)
+        : clusterSize(clusterSize), idStride(4 * clusterSize), width(0), height(0), clustersX(0), clustersY(0), nodeCount(0),
+          generation(0), localGeneration(0), lastExpanded(0), lastRepaired(0) {}
+
+    // Monta o grafo inteiro a partir da máscara.
+    void build(const WalkMask& mask) {
+        width = mask.getWidth();
+        height = mask.getHeight();
+        clustersX = (width + clusterSize - 1) / clusterSize;
+        clustersY = (height + clusterSize - 1) / clusterSize;
+        clusters.assign(clustersX * clustersY, Cluster());
+        dirtyClusters.clear();
+        for (int cy = 0; cy < clustersY; ++cy) {
+            for (int cx = 0; cx < clustersX; ++cx) {
+                Cluster& cluster = clusters[cx + cy * clustersX];
+                cluster.x0 = cx * clusterSize;
+                cluster.y0 = cy * clusterSize;
+                cluster.w = std::min(clusterSize, width - cluster.x0);
+                cluster.h = std::min(clusterSize, height - cluster.y0);
+                markDirty(cx, cy);
+            }
+        }
+        localNodes.assign(clusterSize * clusterSize, LocalNode());
+        localGeneration = 0;
+        repair(mask);
+    }
+
+    bool isBuilt() const { return !clusters.empty(); }
+
+    // Descarta o grafo; isBuilt passa a ser false até o próximo build.
+    void clear() {
+        clusters.clear();
+        dirtyClusters.clear();
+        width = height = clustersX = clustersY = 0;
+        nodeCount = 0;
+    }
+
+    // Avisa que a caminhabilidade do tile mudou (a máscara já atualizada).
+    void tileChanged(int col, int row) {
+        if (col < 0 || col >= width || row < 0 || row >= height || clusters.empty()) return;
+        int cx = col / clusterSize;
+        int cy = row / clusterSize;
+        // um tile na borda muda as entradas dos clusters do outro lado
+        bool left = col % clusterSize == 0;
+        bool right = col % clusterSize == clusterSize - 1;
+        bool top = row % clusterSize == 0;
+        bool bottom = row % clusterSize == clusterSize - 1;
+        for (int dy = -1; dy <= 1; ++dy) {
+            if ((dy < 0 && !top) || (dy > 0 && !bottom)) continue;
+            for (int dx = -1; dx <= 1; ++dx) {
+                if ((dx < 0 && !left) || (dx > 0 && !right)) continue;
+                markDirty(cx + dx, cy + dy);
+            }
+        }
+    }
+
+    // Recalcula os clusters marcados. Retorna quantos foram refeitos.
+    int repair(const WalkMask& mask) {
+        if (dirtyClusters.empty()) return 0;
+        // primeiro as entradas de todos, depois os custos: o custo interno só
+        // depende das entradas do próprio cluster
+        for (size_t i = 0; i < dirtyClusters.size(); ++i) rebuildEntrances(mask, dirtyClusters[i]);
+        for (size_t i = 0; i < dirtyClusters.size(); ++i) resolveNeighborLinks(dirtyClusters[i]);
+        for (size_t i = 0; i < dirtyClusters.size(); ++i) rebuildCosts(mask, dirtyClusters[i]);
+        for (size_t i = 0; i < dirtyClusters.size(); ++i) clusters[dirtyClusters[i]].dirty = false;
+        lastRepaired = (int)dirtyClusters.size();
+        dirtyClusters.clear();
+        nodeCount = 0;
+        for (size_t k = 0; k < clusters.size(); ++k) nodeCount += (int)clusters[k].nodes.size();
+        return lastRepaired;
+    }
+
+    // Mesmo contrato de PathFinder::findPath.
+    bool findPath(const WalkMask& mask, int startCol, int startRow, int goalCol, int goalRow, std::vector<int>& path) {
+        path.clear();
+        lastExpanded = 0;
+        if (clusters.empty() || !mask.walkable(goalCol, goalRow) ||
+            startCol < 0 || startCol >= width || startRow < 0 || startRow >= height) {
+            return false;
+        }
+        if (startCol == goalCol && startRow == goalRow) return true;
+        repair(mask);
+
+        const int start = startCol + startRow * width;
+        const int goal = goalCol + goalRow * width;
+        const int startCluster = clusterOf(startCol, startRow);
+        const int goalCluster = clusterOf(goalCol, goalRow);
+        const Cluster& goalC = clusters[goalCluster];
+        const Cluster& startC = clusters[startCluster];
+
+        // custo de cada entrada do cluster do destino até ele
+        searchCluster(mask, goalC, goal, -1);
+        goalCosts.resize(goalC.nodes.size());
+        for (size_t j = 0; j < goalC.nodes.size(); ++j) goalCosts[j] = localCost(goalC, goalC.nodes[j]);
+
+        // e da partida até as entradas do seu cluster (e ao destino, se for o mesmo)
+        searchCluster(mask, startC, start, -1, startCluster == goalCluster ? goal : -1);
+        prepare();
+        const int startId = (int)clusters.size() * idStride;
+        const int goalId = startId + 1;
+        touch(startId, 0, -1);
+        open.clear();
+        if (startCluster == goalCluster) {
+            uint32_t direct = localCost(startC, goal);
+            if (direct != UNREACHABLE) {
+                touch(goalId, direct, startId);
+                open.push(goalId, direct, direct);
+            }
+        }
+        for (size_t j = 0; j < startC.nodes.size(); ++j) {
+            uint32_t cost = localCost(startC, startC.nodes[j]);
+            if (cost == UNREACHABLE) continue;
+            relax(startCluster * idStride + (int)j, cost, startId, startC.nodes[j], goalCol, goalRow);
+        }
+
+        const uint32_t closedStamp = generation + 1;
+        while (!open.empty()) {
+            OpenEntry top = open.pop();
+            SearchNode& node = searchNodes[top.index];
+            if (node.stamp == closedStamp || top.g != node.g) continue;
+            node.stamp = closedStamp;
+            lastExpanded++;
+            if (top.index == goalId) {
+                refine(mask, start, goal, startId, goalId, path);
+                return true;
+            }
+
+            const int k = top.index / idStride;
+            const Cluster& cluster = clusters[k];
+            const int local = top.index % idStride;
+
+            // outras entradas do mesmo cluster
+            for (int e = cluster.edgeFirst[local]; e < cluster.edgeFirst[local + 1]; ++e) {
+                const Edge& edge = cluster.edges[e];
+                relax(k * idStride + edge.to, top.g + edge.cost, top.index, cluster.nodes[edge.to], goalCol, goalRow);
+            }
+            // entradas dos clusters vizinhos
+            for (int l = cluster.linkFirst[local]; l < cluster.linkFirst[local + 1]; ++l) {
+                const Link& link = cluster.links[l];
+                if (link.target < 0) continue;
+                relax(link.target, top.g + link.cost, top.index, link.tile, goalCol, goalRow);
+            }
+            // o destino, a partir do seu cluster
+            if (k == goalCluster && goalCosts[local] != UNREACHABLE) {
+                uint32_t g = top.g + goalCosts[local];
+                const SearchNode& goalNode = searchNodes[goalId];
+                if (goalNode.stamp != generation || goalNode.g > g) {
+                    touch(goalId, g, top.index);
+                    open.push(goalId, g, g);
+                }
+            }
+        }
+        return false;
+    }
+
+    int getClusterCount() const { return (int)clusters.size(); }
+    int getNodeCount() const { return nodeCount; }
+    int getLastExpanded() const { return lastExpanded; }
+    int getLastRepaired() const { return lastRepaired; }
+
+private:
+    struct Link {
+        int mine;       // índice local da entrada deste lado
+        int cluster;    // cluster vizinho
+        int tile;       // tile da entrada do outro lado
+        uint32_t cost;
+        int target;     // id da entrada do outro lado
+    };
+
+    struct Edge {
+        int to;
+        uint32_t cost;
+    };
+
+    struct Cluster {
+        int x0 = 0, y0 = 0, w = 0, h = 0;
+        std::vector<int> nodes;          // tiles das entradas, em ordem crescente
+        std::vector<Edge> edges;         // caminhos internos entre entradas
+        std::vector<int> edgeFirst;      // n + 1 posições em 'edges'
+        std::vector<Link> links;         // ordenados por 'mine'
+        std::vector<int> linkFirst;      // n + 1 posições em 'links'
+        bool dirty = false;
+    };
+
+    // Fila de prioridade por baldes para as buscas dentro de um cluster. Os
+    // custos são inteiros pequenos e o f de um vizinho passa o do nó atual em
+    // no máximo 2 * DIAGONAL_COST (heurística consistente), então um anel de
+    // 32 baldes basta e push/pop custam O(1).
+    class BucketQueue {
+    public:
+        BucketQueue() : current(0), count(0) {}
+
+        void clear() {
+            for (int i = 0; i < BUCKETS; ++i) buckets[i].clear();
+            current = 0;
+            count = 0;
+        }
+
+        bool empty() const { return count == 0; }
+
+        void push(int index, uint32_t f, uint32_t g) {
+            if (count == 0 || f < current) current = f;
+            OpenEntry entry = { f, g, index };
+            buckets[f & (BUCKETS - 1)].push_back(entry);
+            count++;
+        }
+
+        OpenEntry pop() {
+            while (buckets[current & (BUCKETS - 1)].empty()) current++;
+            std::vector<OpenEntry>& bucket = buckets[current & (BUCKETS - 1)];
+            OpenEntry top = bucket.back();
+            bucket.pop_back();
+            count--;
+            return top;
+        }
+
+    private:
+        static const int BUCKETS = 32;
+        std::vector<OpenEntry> buckets[BUCKETS];
+        uint32_t current;
+        size_t count;
+    };
+
+    struct SearchNode {
+        uint32_t stamp;
+        uint32_t g;
+        int parent;
+    };
+
+    struct LocalNode {
+        uint32_t stamp = 0;
+        uint32_t g = 0;
+        int parent = -1;
+        uint32_t target = 0;    // == localGeneration: tile que o Dijkstra precisa alcançar
+    };
+
+    int clusterOf(int col, int row) const {
+        return col / clusterSize + (row / clusterSize) * clustersX;
+    }
+
+    void markDirty(int cx, int cy) {
+        if (cx < 0 || cx >= clustersX || cy < 0 || cy >= clustersY) return;
+        int k = cx + cy * clustersX;
+        if (clusters[k].dirty) return;
+        clusters[k].dirty = true;
+        dirtyClusters.push_back(k);
+    }
+
+    static int findNode(const Cluster& cluster, int tile) {
+        std::vector<int>::const_iterator it = std::lower_bound(cluster.nodes.begin(), cluster.nodes.end(), tile);
+        return it != cluster.nodes.end() && *it == tile ? (int)(it - cluster.nodes.begin()) : -1;
+    }
+
+    // Entradas da borda entre duas linhas (ou colunas) vizinhas, 'line' e
+    // 'line + 1', nas posições [begin, end). Cada trecho em que os dois lados
+    // são caminháveis vira uma entrada (ou duas, nas pontas, se for longo);
+    // passagens que só existem na diagonal viram uma entrada cada. 'first'
+    // recebe o tile do lado de 'line' e 'second' o do outro.
+    void borderEntrances(const WalkMask& mask, bool vertical, int line, int begin, int end,
+                         std::vector<int>& first, std::vector<int>& second, std::vector<uint32_t>& cost) const {
+        for (int p = begin; p < end;) {
+            if (!crossable(mask, vertical, line, p)) {
+                p++;
+                continue;
+            }
+            int runStart = p;
+            while (p < end && crossable(mask, vertical, line, p)) p++;
+            int length = p - runStart;
+            if (length >= 6) {
+                addEntrance(vertical, line, runStart, runStart, PathFinder::STRAIGHT_COST, first, second, cost);
+                addEntrance(vertical, line, p - 1, p - 1, PathFinder::STRAIGHT_COST, first, second, cost);
+            } else {
+                int mid = runStart + length / 2;
+                addEntrance(vertical, line, mid, mid, PathFinder::STRAIGHT_COST, first, second, cost);
+            }
+        }
+        for (int p = begin; p < end; ++p) {
+            if (!side(mask, vertical, line, p) || side(mask, vertical, line + 1, p)) continue;
+            for (int q = p - 1; q <= p + 1; q += 2) {
+                if (q < begin || q >= end) continue;
+                if (side(mask, vertical, line + 1, q) && !side(mask, vertical, line, q)) {
+                    addEntrance(vertical, line, p, q, PathFinder::DIAGONAL_COST, first, second, cost);
+                }
+            }
+        }
+    }
+
+    static bool side(const WalkMask& mask, bool vertical, int line, int p) {
+        return vertical ? mask.walkable(line, p) : mask.walkable(p, line);
+    }
+
+    static bool crossable(const WalkMask& mask, bool vertical, int line, int p) {
+        return side(mask, vertical, line, p) && side(mask, vertical, line + 1, p);
+    }
+
+    void addEntrance(bool vertical, int line, int p, int q, uint32_t c,
+                     std::vector<int>& first, std::vector<int>& second, std::vector<uint32_t>& cost) const {
+        first.push_back(vertical ? line + p * width : p + line * width);
+        second.push_back(vertical ? (line + 1) + q * width : q + (line + 1) * width);
+        cost.push_back(c);
+    }
+
+    // Entradas e ligações de um cluster, a partir das suas oito bordas.
+    void rebuildEntrances(const WalkMask& mask, int k) {
+        Cluster& cluster = clusters[k];
+        const int cx = k % clustersX;
+        const int cy = k / clustersX;
+        const int x1 = cluster.x0 + cluster.w - 1;
+        const int y1 = cluster.y0 + cluster.h - 1;
+
+        rawLinks.clear();
+        std::vector<int>& a = scratchFirst;
+        std::vector<int>& b = scratchSecond;
+        std::vector<uint32_t>& c = scratchCost;
+
+        // borda esquerda e de cima: este cluster é o segundo lado
+        if (cx > 0) {
+            a.clear(); b.clear(); c.clear();
+            borderEntrances(mask, true, cluster.x0 - 1, cluster.y0, y1 + 1, a, b, c);
+            for (size_t i = 0; i < a.size(); ++i) addRawLink(b[i], k - 1, a[i], c[i]);
+        }
+        if (cy > 0) {
+            a.clear(); b.clear(); c.clear();
+            borderEntrances(mask, false, cluster.y0 - 1, cluster.x0, x1 + 1, a, b, c);
+            for (size_t i = 0; i < a.size(); ++i) addRawLink(b[i], k - clustersX, a[i], c[i]);
+        }
+        // borda direita e de baixo: este cluster é o primeiro lado
+        if (cx < clustersX - 1) {
+            a.clear(); b.clear(); c.clear();
+            borderEntrances(mask, true, x1, cluster.y0, y1 + 1, a, b, c);
+            for (size_t i = 0; i < a.size(); ++i) addRawLink(a[i], k + 1, b[i], c[i]);
+        }
+        if (cy < clustersY - 1) {
+            a.clear(); b.clear(); c.clear();
+            borderEntrances(mask, false, y1, cluster.x0, x1 + 1, a, b, c);
+            for (size_t i = 0; i < a.size(); ++i) addRawLink(a[i], k + clustersX, b[i], c[i]);
+        }
+        // cantos: passagem diagonal direta para os clusters das diagonais
+        addCorner(mask, k, cluster.x0, cluster.y0, -1, -1);
+        addCorner(mask, k, x1, cluster.y0, 1, -1);
+        addCorner(mask, k, cluster.x0, y1, -1, 1);
+        addCorner(mask, k, x1, y1, 1, 1);
+
+        cluster.nodes.clear();
+        for (size_t i = 0; i < rawLinks.size(); ++i) cluster.nodes.push_back(rawLinks[i].mine);
+        std::sort(cluster.nodes.begin(), cluster.nodes.end());
+        cluster.nodes.erase(std::unique(cluster.nodes.begin(), cluster.nodes.end()), cluster.nodes.end());
+
+        const int n = (int)cluster.nodes.size();
+        for (size_t i = 0; i < rawLinks.size(); ++i) rawLinks[i].mine = findNode(cluster, rawLinks[i].mine);
+        std::sort(rawLinks.begin(), rawLinks.end(), [](const Link& l, const Link& r) { return l.mine < r.mine; });
+        cluster.links = rawLinks;
+        cluster.linkFirst.assign(n + 1, 0);
+        for (size_t i = 0; i < rawLinks.size(); ++i) cluster.linkFirst[rawLinks[i].mine + 1]++;
+        for (int i = 0; i < n; ++i) cluster.linkFirst[i + 1] += cluster.linkFirst[i];
+    }
+
+    void addRawLink(int mine, int otherCluster, int otherTile, uint32_t cost) {
+        Link link = { mine, otherCluster, otherTile, cost, -1 };
+        rawLinks.push_back(link);
+    }
+
+    void addCorner(const WalkMask& mask, int k, int col, int row, int dx, int dy) {
+        int ocx = k % clustersX + dx;
+        int ocy = k / clustersX + dy;
+        if (ocx < 0 || ocx >= clustersX || ocy < 0 || ocy >= clustersY) return;
+        if (!mask.walkable(col, row) || !mask.walkable(col + dx, row + dy)) return;
+        addRawLink(col + row * width, ocx + ocy * clustersX, (col + dx) + (row + dy) * width, PathFinder::DIAGONAL_COST);
+    }
+
+    // Custo interno entre cada par de entradas: um Dijkstra por entrada. Uma
+    // aresta i-j que custa o mesmo que passar por outra entrada m é
+    // descartada, já que o A* acha o mesmo custo por i-m-j; isso deixa o
+    // grafo bem mais esparso.
+    void rebuildCosts(const WalkMask& mask, int k) {
+        Cluster& cluster = clusters[k];
+        const int n = (int)cluster.nodes.size();
+        std::vector<uint32_t>& costs = scratchCost;
+        costs.assign((size_t)n * n, UNREACHABLE);
+        for (int i = 0; i < n; ++i) {
+            costs[i * n + i] = 0;
+            if (i == n - 1) break;
+            searchCluster(mask, cluster, cluster.nodes[i], -1);
+            for (int j = i + 1; j < n; ++j) {
+                uint32_t cost = localCost(cluster, cluster.nodes[j]);
+                costs[i * n + j] = cost;
+                costs[j * n + i] = cost;
+            }
+        }
+
+        cluster.edges.clear();
+        cluster.edgeFirst.assign(n + 1, 0);
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < n; ++j) {
+                uint32_t cost = costs[i * n + j];
+                if (i == j || cost == UNREACHABLE) continue;
+                bool redundant = false;
+                for (int m = 0; m < n && !redundant; ++m) {
+                    if (m == i || m == j || costs[i * n + m] == UNREACHABLE || costs[m * n + j] == UNREACHABLE) continue;
+                    redundant = costs[i * n + m] + costs[m * n + j] <= cost;
+                }
+                if (redundant) continue;
+                Edge edge = { j, cost };
+                cluster.edges.push_back(edge);
+            }
+            cluster.edgeFirst[i + 1] = (int)cluster.edges.size();
+        }
+    }
+
+    // Ids das entradas do outro lado de cada ligação. Refazer um cluster pode
+    // mudar os índices locais das suas entradas, então as ligações dele e as
+    // dos oito vizinhos são resolvidas de novo.
+    void resolveNeighborLinks(int k) {
+        const int cx = k % clustersX;
+        const int cy = k / clustersX;
+        for (int y = std::max(cy - 1, 0); y <= std::min(cy + 1, clustersY - 1); ++y) {
+            for (int x = std::max(cx - 1, 0); x <= std::min(cx + 1, clustersX - 1); ++x) {
+                resolveLinks(x + y * clustersX);
+            }
+        }
+    }
+
+    void resolveLinks(int k) {
+        Cluster& cluster = clusters[k];
+        for (size_t i = 0; i < cluster.links.size(); ++i) {
+            Link& link = cluster.links[i];
+            int j = findNode(clusters[link.cluster], link.tile);
+            link.target = j < 0 ? -1 : link.cluster * idStride + j;
+        }
+    }
+
+    // Busca dentro do retângulo de um cluster. Com goal >= 0 é um A* até
+    // 'goal'; sem goal é um Dijkstra que para assim que todas as entradas do
+    // cluster (e 'extra', se houver) tiverem o custo definitivo.
+    bool searchCluster(const WalkMask& mask, const Cluster& cluster, int start, int goal, int extra = -1) {
+        localGeneration += 2;
+        if (localGeneration == 0) {
+            for (size_t i = 0; i < localNodes.size(); ++i) localNodes[i].stamp = localNodes[i].target = 0;
+            localGeneration = 2;
+        }
+        int remaining = 0;
+        if (goal < 0) {
+            for (size_t i = 0; i <= cluster.nodes.size(); ++i) {
+                int tile = i < cluster.nodes.size() ? cluster.nodes[i] : extra;
+                if (tile < 0) continue;
+                LocalNode& target = localNodes[localIndex(cluster, tile)];
+                if (target.target == localGeneration) continue;
+                target.target = localGeneration;
+                remaining++;
+            }
+        }
+        const uint32_t closedStamp = localGeneration + 1;
+        const int goalCol = goal % width;
+        const int goalRow = goal / width;
+        localOpen.clear();
+        int s = localIndex(cluster, start);
+        localNodes[s].stamp = localGeneration;
+        localNodes[s].g = 0;
+        localNodes[s].parent = -1;
+        localOpen.push(s, goal >= 0 ? PathFinder::octile(start % width, start / width, goalCol, goalRow) : 0, 0);
+
+        static const int dc[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+        static const int dr[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+        while (!localOpen.empty()) {
+            OpenEntry top = localOpen.pop();
+            LocalNode& node = localNodes[top.index];
+            if (node.stamp == closedStamp || top.g != node.g) continue;
+            node.stamp = closedStamp;
+            if (node.target == localGeneration && --remaining == 0) return true;
+
+            const int col = cluster.x0 + top.index % clusterSize;
+            const int row = cluster.y0 + top.index / clusterSize;
+            if (goal >= 0 && col + row * width == goal) return true;
+
+            for (int d = 0; d < 8; ++d) {
+                int nc = col + dc[d];
+                int nr = row + dr[d];
+                if (nc < cluster.x0 || nc >= cluster.x0 + cluster.w || nr < cluster.y0 || nr >= cluster.y0 + cluster.h) continue;
+                if (!mask.walkable(nc, nr)) continue;
+                int next = (nc - cluster.x0) + (nr - cluster.y0) * clusterSize;
+                LocalNode& neighbor = localNodes[next];
+                uint32_t g = top.g + (d < 4 ? PathFinder::STRAIGHT_COST : PathFinder::DIAGONAL_COST);
+                if (neighbor.stamp == closedStamp || (neighbor.stamp == localGeneration && neighbor.g <= g)) continue;
+                neighbor.stamp = localGeneration;
+                neighbor.g = g;
+                neighbor.parent = top.index;
+                uint32_t h = goal >= 0 ? PathFinder::octile(nc, nr, goalCol, goalRow) : 0;
+                localOpen.push(next, g + h, g);
+            }
+        }
+        return goal < 0;
+    }
+
+    int localIndex(const Cluster& cluster, int tile) const {
+        return (tile % width - cluster.x0) + (tile / width - cluster.y0) * clusterSize;
+    }
+
+    // custo até 'tile' na última searchCluster
+    uint32_t localCost(const Cluster& cluster, int tile) const {
+        const LocalNode& node = localNodes[localIndex(cluster, tile)];
+        return node.stamp == localGeneration + 1 ? node.g : UNREACHABLE;
+    }
+
+    void prepare() {
+        size_t size = clusters.size() * idStride + 2;
+        if (searchNodes.size() < size) {
+            SearchNode empty = { 0, 0, -1 };
+            searchNodes.assign(size, empty);
+            generation = 0;
+        }
+        generation += 2;
+        if (generation == 0) {
+            for (size_t i = 0; i < searchNodes.size(); ++i) searchNodes[i].stamp = 0;
+            generation = 2;
+        }
+    }
+
+    void touch(int id, uint32_t g, int parent) {
+        SearchNode& node = searchNodes[id];
+        node.stamp = generation;
+        node.g = g;
+        node.parent = parent;
+    }
+
+    void relax(int id, uint32_t g, int parent, int tile, int goalCol, int goalRow) {
+        const SearchNode& node = searchNodes[id];
+        if (node.stamp == generation + 1) return;
+        if (node.stamp == generation && node.g <= g) return;
+        touch(id, g, parent);
+        open.push(id, g + PathFinder::octile(tile % width, tile / width, goalCol, goalRow) * HEURISTIC_WEIGHT_NUM / HEURISTIC_WEIGHT_DEN, g);
+    }
+
+    int nodeTile(int id, int start, int goal, int startId, int goalId) const {
+        if (id == startId) return start;
+        if (id == goalId) return goal;
+        return clusters[id / idStride].nodes[id % idStride];
+    }
+
+    // Transforma a sequência de entradas em tiles: trechos dentro de um
+    // cluster são refeitos com searchCluster, e as ligações entre clusters
+    // são um passo só.
+    void refine(const WalkMask& mask, int start, int goal, int startId, int goalId, std::vector<int>& path) {
+        waypoints.clear();
+        for (int id = goalId; id != -1; id = searchNodes[id].parent) {
+            waypoints.push_back(nodeTile(id, start, goal, startId, goalId));
+        }
+        std::reverse(waypoints.begin(), waypoints.end());
+
+        for (size_t i = 1; i < waypoints.size(); ++i) {
+            int from = waypoints[i - 1];
+            int to = waypoints[i];
+            if (from == to) continue;
+            int k = clusterOf(from % width, from / width);
+            if (k != clusterOf(to % width, to / width)) {
+                path.push_back(to);
+                continue;
+            }
+            const Cluster& cluster = clusters[k];
+            searchCluster(mask, cluster, from, to);
+            size_t segmentStart = path.size();
+            for (int j = localIndex(cluster, to); j != localIndex(cluster, from); j = localNodes[j].parent) {
+                path.push_back((cluster.x0 + j % clusterSize) + (cluster.y0 + j / clusterSize) * width);
+            }
+            std::reverse(path.begin() + segmentStart, path.end());
+        }
+    }
+
+    // Peso 1,25 na heurística do grafo abstrato: expande bem menos entradas
+    // em mapas com muitos desvios, e o caminho fica poucos por cento mais
+    // longo (o HPA* já não é ótimo de qualquer forma).
+    static constexpr uint32_t HEURISTIC_WEIGHT_NUM = 5;
+    static constexpr uint32_t HEURISTIC_WEIGHT_DEN = 4;
+
+    int clusterSize;
+    int idStride;       // id de uma entrada: cluster * idStride + índice local
+    int width, height;
+    int clustersX, clustersY;
+    int nodeCount;
+    uint32_t generation;
+    uint32_t localGeneration;
+    int lastExpanded;
+    int lastRepaired;
+
+    std::vector<Cluster> clusters;
+    std::vector<int> dirtyClusters;
+    std::vector<SearchNode> searchNodes;
+    std::vector<LocalNode> localNodes;
+    std::vector<uint32_t> goalCosts;
+    std::vector<int> waypoints;
+    std::vector<Link> rawLinks;
+    std::vector<int> scratchFirst, scratchSecond;
+    std::vector<uint32_t> scratchCost;
+    OpenList open;
+    BucketQueue localOpen;
+};
+
+#endif /* HierarchicalPathFinder_h */
@@ -0,0 +1,226 @@
+#ifndef InputLog_h
+#define InputLog_h
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Log binário das entradas do jogo (.gbrp), para replays determinísticos.
+//
+//   cabeçalho  InputLogHeader
+//   eventos    varint(ticks desde o evento anterior) + 1 byte de comando
+//              [+ varint(argumento), se o byte tiver INPUT_LOG_HAS_ARG]
+//   fim        varint(ticks até o fim) + INPUT_LOG_END + InputLogFooter
+//
+// O tick é o da simulação de passo fixo em que o comando foi aplicado, então
+// um replay com o mesmo passo reproduz a partida exatamente; o rodapé guarda
+// um hash do estado final para conferir o resultado.
+
+#define INPUT_LOG_MAGIC "GBRP"
+#define INPUT_LOG_VERSION 2          // a versão 1 não tem argumentos e continua legível
+#define INPUT_LOG_HAS_ARG 0x80
+#define INPUT_LOG_END 0xFF
+
+#pragma pack(push, 1)
+struct InputLogHeader {
+    char magic[4];
+    uint32_t version;
+    double tickStep;              // segundos por tick
+    char mapPath[256];
+};
+
+struct InputLogFooter {
+    uint64_t endTick;
+    uint64_t stateHash;
+};
+#pragma pack(pop)
+
+struct InputEvent {
+    uint64_t tick;
+    uint8_t command;
+    uint32_t arg;
+};
+
+class InputRecorder {
+public:
+    InputRecorder() : file(NULL), lastTick(0) {}
+
+    ~InputRecorder() {
+        if (file) fclose(file);
+    }
+
+    InputRecorder(const InputRecorder&) = delete;
+    InputRecorder& operator=(const InputRecorder&) = delete;
+
+    bool open(const std::string& path, double tickStep, const std::string& mapPath, std::string& error) {
+        file = fopen(path.c_str(), "wb");
+        if (!file) {
+            error = "nao foi possivel criar " + path;
+            return false;
+        }
+        InputLogHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, INPUT_LOG_MAGIC, 4);
+        header.version = INPUT_LOG_VERSION;
+        header.tickStep = tickStep;
+        strncpy(header.mapPath, mapPath.c_str(), sizeof(header.mapPath) - 1);
+        fwrite(&header, sizeof(header), 1, file);
+        lastTick = 0;
+        return true;
+    }
+
+    bool isOpen() const { return file != NULL; }
+
+    void record(uint64_t tick, uint8_t command) {
+        if (!file) return;
+        writeVarint(tick - lastTick);
+        fputc(command, file);
+        lastTick = tick;
+    }
+
+    // comando com um argumento (ex.: tile de destino do clique)
+    void record(uint64_t tick, uint8_t command, uint32_t arg) {
+        if (!file) return;
+        writeVarint(tick - lastTick);
+        fputc(command | INPUT_LOG_HAS_ARG, file);
+        writeVarint(arg);
+        lastTick = tick;
+    }
+
+    void finish(uint64_t endTick, uint64_t stateHash) {
+        if (!file) return;
+        writeVarint(endTick - lastTick);
+        fputc(INPUT_LOG_END, file);
+        InputLogFooter footer = { endTick, stateHash };
+        fwrite(&footer, sizeof(footer), 1, file);
+        fclose(file);
+        file = NULL;
+    }
+
+private:
+    void writeVarint(uint64_t value) {
+        while (value >= 0x80) {
+            fputc((int)(value & 0x7F) | 0x80, file);
+            value >>= 7;
+        }
+        fputc((int)value, file);
+    }
+
+    FILE* file;
+    uint64_t lastTick;
+};
+
+// Lê o log inteiro para a memória; os eventos são consumidos em ordem de tick.
+class InputReplay {
+public:
+    InputReplay() : next(0) {}
+
+    bool open(const std::string& path, std::string& error) {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file) {
+            error = "nao foi possivel abrir " + path;
+            return false;
+        }
+        std::vector<unsigned char> bytes;
+        unsigned char buffer[4096];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            bytes.insert(bytes.end(), buffer, buffer + n);
+        }
+        fclose(file);
+
+        if (bytes.size() < sizeof(InputLogHeader)) {
+            error = "arquivo menor que o cabecalho";
+            return false;
+        }
+        memcpy(&header, bytes.data(), sizeof(header));
+        if (memcmp(header.magic, INPUT_LOG_MAGIC, 4) != 0) {
+            error = "assinatura invalida";
+            return false;
+        }
+        if (header.version == 0 || header.version > INPUT_LOG_VERSION) {
+            error = "versao " + std::to_string(header.version) + " nao suportada";
+            return false;
+        }
+        header.mapPath[sizeof(header.mapPath) - 1] = '\0';
+
+        size_t pos = sizeof(InputLogHeader);
+        uint64_t tick = 0;
+        for (;;) {
+            uint64_t delta;
+            if (!readVarint(bytes, pos, delta) || pos >= bytes.size()) {
+                error = "log truncado";
+                return false;
+            }
+            tick += delta;
+            uint8_t command = bytes[pos++];
+            if (command == INPUT_LOG_END) break;
+            uint64_t arg = 0;
+            if (command & INPUT_LOG_HAS_ARG) {
+                if (!readVarint(bytes, pos, arg)) {
+                    error = "log truncado";
+                    return false;
+                }
+                command &= ~INPUT_LOG_HAS_ARG;
+            }
+            InputEvent event = { tick, command, (uint32_t)arg };
+            events.push_back(event);
+        }
+        if (bytes.size() - pos < sizeof(InputLogFooter)) {
+            error = "rodape ausente";
+            return false;
+        }
+        memcpy(&footer, bytes.data() + pos, sizeof(footer));
+        if (footer.endTick != tick) {
+            error = "tick final inconsistente";
+            return false;
+        }
+        next = 0;
+        return true;
+    }
+
+    const InputLogHeader& getHeader() const { return header; }
+    uint64_t getEndTick() const { return footer.endTick; }
+    uint64_t getStateHash() const { return footer.stateHash; }
+    size_t eventCount() const { return events.size(); }
+
+    // próximo evento do tick dado, se houver
+    bool pop(uint64_t tick, uint8_t& command, uint32_t& arg) {
+        if (next >= events.size() || events[next].tick != tick) return false;
+        command = events[next].command;
+        arg = events[next].arg;
+        next++;
+        return true;
+    }
+
+private:
+    static bool readVarint(const std::vector<unsigned char>& bytes, size_t& pos, uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos >= bytes.size()) return false;
+            unsigned char b = bytes[pos++];
+            value |= (uint64_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+
+    InputLogHeader header;
+    InputLogFooter footer;
+    std::vector<InputEvent> events;
+    size_t next;
+};
+
+// FNV-1a de 64 bits, usado no hash do estado final.
+inline uint64_t fnv1a(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= p[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+#endif /* InputLog_h */
@@ -0,0 +1,238 @@
+#ifndef IsoProjection_h
+#define IsoProjection_h
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+// Projeção isométrica "diamond" do mapa do GB. Guarda o tamanho do tile, as
+// dimensões do mapa e o deslocamento que centraliza o mapa na janela, para que
+// a conversão grade -> tela seja só duas multiplicações e uma soma.
+// Deve ser reconstruída quando o mapa ou o tamanho da janela mudarem. O
+// deslocamento fica em double: com a câmera no meio de um mapa em streaming
+// ele passa de dezenas de milhões de pixels, e em float os tiles perto do
+// jogador sairiam desalinhados.
+class IsoProjection {
+public:
+    IsoProjection() : tileWidth(0.0f), tileHeight(0.0f), mapRows(0), mapCols(0), offsetX(0.0), offsetY(0.0) {}
+
+    IsoProjection(float tileWidth, float tileHeight, int mapRows, int mapCols, float screenWidth, float screenHeight)
+        : tileWidth(tileWidth), tileHeight(tileHeight), mapRows(mapRows), mapCols(mapCols) {
+        float halfW = tileWidth / 2.0f;
+        float halfH = tileHeight / 2.0f;
+
+        float minIsoX = -(mapRows - 1) * halfW;
+        float maxIsoX = (mapCols - 1) * halfW;
+        float minIsoY = 0.0f;
+        float maxIsoY = (mapCols + mapRows - 2) * halfH + tileHeight;
+
+        float centerX = minIsoX + (maxIsoX - minIsoX) / 2.0f;
+        float centerY = minIsoY + (maxIsoY - minIsoY) / 2.0f;
+
+        offsetX = screenWidth / 2.0 - centerX;
+        offsetY = screenHeight / 2.0 - centerY;
+    }
+
+    // Projeção com câmera: o tile (focusCol, focusRow) fica no centro da tela.
+    // Usada quando o mapa é maior que a janela e não é centralizado inteiro.
+    static IsoProjection centeredOn(float tileWidth, float tileHeight, int mapRows, int mapCols,
+                                    int focusCol, int focusRow, float screenWidth, float screenHeight) {
+        IsoProjection p;
+        p.tileWidth = tileWidth;
+        p.tileHeight = tileHeight;
+        p.mapRows = mapRows;
+        p.mapCols = mapCols;
+        p.offsetX = screenWidth / 2.0 - ((double)focusCol - focusRow) * (tileWidth / 2.0);
+        p.offsetY = screenHeight / 2.0 - ((double)focusCol + focusRow) * (tileHeight / 2.0);
+        return p;
+    }
+
+    glm::vec2 toScreen(int col, int row) const {
+        return glm::vec2((float)(((double)col - row) * (tileWidth / 2.0) + offsetX),
+                         (float)(((double)col + row) * (tileHeight / 2.0) + offsetY));
+    }
+
+    // Tile sob o ponto (x, y) da tela, pela inversa da projeção (ver o
+    // recorte abaixo: o losango do tile é o quadrado [col - 1, col] x
+    // [row - 1, row] em u, v). Retorna false fora do mapa.
+    bool toGrid(float x, float y, int& col, int& row) const {
+        float a = (float)(x - offsetX) / (tileWidth / 2.0f);
+        float b = (float)(y - offsetY) / (tileHeight / 2.0f);
+        col = (int)std::ceil((a + b) / 2.0f);
+        row = (int)std::ceil((b - a) / 2.0f);
+        return col >= 0 && col < mapCols && row >= 0 && row < mapRows;
+    }
+
+    // Tile sob o pixel (x, y) da tela, só com inteiros: a mesma inversa do
+    // toGrid, tomada no centro do pixel e sem arredondamento de float. As duas
+    // divisões são as funções de aresta do losango (u e v até as retas das
+    // bordas, ver o recorte abaixo); um ponto exatamente sobre uma aresta fica
+    // com o tile de col (ou row) menor, então cada pixel pertence a um tile só e um
+    // tile inteiro na tela tem exatamente tileWidth * tileHeight / 2 pixels
+    // (tamanhos pares). Exato enquanto a origem cai em quartos de pixel, o
+    // que vale para tamanhos inteiros de tile e de janela. Retorna false
+    // fora do mapa.
+    bool pick(int x, int y, int& col, int& row) const {
+        pickWith(pickParams(), x, y, col, row);
+        return col >= 0 && col < mapCols && row >= 0 && row < mapRows;
+    }
+
+    // pick de 'count' pontos de uma vez (vários cursores, destaque sob o
+    // mouse): as constantes saem uma vez só e o laço não tem desvios. Fora
+    // do mapa, col e row ficam -1.
+    void pickMany(const int* x, const int* y, int count, int* outCol, int* outRow) const {
+        const PickParams params = pickParams();
+        for (int i = 0; i < count; ++i) {
+            int col, row;
+            pickWith(params, x[i], y[i], col, row);
+            const bool inside = col >= 0 && col < mapCols && row >= 0 && row < mapRows;
+            outCol[i] = inside ? col : -1;
+            outRow[i] = inside ? row : -1;
+        }
+    }
+
+    // posição na tela do tile (0, 0); usada como origem no vertex shader
+    glm::vec2 origin() const {
+        return glm::vec2((float)offsetX, (float)offsetY);
+    }
+
+    // Profundidade de desenho, no lugar da ordem dos laços.
+    //
+    // A chave cresce com a diagonal col + row (mais embaixo na tela fica na
+    // frente), e cada camada ocupa uma faixa inteira de diagonais, então o
+    // chão nunca cobre o que está em pé sobre ele. 'bias', em [0, 1), é a
+    // altura dentro da diagonal e desempata quem divide o mesmo tile. O
+    // resultado fica em [0, 1), o z da projeção ortográfica: com o teste de
+    // profundidade e o descarte por alfa, tiles e sprites podem ser desenhados
+    // em qualquer ordem. Os shaders repetem a conta com depthParams().
+    static constexpr int DEPTH_LAYERS = 4;
+
+    float depth(float diagonal, int layer, float bias) const {
+        const glm::vec2 params = depthParams();
+        return ((float)layer * params.x + diagonal + bias) * params.y;
+    }
+
+    // (diagonais por camada, escala até [0, 1)); col + row + bias < mapRows + mapCols
+    glm::vec2 depthParams() const {
+        const float stride = (float)std::max(mapRows + mapCols, 1);
+        return glm::vec2(stride, 1.0f / (DEPTH_LAYERS * stride));
+    }
+
+    // Converte 'count' colunas consecutivas de uma linha, a partir de colBegin,
+    // gravando x e y em vetores separados. O laço não tem desvios nem
+    // dependências entre iterações, então o compilador consegue vetorizá-lo.
+    void projectRow(int row, int colBegin, int count, float* outX, float* outY) const {
+        const float halfW = tileWidth / 2.0f;
+        const float halfH = tileHeight / 2.0f;
+        const float baseX = (float)((colBegin - row) * halfW + offsetX);
+        const float baseY = (float)((colBegin + row) * halfH + offsetY);
+        for (int i = 0; i < count; ++i) {
+            outX[i] = baseX + i * halfW;
+            outY[i] = baseY + i * halfH;
+        }
+    }
+
+    // Recorte analítico do losango visível.
+    //
+    // Com a = (x - offsetX) / (tw/2) e b = (y - offsetY) / (th/2), o losango do
+    // tile (col, row) é |a - (col - row)| + |b - (col + row - 1)| <= 1. Girando
+    // para u = (a + b) / 2, v = (b - a) / 2 ele vira o quadrado
+    // [col - 1, col] x [row - 1, row], e o retângulo da tela vira um losango.
+    // As faixas visíveis saem então direto das retas das bordas da tela,
+    // sem testar tile por tile.
+
+    // Linhas [rowBegin, rowEnd) com algum losango dentro do retângulo da tela.
+    bool visibleRows(float left, float top, float right, float bottom, int& rowBegin, int& rowEnd) const {
+        float a0, b0, a1, b1;
+        toDiamondSpace(left, top, right, bottom, a0, b0, a1, b1);
+        float vMin = (b0 - a1) / 2.0f;
+        float vMax = (b1 - a0) / 2.0f;
+        rowBegin = std::max(0, (int)std::ceil(vMin));
+        rowEnd = std::min(mapRows, (int)std::floor(vMax) + 2);
+        return rowBegin < rowEnd;
+    }
+
+    // Colunas [colBegin, colEnd) da linha 'row' cujo losango intersecta a tela.
+    bool visibleColumns(int row, float left, float top, float right, float bottom, int& colBegin, int& colEnd) const {
+        float a0, b0, a1, b1;
+        toDiamondSpace(left, top, right, bottom, a0, b0, a1, b1);
+
+        // trecho da linha (v em [row - 1, row]) que cai dentro da tela
+        float vLo = std::max((float)row - 1.0f, (b0 - a1) / 2.0f);
+        float vHi = std::min((float)row, (b1 - a0) / 2.0f);
+        if (vLo > vHi) {
+            colBegin = colEnd = 0;
+            return false;
+        }
+
+        // u mínimo: menor valor de max(a0 + v, b0 - v) no trecho; u máximo:
+        // maior valor de min(a1 + v, b1 - v). Os extremos ficam nas pontas do
+        // trecho ou na quina onde as duas retas se cruzam.
+        float uMin = std::min(std::max(a0 + vLo, b0 - vLo), std::max(a0 + vHi, b0 - vHi));
+        float kinkLo = (b0 - a0) / 2.0f;
+        if (kinkLo > vLo && kinkLo < vHi) uMin = std::min(uMin, a0 + kinkLo);
+
+        float uMax = std::max(std::min(a1 + vLo, b1 - vLo), std::min(a1 + vHi, b1 - vHi));
+        float kinkHi = (b1 - a1) / 2.0f;
+        if (kinkHi > vLo && kinkHi < vHi) uMax = std::max(uMax, a1 + kinkHi);
+
+        colBegin = std::max(0, (int)std::ceil(uMin));
+        colEnd = std::min(mapCols, (int)std::floor(uMax) + 2);
+        if (colBegin >= colEnd) {
+            colBegin = colEnd = 0;
+            return false;
+        }
+        return true;
+    }
+
+    float getTileWidth() const { return tileWidth; }
+    float getTileHeight() const { return tileHeight; }
+    int getMapRows() const { return mapRows; }
+    int getMapCols() const { return mapCols; }
+
+private:
+    // Constantes do pick: a origem em quartos de pixel e o tile em pixels.
+    // Com dx, dy em quartos de pixel a partir da origem, u = (dx * th + dy *
+    // tw) / (4 * tw * th) e v = (dy * tw - dx * th) / (4 * tw * th).
+    struct PickParams {
+        long long originX4, originY4;
+        long long tileW, tileH;
+        long long denominator;
+    };
+
+    PickParams pickParams() const {
+        PickParams params;
+        params.originX4 = std::llround(offsetX * 4.0);
+        params.originY4 = std::llround(offsetY * 4.0);
+        params.tileW = std::max(1LL, std::llround(tileWidth));
+        params.tileH = std::max(1LL, std::llround(tileHeight));
+        params.denominator = 4 * params.tileW * params.tileH;
+        return params;
+    }
+
+    // ceil(n / d) para d > 0; a divisão do C++ já arredonda os negativos para cima
+    static long long ceilDiv(long long n, long long d) {
+        return (n + (n > 0 ? d - 1 : 0)) / d;
+    }
+
+    static void pickWith(const PickParams& params, int x, int y, int& col, int& row) {
+        const long long dx = 4LL * x + 2 - params.originX4;
+        const long long dy = 4LL * y + 2 - params.originY4;
+        col = (int)ceilDiv(dx * params.tileH + dy * params.tileW, params.denominator);
+        row = (int)ceilDiv(dy * params.tileW - dx * params.tileH, params.denominator);
+    }
+
+    void toDiamondSpace(float left, float top, float right, float bottom, float& a0, float& b0, float& a1, float& b1) const {
+        a0 = (float)((left - offsetX) / (tileWidth / 2.0));
+        a1 = (float)((right - offsetX) / (tileWidth / 2.0));
+        b0 = (float)((top - offsetY) / (tileHeight / 2.0));
+        b1 = (float)((bottom - offsetY) / (tileHeight / 2.0));
+    }
+
+    float tileWidth, tileHeight;
+    int mapRows, mapCols;
+    double offsetX, offsetY;
+};
+
+#endif /* IsoProjection_h */
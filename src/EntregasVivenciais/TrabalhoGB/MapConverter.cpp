@@ -0,0 +1,273 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+#include "MapFile.h"
+
+// Converte mapas de texto para o formato binário .gbmap.
+//
+// Entradas aceitas:
+//   .txt  formato do Trabalho GB (tileset_info / map_dimensions / map_data)
+//   .tmap grade de inteiros dos exemplos do M6 ("largura altura" + ids)
+//   .tmx  mapa do Tiled com camadas em CSV (uma camada do .gbmap por <layer>)
+
+static std::string extensionOf(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos) return "";
+    std::string ext = path.substr(dot + 1);
+    for (char& ch : ext) ch = (char)tolower(ch);
+    return ext;
+}
+
+static bool toTileId(long value, TileId& out) {
+    if (value < 0 || value >= MAP_EMPTY_TILE) return false;
+    out = static_cast<TileId>(value);
+    return true;
+}
+
+static bool readGBText(const std::string& path, MapTilesetInfo& tileset, std::vector<TileGrid>& layers) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Erro ao abrir arquivo: " << path << std::endl;
+        return false;
+    }
+
+    std::string line, key;
+    int rows = 0, cols = 0;
+
+    std::getline(file, line);
+    std::istringstream iss_tileset(line);
+    iss_tileset >> key >> tileset.path >> tileset.cols >> tileset.rows >> tileset.tileWidth >> tileset.tileHeight;
+
+    std::getline(file, line);
+    std::istringstream iss_dim(line);
+    if (!(iss_dim >> key >> rows >> cols) || rows <= 0 || cols <= 0) {
+        std::cerr << "Dimensoes do mapa invalidas: \"" << line << "\"" << std::endl;
+        return false;
+    }
+
+    std::getline(file, line);
+
+    TileGrid grid(cols, rows);
+    for (int r = 0; r < rows; ++r) {
+        if (!std::getline(file, line)) {
+            std::cerr << "Dados do mapa incompletos na linha " << r << std::endl;
+            return false;
+        }
+        size_t first = line.find_first_not_of(" \t\n\r");
+        size_t last = line.find_last_not_of(" \t\n\r");
+        line = first == std::string::npos ? "" : line.substr(first, last - first + 1);
+        if ((int)line.length() != cols) {
+            std::cerr << "Largura da linha " << r << " incorreta. Esperado " << cols << ", obtido " << line.length() << std::endl;
+            return false;
+        }
+        for (int c = 0; c < cols; ++c) {
+            // um dígito por tile; qualquer outro caractere viraria um id sem sentido
+            if (line[c] < '0' || line[c] > '9') {
+                std::cerr << "Tile invalido '" << line[c] << "' em (" << c << ", " << r << ")" << std::endl;
+                return false;
+            }
+            grid.set(c, r, static_cast<TileId>(line[c] - '0'));
+        }
+    }
+    layers.push_back(grid);
+    return true;
+}
+
+static bool readTmap(const std::string& path, std::vector<TileGrid>& layers) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Erro ao abrir arquivo: " << path << std::endl;
+        return false;
+    }
+    int w, h;
+    if (!(file >> w >> h) || w <= 0 || h <= 0) {
+        std::cerr << "Cabecalho do .tmap invalido" << std::endl;
+        return false;
+    }
+    TileGrid grid(w, h);
+    for (int r = 0; r < h; ++r) {
+        for (int c = 0; c < w; ++c) {
+            long tid;
+            TileId id;
+            if (!(file >> tid) || !toTileId(tid, id)) {
+                std::cerr << "Tile invalido em (" << c << ", " << r << ")" << std::endl;
+                return false;
+            }
+            grid.set(c, r, id);
+        }
+    }
+    layers.push_back(grid);
+    return true;
+}
+
+static bool readAttribute(const std::string& tag, const std::string& name, std::string& value) {
+    std::string pattern = " " + name + "=\"";
+    size_t pos = tag.find(pattern);
+    if (pos == std::string::npos) return false;
+    pos += pattern.size();
+    size_t end = tag.find('"', pos);
+    if (end == std::string::npos) return false;
+    value = tag.substr(pos, end - pos);
+    return true;
+}
+
+static bool readTmx(const std::string& path, MapTilesetInfo& tileset, bool tilesetGiven, std::vector<TileGrid>& layers) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Erro ao abrir arquivo: " << path << std::endl;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string xml = buffer.str();
+
+    size_t mapTag = xml.find("<map");
+    if (mapTag == std::string::npos) {
+        std::cerr << "Elemento <map> nao encontrado" << std::endl;
+        return false;
+    }
+    std::string mapHeader = xml.substr(mapTag, xml.find('>', mapTag) - mapTag);
+    std::string value;
+    if (readAttribute(mapHeader, "orientation", value) && value != "isometric") {
+        std::cout << "Aviso: mapa com orientacao '" << value << "' sera tratado como isometrico" << std::endl;
+    }
+    if (!tilesetGiven) {
+        if (readAttribute(mapHeader, "tilewidth", value)) tileset.tileWidth = atoi(value.c_str());
+        if (readAttribute(mapHeader, "tileheight", value)) tileset.tileHeight = atoi(value.c_str());
+    }
+
+    long firstGid = 1;
+    size_t tilesetTag = xml.find("<tileset");
+    if (tilesetTag != std::string::npos) {
+        std::string tag = xml.substr(tilesetTag, xml.find('>', tilesetTag) - tilesetTag);
+        if (readAttribute(tag, "firstgid", value)) firstGid = atol(value.c_str());
+    }
+
+    size_t pos = 0;
+    while ((pos = xml.find("<layer", pos)) != std::string::npos) {
+        std::string tag = xml.substr(pos, xml.find('>', pos) - pos);
+        int w = 0, h = 0;
+        if (readAttribute(tag, "width", value)) w = atoi(value.c_str());
+        if (readAttribute(tag, "height", value)) h = atoi(value.c_str());
+
+        size_t data = xml.find("<data", pos);
+        if (data == std::string::npos || w <= 0 || h <= 0) {
+            std::cerr << "Camada sem dados ou dimensoes" << std::endl;
+            return false;
+        }
+        std::string dataTag = xml.substr(data, xml.find('>', data) - data);
+        if (!readAttribute(dataTag, "encoding", value) || value != "csv") {
+            std::cerr << "Somente camadas com encoding=\"csv\" sao suportadas" << std::endl;
+            return false;
+        }
+        size_t begin = xml.find('>', data) + 1;
+        size_t end = xml.find("</data>", begin);
+        std::stringstream csv(xml.substr(begin, end - begin));
+
+        TileGrid grid(w, h, MAP_EMPTY_TILE);
+        std::string cell;
+        int i = 0;
+        while (std::getline(csv, cell, ',') && i < w * h) {
+            // os 3 bits mais altos do gid guardam os flags de espelhamento do Tiled
+            unsigned long gid = strtoul(cell.c_str(), NULL, 10) & 0x1FFFFFFFul;
+            if (gid != 0) {
+                TileId id;
+                if (!toTileId((long)gid - firstGid, id)) {
+                    std::cerr << "Tile " << gid << " fora do intervalo suportado" << std::endl;
+                    return false;
+                }
+                grid.set(i % w, i / w, id);
+            }
+            i++;
+        }
+        if (i != w * h) {
+            std::cerr << "Camada com " << i << " tiles, esperado " << w * h << std::endl;
+            return false;
+        }
+        if (!layers.empty() && (layers[0].getWidth() != w || layers[0].getHeight() != h)) {
+            std::cerr << "Camadas com dimensoes diferentes nao sao suportadas" << std::endl;
+            return false;
+        }
+        layers.push_back(grid);
+        pos = end;
+    }
+
+    if (layers.empty()) {
+        std::cerr << "Nenhuma camada encontrada" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static void printUsage() {
+    std::cout << "Uso: MapConverter <entrada.txt|.tmap|.tmx> <saida.gbmap> [opcoes]\n"
+              << "  --chunk N                            lado do chunk em tiles (padrao 64)\n"
+              << "  --raw                                grava os chunks sem compressao\n"
+              << "  --tileset caminho cols rows tw th    dados do tileset (obrigatorio para .tmap)\n";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        printUsage();
+        return 1;
+    }
+
+    std::string input = argv[1];
+    std::string output = argv[2];
+    int chunkSize = 64;
+    bool compress = true;
+    bool tilesetGiven = false;
+    MapTilesetInfo tileset = { "terrain.png", 9, 9, 128, 64 };
+
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--chunk" && i + 1 < argc) {
+            chunkSize = atoi(argv[++i]);
+        } else if (arg == "--raw") {
+            compress = false;
+        } else if (arg == "--tileset" && i + 5 < argc) {
+            tileset.path = argv[++i];
+            tileset.cols = atoi(argv[++i]);
+            tileset.rows = atoi(argv[++i]);
+            tileset.tileWidth = atoi(argv[++i]);
+            tileset.tileHeight = atoi(argv[++i]);
+            tilesetGiven = true;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    std::vector<TileGrid> layers;
+    std::string ext = extensionOf(input);
+    bool ok;
+    if (ext == "tmap") {
+        ok = readTmap(input, layers);
+    } else if (ext == "tmx") {
+        ok = readTmx(input, tileset, tilesetGiven, layers);
+    } else {
+        MapTilesetInfo fromFile = tileset;
+        ok = readGBText(input, fromFile, layers);
+        if (!tilesetGiven) tileset = fromFile;
+    }
+    if (!ok) return 1;
+
+    std::string error;
+    if (!writeMapFile(output, tileset, layers, chunkSize, compress, error)) {
+        std::cerr << "Falha ao gravar " << output << ": " << error << std::endl;
+        return 1;
+    }
+
+    MapFileReader reader;
+    if (!reader.open(output, error)) {
+        std::cerr << "Arquivo gravado nao pode ser relido: " << error << std::endl;
+        return 1;
+    }
+    std::cout << "Mapa convertido: " << input << " -> " << output << " (" << reader.getCols() << "x" << reader.getRows()
+              << ", " << reader.getLayerCount() << " camada(s), chunks de " << reader.getChunkSize() << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,411 @@
+#ifndef PathFinder_h
+#define PathFinder_h
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// índice do bit 1 mais baixo / mais alto de uma palavra não nula
+inline int lowestBit(uint64_t v) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, v);
+    return (int)index;
+#else
+    return __builtin_ctzll(v);
+#endif
+}
+
+inline int highestBit(uint64_t v) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, v);
+    return (int)index;
+#else
+    return 63 - __builtin_clzll(v);
+#endif
+}
+
+// Máscara de tiles caminháveis, um bit por tile e 64 tiles por palavra.
+// Guarda o mapa duas vezes, por linhas e transposto (por colunas), para que
+// os saltos horizontais e verticais do PathFinder leiam 64 tiles de cada vez.
+// Um mapa 1024x1024 ocupa 256 KB.
+class WalkMask {
+public:
+    WalkMask() : width(0), height(0), rowWords(0), colWords(0) {}
+
+    void resize(int w, int h) {
+        width = w;
+        height = h;
+        rowWords = (w + 63) / 64;
+        colWords = (h + 63) / 64;
+        rows.assign((size_t)rowWords * h, 0);
+        cols.assign((size_t)colWords * w, 0);
+        zeros.assign(std::max(rowWords, colWords), 0);
+    }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    bool empty() const { return width == 0 || height == 0; }
+
+    // fora do mapa conta como não caminhável
+    bool walkable(int col, int row) const {
+        if (col < 0 || col >= width || row < 0 || row >= height) return false;
+        return (rows[(size_t)row * rowWords + (col >> 6)] >> (col & 63)) & 1;
+    }
+
+    void set(int col, int row, bool walkable) {
+        setBit(rows[(size_t)row * rowWords + (col >> 6)], col & 63, walkable);
+        setBit(cols[(size_t)col * colWords + (row >> 6)], row & 63, walkable);
+    }
+
+    void fill(bool walkable) {
+        for (int row = 0; row < height; ++row) fillLine(&rows[(size_t)row * rowWords], rowWords, width, walkable);
+        for (int col = 0; col < width; ++col) fillLine(&cols[(size_t)col * colWords], colWords, height, walkable);
+    }
+
+    // Palavras de uma linha / coluna; fora do mapa, uma linha vazia. Os bits
+    // além do fim da linha são sempre 0.
+    int getRowWords() const { return rowWords; }
+    int getColWords() const { return colWords; }
+    const uint64_t* rowLine(int row) const {
+        return row < 0 || row >= height ? zeros.data() : &rows[(size_t)row * rowWords];
+    }
+    const uint64_t* colLine(int col) const {
+        return col < 0 || col >= width ? zeros.data() : &cols[(size_t)col * colWords];
+    }
+
+private:
+    static void setBit(uint64_t& word, int bit, bool value) {
+        if (value) word |= 1ull << bit;
+        else word &= ~(1ull << bit);
+    }
+
+    static void fillLine(uint64_t* line, int words, int length, bool value) {
+        for (int w = 0; w < words; ++w) line[w] = value ? ~0ull : 0ull;
+        if (value && (length & 63)) line[words - 1] = (1ull << (length & 63)) - 1;
+    }
+
+    int width, height;
+    int rowWords, colWords;
+    std::vector<uint64_t> rows;
+    std::vector<uint64_t> cols;
+    std::vector<uint64_t> zeros;
+};
+
+struct OpenEntry {
+    uint32_t f;
+    uint32_t g;
+    int index;
+};
+
+// Lista aberta do A*: heap binário de mínimo por f. Não tem decrease-key;
+// quem usa insere de novo ao achar um custo menor e descarta as entradas
+// velhas ao retirá-las. O vetor mantém a capacidade entre buscas.
+class OpenList {
+public:
+    void clear() { heap.clear(); }
+    bool empty() const { return heap.empty(); }
+
+    void push(int index, uint32_t f, uint32_t g) {
+        OpenEntry entry = { f, g, index };
+        size_t i = heap.size();
+        heap.push_back(entry);
+        while (i > 0) {
+            size_t up = (i - 1) / 2;
+            if (!before(entry, heap[up])) break;
+            heap[i] = heap[up];
+            i = up;
+        }
+        heap[i] = entry;
+    }
+
+    OpenEntry pop() {
+        OpenEntry top = heap[0];
+        OpenEntry last = heap.back();
+        heap.pop_back();
+        size_t n = heap.size();
+        size_t i = 0;
+        while (n > 0) {
+            size_t child = 2 * i + 1;
+            if (child >= n) break;
+            if (child + 1 < n && before(heap[child + 1], heap[child])) child++;
+            if (!before(heap[child], last)) break;
+            heap[i] = heap[child];
+            i = child;
+        }
+        if (n > 0) heap[i] = last;
+        return top;
+    }
+
+private:
+    // menor f primeiro; no empate, maior g (mais perto do destino)
+    static bool before(const OpenEntry& a, const OpenEntry& b) {
+        return a.f < b.f || (a.f == b.f && a.g > b.g);
+    }
+
+    std::vector<OpenEntry> heap;
+};
+
+// Jump Point Search (A* com poda de vizinhos) em 8 direções sobre uma
+// WalkMask. As diagonais seguem a regra do teclado: basta o tile de destino
+// ser caminhável. Em vez de abrir todo vizinho, cada direção "salta" em linha
+// reta até um ponto de interesse (destino, ou tile com vizinho forçado por um
+// obstáculo); só esses pontos entram na lista aberta, e o caminho continua
+// ótimo. Os saltos retos varrem a WalkMask 64 tiles por vez. Os trechos entre
+// pontos de salto são retos ou diagonais, e são expandidos tile a tile no
+// resultado.
+//
+// O vetor de nós (carimbo, custo, pai) é alocado uma vez e reaproveitado.
+// Cada busca soma 2 a 'generation': um nó com carimbo igual à geração está
+// aberto, igual à geração + 1 está fechado, e qualquer outro valor é lixo de
+// uma busca anterior, então nada é limpo entre consultas.
+class PathFinder {
+public:
+    // custos inteiros, para o resultado não depender de arredondamento
+    static constexpr uint32_t STRAIGHT_COST = 10;
+    static constexpr uint32_t DIAGONAL_COST = 14;
+
+    PathFinder() : generation(0), lastExpanded(0) {}
+
+    // Caminho de (startCol, startRow) até (goalCol, goalRow), sem o tile de
+    // partida, como índices col + row * largura. Retorna false se o destino
+    // é inalcançável.
+    bool findPath(const WalkMask& mask, int startCol, int startRow, int goalCol, int goalRow, std::vector<int>& path) {
+        path.clear();
+        lastExpanded = 0;
+        const int width = mask.getWidth();
+        if (!mask.walkable(goalCol, goalRow) || startCol < 0 || startCol >= width || startRow < 0 || startRow >= mask.getHeight()) {
+            return false;
+        }
+        if (startCol == goalCol && startRow == goalRow) return true;
+
+        prepare(width * mask.getHeight());
+        const int start = startCol + startRow * width;
+        const int goal = goalCol + goalRow * width;
+
+        open.clear();
+        touch(start, 0, -1);
+        open.push(start, octile(startCol, startRow, goalCol, goalRow), 0);
+
+        const uint32_t closedStamp = generation + 1;
+        int dirs[8][2];
+        while (!open.empty()) {
+            OpenEntry top = open.pop();
+            Node& node = nodes[top.index];
+            if (node.stamp == closedStamp || top.g != node.g) continue; // entrada velha
+            node.stamp = closedStamp;
+            lastExpanded++;
+
+            if (top.index == goal) {
+                buildPath(start, goal, width, path);
+                return true;
+            }
+
+            const int col = top.index % width;
+            const int row = top.index / width;
+            int count = prunedDirections(mask, col, row, node.parent, width, dirs);
+            for (int d = 0; d < count; ++d) {
+                int jc, jr;
+                if (!jump(mask, col, row, dirs[d][0], dirs[d][1], goalCol, goalRow, jc, jr)) continue;
+                int next = jc + jr * width;
+                const Node& neighbor = nodes[next];
+                if (neighbor.stamp == closedStamp) continue;
+
+                uint32_t g = top.g + octile(col, row, jc, jr);
+                if (neighbor.stamp == generation && neighbor.g <= g) continue;
+                touch(next, g, top.index);
+                open.push(next, g + octile(jc, jr, goalCol, goalRow), g);
+            }
+        }
+        return false;
+    }
+
+    // pontos de salto expandidos na última busca
+    int getLastExpanded() const { return lastExpanded; }
+
+    // Distância octil: heurística admissível, e custo exato entre dois pontos
+    // de salto, que estão sempre na mesma reta ou diagonal.
+    static uint32_t octile(int col, int row, int goalCol, int goalRow) {
+        uint32_t dx = (uint32_t)std::abs(col - goalCol);
+        uint32_t dy = (uint32_t)std::abs(row - goalRow);
+        uint32_t diag = std::min(dx, dy);
+        return STRAIGHT_COST * (dx + dy) - (2 * STRAIGHT_COST - DIAGONAL_COST) * diag;
+    }
+
+private:
+    struct Node {
+        uint32_t stamp;
+        uint32_t g;
+        int parent;
+    };
+
+    static int sign(int v) { return (v > 0) - (v < 0); }
+
+    // Direções a seguir a partir de um nó: todas no início; depois, as
+    // naturais (que continuam o movimento) e as forçadas por um obstáculo
+    // ao lado, que não teriam caminho tão curto passando pelo pai.
+    static int prunedDirections(const WalkMask& mask, int col, int row, int parent, int width, int dirs[8][2]) {
+        int count = 0;
+        if (parent < 0) {
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    if (dx == 0 && dy == 0) continue;
+                    dirs[count][0] = dx;
+                    dirs[count][1] = dy;
+                    count++;
+                }
+            }
+            return count;
+        }
+
+        const int dx = sign(col - parent % width);
+        const int dy = sign(row - parent / width);
+        if (dx != 0 && dy != 0) {
+            addDirection(dirs, count, dx, 0);
+            addDirection(dirs, count, 0, dy);
+            addDirection(dirs, count, dx, dy);
+            if (!mask.walkable(col - dx, row)) addDirection(dirs, count, -dx, dy);
+            if (!mask.walkable(col, row - dy)) addDirection(dirs, count, dx, -dy);
+        } else if (dx != 0) {
+            addDirection(dirs, count, dx, 0);
+            if (!mask.walkable(col, row + 1)) addDirection(dirs, count, dx, 1);
+            if (!mask.walkable(col, row - 1)) addDirection(dirs, count, dx, -1);
+        } else {
+            addDirection(dirs, count, 0, dy);
+            if (!mask.walkable(col + 1, row)) addDirection(dirs, count, 1, dy);
+            if (!mask.walkable(col - 1, row)) addDirection(dirs, count, -1, dy);
+        }
+        return count;
+    }
+
+    static void addDirection(int dirs[8][2], int& count, int dx, int dy) {
+        dirs[count][0] = dx;
+        dirs[count][1] = dy;
+        count++;
+    }
+
+    // Anda na direção (dx, dy) até o destino, um tile com vizinho forçado ou,
+    // na diagonal, um tile de onde um salto reto acha algo. Retorna false ao
+    // bater em obstáculo ou na borda.
+    static bool jump(const WalkMask& mask, int col, int row, int dx, int dy, int goalCol, int goalRow, int& outCol, int& outRow) {
+        if (dy == 0) {
+            int p = scanLine(mask.rowLine(row), mask.rowLine(row - 1), mask.rowLine(row + 1), mask.getRowWords(),
+                             col, dx, goalRow == row ? goalCol : -1);
+            if (p < 0) return false;
+            outCol = p;
+            outRow = row;
+            return true;
+        }
+        if (dx == 0) {
+            int p = scanLine(mask.colLine(col), mask.colLine(col - 1), mask.colLine(col + 1), mask.getColWords(),
+                             row, dy, goalCol == col ? goalRow : -1);
+            if (p < 0) return false;
+            outCol = col;
+            outRow = p;
+            return true;
+        }
+
+        for (;;) {
+            col += dx;
+            row += dy;
+            if (!mask.walkable(col, row)) return false;
+            if (col == goalCol && row == goalRow) break;
+
+            if ((!mask.walkable(col - dx, row) && mask.walkable(col - dx, row + dy)) ||
+                (!mask.walkable(col, row - dy) && mask.walkable(col + dx, row - dy))) break;
+            int c, r;
+            if (jump(mask, col, row, dx, 0, goalCol, goalRow, c, r) ||
+                jump(mask, col, row, 0, dy, goalCol, goalRow, c, r)) break;
+        }
+        outCol = col;
+        outRow = row;
+        return true;
+    }
+
+    // Salto reto ao longo de uma linha de bits (uma linha do mapa, ou uma
+    // coluna no plano transposto), a partir de 'pos' no sentido 'dir'. 'side0'
+    // e 'side1' são as linhas vizinhas: um tile p tem vizinho forçado quando o
+    // vizinho lateral em p está bloqueado e o seguinte (p + dir) não. Retorna
+    // a posição do ponto de salto, 'goal' se ele vier antes, ou -1.
+    static int scanLine(const uint64_t* line, const uint64_t* side0, const uint64_t* side1, int words, int pos, int dir, int goal) {
+        if (dir > 0) {
+            int from = pos + 1;
+            for (int w = from >> 6; w < words; ++w) {
+                uint64_t next0 = (side0[w] >> 1) | (w + 1 < words ? side0[w + 1] << 63 : 0);
+                uint64_t next1 = (side1[w] >> 1) | (w + 1 < words ? side1[w + 1] << 63 : 0);
+                uint64_t stop = ~line[w] | (~side0[w] & next0) | (~side1[w] & next1);
+                if (w == (from >> 6)) stop &= ~0ull << (from & 63);
+                if (stop) {
+                    int p = (w << 6) + lowestBit(stop);
+                    if (goal > pos && goal <= p) return goal;
+                    return (line[w] >> (p & 63)) & 1 ? p : -1;
+                }
+            }
+            return goal > pos ? goal : -1;
+        }
+
+        int from = pos - 1;
+        for (int w = from >> 6; w >= 0 && from >= 0; --w) {
+            uint64_t next0 = (side0[w] << 1) | (w > 0 ? side0[w - 1] >> 63 : 0);
+            uint64_t next1 = (side1[w] << 1) | (w > 0 ? side1[w - 1] >> 63 : 0);
+            uint64_t stop = ~line[w] | (~side0[w] & next0) | (~side1[w] & next1);
+            if (w == (from >> 6) && (from & 63) != 63) stop &= (1ull << ((from & 63) + 1)) - 1;
+            if (stop) {
+                int p = (w << 6) + highestBit(stop);
+                if (goal >= 0 && goal < pos && goal >= p) return goal;
+                return (line[w] >> (p & 63)) & 1 ? p : -1;
+            }
+        }
+        return goal >= 0 && goal < pos ? goal : -1;
+    }
+
+    // Refaz o caminho pelos pais, preenchendo os tiles entre pontos de salto.
+    void buildPath(int start, int goal, int width, std::vector<int>& path) {
+        for (int i = goal; i != start; i = nodes[i].parent) {
+            int from = nodes[i].parent;
+            int col = i % width, row = i / width;
+            const int dx = sign(from % width - col);
+            const int dy = sign(from / width - row);
+            for (int j = i; j != from; j = col + row * width) {
+                path.push_back(j);
+                col += dx;
+                row += dy;
+            }
+        }
+        std::reverse(path.begin(), path.end());
+    }
+
+    void prepare(int cells) {
+        if ((int)nodes.size() < cells) {
+            Node empty = { 0, 0, -1 };
+            nodes.assign(cells, empty);
+            generation = 0;
+        }
+        generation += 2;
+        if (generation == 0) {
+            // a contagem deu a volta: zera os carimbos uma única vez
+            for (size_t i = 0; i < nodes.size(); ++i) nodes[i].stamp = 0;
+            generation = 2;
+        }
+    }
+
+    void touch(int index, uint32_t g, int from) {
+        Node& node = nodes[index];
+        node.stamp = generation;
+        node.g = g;
+        node.parent = from;
+    }
+
+    uint32_t generation;
+    int lastExpanded;
+    std::vector<Node> nodes;
+    OpenList open;
+};
+
+#endif /* PathFinder_h */
@@ -0,0 +1,146 @@
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "IsoProjection.h"
+
+// Teste do IsoProjection::pick contra a definição do losango.
+//
+// Para cada combinação de tamanho de tile (pares e ímpares), tamanho de tela
+// e origem (mapa centralizado e câmera em vários pontos, inclusive fora do
+// mapa), confere todos os pixels da tela: o tile do pick é o de menor
+// coluna, e depois menor linha, entre os losangos fechados que contêm o
+// centro do pixel, e pick retorna false exatamente quando esse tile está
+// fora do mapa. pickMany tem que concordar com pick em todos os pontos.
+// A conta de referência é feita em inteiros, com o centro do pixel e a
+// origem em quartos de pixel, então não depende do arredondamento do pick.
+
+struct TileSize { int width, height; };
+struct ScreenSize { int width, height; };
+
+// Origem em quartos de pixel; false se ela não cai em um quarto exato (o
+// pick só promete exatidão nesse caso).
+static bool originInQuarters(const IsoProjection& iso, long long& x4, long long& y4) {
+    const glm::vec2 origin = iso.origin();
+    const double x = (double)origin.x * 4.0, y = (double)origin.y * 4.0;
+    x4 = std::llround(x);
+    y4 = std::llround(y);
+    return x == (double)x4 && y == (double)y4;
+}
+
+// |a - (col - row)| + |b - (col + row - 1)| <= 1 com a = dx / (tw/2) e
+// b = dy / (th/2), multiplicado por 2 * tw * th para ficar em inteiros
+// (dx, dy em quartos de pixel).
+static bool diamondContains(long long dx4, long long dy4, long long tw, long long th, long long col, long long row) {
+    const long long da = dx4 * th - (col - row) * 2 * tw * th;
+    const long long db = dy4 * tw - (col + row - 1) * 2 * tw * th;
+    return std::llabs(da) + std::llabs(db) <= 2 * tw * th;
+}
+
+static int checkCase(const IsoProjection& iso, int width, int height, const char* name) {
+    const long long tw = (long long)iso.getTileWidth(), th = (long long)iso.getTileHeight();
+    long long originX4, originY4;
+    if (!originInQuarters(iso, originX4, originY4)) {
+        std::cerr << name << ": origem fora de quartos de pixel" << std::endl;
+        return 1;
+    }
+
+    std::vector<int> xs, ys;
+    xs.reserve((size_t)width * height);
+    ys.reserve((size_t)width * height);
+    std::vector<int> pickedCols, pickedRows;
+    pickedCols.reserve(xs.capacity());
+    pickedRows.reserve(xs.capacity());
+
+    int failures = 0;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const long long dx4 = 4LL * x + 2 - originX4;
+            const long long dy4 = 4LL * y + 2 - originY4;
+
+            // candidatos em volta da inversa em double; o losango que contém
+            // o ponto está sempre a no máximo um tile dela
+            const double u = ((double)dx4 / (2.0 * tw) + (double)dy4 / (2.0 * th)) / 2.0;
+            const double v = ((double)dy4 / (2.0 * th) - (double)dx4 / (2.0 * tw)) / 2.0;
+            const long long baseCol = (long long)std::ceil(u), baseRow = (long long)std::ceil(v);
+            long long expectedCol = 0, expectedRow = 0;
+            bool found = false;
+            for (long long c = baseCol - 1; c <= baseCol + 1; ++c) {
+                for (long long r = baseRow - 1; r <= baseRow + 1; ++r) {
+                    if (!diamondContains(dx4, dy4, tw, th, c, r)) continue;
+                    if (!found || c < expectedCol || (c == expectedCol && r < expectedRow)) {
+                        expectedCol = c;
+                        expectedRow = r;
+                    }
+                    found = true;
+                }
+            }
+
+            int col, row;
+            const bool inside = iso.pick(x, y, col, row);
+            const bool expectedInside = found && expectedCol >= 0 && expectedCol < iso.getMapCols() &&
+                                        expectedRow >= 0 && expectedRow < iso.getMapRows();
+            if (!found || col != expectedCol || row != expectedRow || inside != expectedInside) {
+                if (failures < 5) {
+                    std::cerr << name << ": pixel (" << x << ", " << y << ") escolheu (" << col << ", " << row
+                              << "), esperado (" << expectedCol << ", " << expectedRow << ")" << std::endl;
+                }
+                failures++;
+            }
+            xs.push_back(x);
+            ys.push_back(y);
+            pickedCols.push_back(inside ? col : -1);
+            pickedRows.push_back(inside ? row : -1);
+        }
+    }
+
+    std::vector<int> manyCols(xs.size()), manyRows(xs.size());
+    iso.pickMany(xs.data(), ys.data(), (int)xs.size(), manyCols.data(), manyRows.data());
+    for (size_t i = 0; i < xs.size(); ++i) {
+        if (manyCols[i] != pickedCols[i] || manyRows[i] != pickedRows[i]) {
+            if (failures < 5) {
+                std::cerr << name << ": pickMany discorda do pick no pixel (" << xs[i] << ", " << ys[i] << ")" << std::endl;
+            }
+            failures++;
+        }
+    }
+    return failures;
+}
+
+int main() {
+    const TileSize tiles[] = { {64, 32}, {128, 64}, {2, 1}, {1, 1}, {63, 31}, {33, 17}, {5, 3}, {48, 27} };
+    const ScreenSize screens[] = { {800, 600}, {321, 199}, {1, 1} };
+    const int mapSize = 40;
+    // câmera: -1 é o mapa inteiro centralizado; os outros são o tile focado
+    const int focus[][2] = { {-1, -1}, {0, 0}, {mapSize / 2, 7}, {mapSize - 1, mapSize - 1}, {-30, 55} };
+
+    int cases = 0, failedCases = 0;
+    for (const TileSize& tile : tiles) {
+        for (const ScreenSize& screen : screens) {
+            for (const auto& f : focus) {
+                const IsoProjection iso = f[0] < 0
+                    ? IsoProjection((float)tile.width, (float)tile.height, mapSize, mapSize - 3, (float)screen.width, (float)screen.height)
+                    : IsoProjection::centeredOn((float)tile.width, (float)tile.height, mapSize, mapSize - 3, f[0], f[1],
+                                                (float)screen.width, (float)screen.height);
+                const std::string name = "tile " + std::to_string(tile.width) + "x" + std::to_string(tile.height) +
+                                         ", tela " + std::to_string(screen.width) + "x" + std::to_string(screen.height) +
+                                         ", foco (" + std::to_string(f[0]) + ", " + std::to_string(f[1]) + ")";
+                const int failures = checkCase(iso, screen.width, screen.height, name.c_str());
+                cases++;
+                if (failures > 0) {
+                    std::cerr << name << ": " << failures << " falhas" << std::endl;
+                    failedCases++;
+                }
+            }
+        }
+    }
+
+    if (failedCases > 0) {
+        std::cerr << failedCases << " de " << cases << " casos falharam" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "pick confere com o losango em todos os pixels de " << cases << " casos" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,192 @@
+#ifndef SpatialHash_h
+#define SpatialHash_h
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+// Hash espacial uniforme das entidades por tile.
+//
+// A grade é dividida em células de 2^cellBits x 2^cellBits tiles, e cada célula
+// cai em um dos 2^bucketBits baldes pelo hash das suas coordenadas (células
+// distantes podem dividir um balde; as consultas filtram pela posição). Cada
+// entidade é um id pequeno e denso (o índice da entidade no EntityWorld) e
+// guarda em que balde e em que posição do balde está, então inserir, mover e
+// remover são O(1): mover dentro da mesma célula só troca a posição, e entre
+// células é uma remoção (troca com o último do balde) e uma inserção.
+class SpatialHash {
+public:
+    static constexpr uint32_t NONE = 0xFFFFFFFFu;
+
+    explicit SpatialHash(int cellBits = 2, int bucketBits = 16)
+        : cellBits(cellBits), cellSize(1 << cellBits), bucketMask((1u << bucketBits) - 1), buckets((size_t)1 << bucketBits), count(0) {}
+
+    void clear() {
+        for (size_t b = 0; b < buckets.size(); ++b) buckets[b].clear();
+        records.clear();
+        count = 0;
+    }
+
+    size_t size() const { return count; }
+    int getCellSize() const { return cellSize; }
+
+    bool contains(uint32_t id) const {
+        return id < records.size() && records[id].bucket != NONE;
+    }
+
+    void insert(uint32_t id, int col, int row) {
+        if (contains(id)) {
+            move(id, col, row);
+            return;
+        }
+        if (id >= records.size()) {
+            Record empty = { NONE, 0 };
+            records.resize(id + 1, empty);
+        }
+        place(id, col, row);
+        count++;
+    }
+
+    void move(uint32_t id, int col, int row) {
+        if (!contains(id)) return;
+        Record& record = records[id];
+        Entry& entry = buckets[record.bucket][record.slot];
+        if (cellOf(entry.col) == cellOf(col) && cellOf(entry.row) == cellOf(row)) {
+            entry.col = col;
+            entry.row = row;
+            return;
+        }
+        unlink(id);
+        place(id, col, row);
+    }
+
+    void erase(uint32_t id) {
+        if (!contains(id)) return;
+        unlink(id);
+        records[id].bucket = NONE;
+        count--;
+    }
+
+    // quantas entidades estão no tile
+    int countAt(int col, int row) const {
+        int total = 0;
+        const std::vector<Entry>& bucket = buckets[bucketOf(cellOf(col), cellOf(row))];
+        for (size_t i = 0; i < bucket.size(); ++i) {
+            total += (bucket[i].col == col && bucket[i].row == row) ? 1 : 0;
+        }
+        return total;
+    }
+
+    // fn(id, col, row) para cada entidade no retângulo [col0, col1] x [row0, row1]
+    template <class F>
+    void forEachInRect(int col0, int row0, int col1, int row1, F&& fn) const {
+        const int cx0 = cellOf(col0), cx1 = cellOf(col1);
+        const int cy0 = cellOf(row0), cy1 = cellOf(row1);
+        for (int cy = cy0; cy <= cy1; ++cy) {
+            for (int cx = cx0; cx <= cx1; ++cx) {
+                const std::vector<Entry>& bucket = buckets[bucketOf(cx, cy)];
+                for (size_t i = 0; i < bucket.size(); ++i) {
+                    const Entry& entry = bucket[i];
+                    // o balde pode ter outras células; cada entrada é contada
+                    // só na célula dela
+                    if (entry.col < col0 || entry.col > col1 || entry.row < row0 || entry.row > row1) continue;
+                    if (cellOf(entry.col) != cx || cellOf(entry.row) != cy) continue;
+                    fn(entry.id, entry.col, entry.row);
+                }
+            }
+        }
+    }
+
+    void queryRect(int col0, int row0, int col1, int row1, std::vector<uint32_t>& out) const {
+        out.clear();
+        forEachInRect(col0, row0, col1, row1, [&](uint32_t id, int, int) { out.push_back(id); });
+    }
+
+    // Entidade mais próxima (distância euclidiana em tiles) de (col, row), a
+    // no máximo maxRadius tiles em cada eixo, ignorando 'exclude'. As células
+    // são visitadas em anéis a partir da do ponto; a busca para quando nenhum
+    // anel seguinte pode ter alguém mais perto. NONE se não há ninguém.
+    uint32_t nearest(int col, int row, int maxRadius, uint32_t exclude = NONE) const {
+        const int qx = cellOf(col), qy = cellOf(row);
+        const int maxRing = maxRadius / cellSize + 1;
+        uint32_t best = NONE;
+        long long bestDistance = 0;
+        for (int ring = 0; ring <= maxRing; ++ring) {
+            // toda entidade do anel 'ring' está a pelo menos (ring - 1) * cellSize + 1 tiles
+            if (best != NONE && ring > 0) {
+                const long long bound = (long long)(ring - 1) * cellSize + 1;
+                if (bestDistance < bound * bound) break;
+            }
+            for (int cy = qy - ring; cy <= qy + ring; ++cy) {
+                // nas linhas do meio do anel só as duas colunas das pontas
+                const int step = (cy == qy - ring || cy == qy + ring) ? 1 : std::max(1, 2 * ring);
+                for (int cx = qx - ring; cx <= qx + ring; cx += step) {
+                    const std::vector<Entry>& bucket = buckets[bucketOf(cx, cy)];
+                    for (size_t i = 0; i < bucket.size(); ++i) {
+                        const Entry& entry = bucket[i];
+                        if (entry.id == exclude || cellOf(entry.col) != cx || cellOf(entry.row) != cy) continue;
+                        const int dx = entry.col - col, dy = entry.row - row;
+                        if (std::abs(dx) > maxRadius || std::abs(dy) > maxRadius) continue;
+                        const long long distance = (long long)dx * dx + (long long)dy * dy;
+                        if (best == NONE || distance < bestDistance || (distance == bestDistance && entry.id < best)) {
+                            best = entry.id;
+                            bestDistance = distance;
+                        }
+                    }
+                }
+            }
+        }
+        return best;
+    }
+
+private:
+    struct Entry {
+        uint32_t id;
+        int col;
+        int row;
+    };
+
+    struct Record {
+        uint32_t bucket;      // NONE: fora do hash
+        uint32_t slot;
+    };
+
+    // deslocamento aritmético: arredonda para baixo também nas coordenadas
+    // negativas das bordas dos retângulos
+    int cellOf(int v) const {
+        return v >> cellBits;
+    }
+
+    uint32_t bucketOf(int cx, int cy) const {
+        return ((uint32_t)cx * 73856093u ^ (uint32_t)cy * 19349663u) & bucketMask;
+    }
+
+    void place(uint32_t id, int col, int row) {
+        const uint32_t b = bucketOf(cellOf(col), cellOf(row));
+        Entry entry = { id, col, row };
+        records[id].bucket = b;
+        records[id].slot = (uint32_t)buckets[b].size();
+        buckets[b].push_back(entry);
+    }
+
+    // tira do balde trazendo a última entrada para o lugar
+    void unlink(uint32_t id) {
+        const Record record = records[id];
+        std::vector<Entry>& bucket = buckets[record.bucket];
+        if (record.slot + 1 != bucket.size()) {
+            bucket[record.slot] = bucket.back();
+            records[bucket[record.slot].id].slot = record.slot;
+        }
+        bucket.pop_back();
+    }
+
+    int cellBits;
+    int cellSize;
+    uint32_t bucketMask;
+    std::vector<std::vector<Entry>> buckets;
+    std::vector<Record> records;
+    size_t count;
+};
+
+#endif /* SpatialHash_h */
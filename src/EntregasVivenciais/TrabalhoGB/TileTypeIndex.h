@@ -0,0 +1,185 @@
+#ifndef TileTypeIndex_h
+#define TileTypeIndex_h
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "TileGrid.h"
+
+// Índice dos tiles do mapa por tipo.
+//
+// Para cada tipo guarda quantos tiles há e as posições deles (col + row *
+// largura), separadas por bloco de blockSize x blockSize tiles. Cada tile
+// sabe em que posição da lista do seu bloco está, então trocar o tipo de um
+// tile é tirar de uma lista (trocando com o último) e pôr em outra, O(1).
+// Assim contar, achar o mais próximo e listar os de um retângulo só visitam
+// os blocos envolvidos e os tiles daquele tipo, nunca o mapa inteiro.
+// Quem escreve no mapa avisa cada troca com set().
+class TileTypeIndex {
+public:
+    static constexpr int TYPE_COUNT = 256;
+
+    explicit TileTypeIndex(int blockSize = 32)
+        : blockSize(std::max(1, blockSize)), width(0), height(0), blocksX(0), blocksY(0), types(TYPE_COUNT) {}
+
+    // uma passada pelo mapa, no carregamento
+    void build(const TileGrid& grid) {
+        reset(grid.getWidth(), grid.getHeight());
+        for (int r = 0; r < height; ++r) {
+            const TileId* row = grid.rowData(r);
+            for (int c = 0; c < width; ++c) add(row[c], c, r);
+        }
+    }
+
+    // o tile (col, row) passou de 'before' para 'after'
+    void set(int col, int row, TileId before, TileId after) {
+        if (before == after) return;
+        remove(before, col, row);
+        add(after, col, row);
+    }
+
+    // todos os tiles passam a ser do tipo 'type'
+    void fill(TileId type) {
+        reset(width, height);
+        for (int r = 0; r < height; ++r) {
+            for (int c = 0; c < width; ++c) add(type, c, r);
+        }
+    }
+
+    int count(TileId type) const { return types[type].count; }
+
+    // o primeiro tile do tipo na ordem linha a linha do mapa
+    bool first(TileId type, int& col, int& row) const {
+        const TypeSet& set = types[type];
+        if (set.count == 0) return false;
+        int best = -1;
+        for (size_t b = 0; b < set.blocks.size(); ++b) {
+            for (size_t i = 0; i < set.blocks[b].size(); ++i) {
+                if (best < 0 || set.blocks[b][i] < best) best = set.blocks[b][i];
+            }
+        }
+        col = best % width;
+        row = best / width;
+        return true;
+    }
+
+    // Tile do tipo mais próximo (distância euclidiana) de (col, row). Os
+    // blocos são visitados em anéis a partir do bloco do ponto, e a busca
+    // para quando nenhum anel seguinte pode ter um tile mais perto.
+    bool nearest(TileId type, int col, int row, int& outCol, int& outRow) const {
+        const TypeSet& set = types[type];
+        if (set.count == 0 || set.blocks.empty()) return false;
+        const int bx = std::min(std::max(col, 0), width - 1) / blockSize;
+        const int by = std::min(std::max(row, 0), height - 1) / blockSize;
+        const int maxRing = std::max(std::max(bx, blocksX - 1 - bx), std::max(by, blocksY - 1 - by));
+        int best = -1;
+        long long bestDistance = 0;
+        for (int ring = 0; ring <= maxRing; ++ring) {
+            // todo tile do anel 'ring' está a pelo menos (ring - 1) * blockSize + 1 tiles
+            if (best >= 0 && ring > 0) {
+                const long long bound = (long long)(ring - 1) * blockSize + 1;
+                if (bestDistance < bound * bound) break;
+            }
+            for (int y = by - ring; y <= by + ring; ++y) {
+                if (y < 0 || y >= blocksY) continue;
+                const int step = (y == by - ring || y == by + ring) ? 1 : std::max(1, 2 * ring);
+                for (int x = bx - ring; x <= bx + ring; x += step) {
+                    if (x < 0 || x >= blocksX) continue;
+                    const std::vector<int>& tiles = set.blocks[x + y * blocksX];
+                    for (size_t i = 0; i < tiles.size(); ++i) {
+                        const int dx = tiles[i] % width - col, dy = tiles[i] / width - row;
+                        const long long distance = (long long)dx * dx + (long long)dy * dy;
+                        if (best < 0 || distance < bestDistance || (distance == bestDistance && tiles[i] < best)) {
+                            best = tiles[i];
+                            bestDistance = distance;
+                        }
+                    }
+                }
+            }
+        }
+        if (best < 0) return false;
+        outCol = best % width;
+        outRow = best / width;
+        return true;
+    }
+
+    // fn(col, row) para cada tile do tipo no retângulo [col0, col1] x [row0, row1]
+    template <class F>
+    void forEachInRect(TileId type, int col0, int row0, int col1, int row1, F&& fn) const {
+        const TypeSet& set = types[type];
+        if (set.count == 0 || set.blocks.empty()) return;
+        col0 = std::max(col0, 0);
+        row0 = std::max(row0, 0);
+        col1 = std::min(col1, width - 1);
+        row1 = std::min(row1, height - 1);
+        if (col0 > col1 || row0 > row1) return;
+        for (int y = row0 / blockSize; y <= row1 / blockSize; ++y) {
+            for (int x = col0 / blockSize; x <= col1 / blockSize; ++x) {
+                const std::vector<int>& tiles = set.blocks[x + y * blocksX];
+                for (size_t i = 0; i < tiles.size(); ++i) {
+                    const int c = tiles[i] % width, r = tiles[i] / width;
+                    if (c >= col0 && c <= col1 && r >= row0 && r <= row1) fn(c, r);
+                }
+            }
+        }
+    }
+
+    int countInRect(TileId type, int col0, int row0, int col1, int row1) const {
+        int total = 0;
+        forEachInRect(type, col0, row0, col1, row1, [&](int, int) { total++; });
+        return total;
+    }
+
+private:
+    // blocks só é alocado no primeiro tile do tipo
+    struct TypeSet {
+        int count = 0;
+        std::vector<std::vector<int>> blocks;
+    };
+
+    void reset(int w, int h) {
+        width = w;
+        height = h;
+        blocksX = (w + blockSize - 1) / blockSize;
+        blocksY = (h + blockSize - 1) / blockSize;
+        for (size_t t = 0; t < types.size(); ++t) {
+            types[t].count = 0;
+            types[t].blocks.clear();
+        }
+        slots.assign((size_t)w * h, 0);
+    }
+
+    int blockOf(int col, int row) const { return col / blockSize + (row / blockSize) * blocksX; }
+
+    void add(TileId type, int col, int row) {
+        TypeSet& set = types[type];
+        if (set.blocks.empty()) set.blocks.resize((size_t)blocksX * blocksY);
+        std::vector<int>& tiles = set.blocks[blockOf(col, row)];
+        const int index = col + row * width;
+        slots[index] = (uint32_t)tiles.size();
+        tiles.push_back(index);
+        set.count++;
+    }
+
+    void remove(TileId type, int col, int row) {
+        TypeSet& set = types[type];
+        std::vector<int>& tiles = set.blocks[blockOf(col, row)];
+        const uint32_t slot = slots[col + row * width];
+        if (slot + 1 != tiles.size()) {
+            tiles[slot] = tiles.back();
+            slots[tiles[slot]] = slot;
+        }
+        tiles.pop_back();
+        set.count--;
+    }
+
+    int blockSize;
+    int width, height;
+    int blocksX, blocksY;
+    std::vector<TypeSet> types;
+    std::vector<uint32_t> slots;      // posição de cada tile na lista do seu bloco
+};
+
+#endif /* TileTypeIndex_h */
@@ -0,0 +1,190 @@
+#ifndef WorkerPool_h
+#define WorkerPool_h
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads fixas para laços paralelos curtos. parallelFor distribui os índices
+// dinamicamente (cada thread pega o próximo livre) e a thread que chamou
+// também trabalha; a chamada só retorna quando todos os índices terminaram.
+// parallelForStealing reparte os índices em faixas, uma por thread, com roubo
+// de trabalho entre elas. As threads ficam dormindo entre uma chamada e outra.
+// Duas threads podem usar o mesmo pool (a sessão e o cálculo do campo de
+// fluxo em segundo plano): as chamadas se revezam, uma inteira de cada vez.
+class WorkerPool {
+public:
+    // threadCount conta a thread que chama; 0 usa todos os núcleos
+    explicit WorkerPool(int threadCount = 0) : job(nullptr), jobCount(0), nextIndex(0), stealing(false), steals(0), busy(0), generation(0), stopping(false) {
+        if (threadCount <= 0) threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+        ranges.reset(new Range[threadCount]);
+        for (int i = 1; i < threadCount; ++i) {
+            workers.emplace_back(&WorkerPool::workerLoop, this, i);
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    int getThreadCount() const { return (int)workers.size() + 1; }
+
+    // fn(índice, thread), com thread em [0, getThreadCount()) para quem
+    // precisa de memória de trabalho própria por thread
+    void parallelFor(int count, const std::function<void(int, int)>& fn) {
+        if (count <= 0) return;
+        if (workers.empty() || count == 1) {
+            for (int i = 0; i < count; ++i) fn(i, 0);
+            return;
+        }
+        std::lock_guard<std::mutex> turn(callerMutex);
+        run(fn, count, false);
+    }
+
+    // Como parallelFor, mas a thread t começa com a faixa contígua
+    // [count * t / n, count * (t + 1) / n) e só quando ela acaba rouba a metade
+    // de cima da faixa de outra thread. Enquanto ninguém precisa roubar, chamadas
+    // seguidas com o mesmo count dão os mesmos índices à mesma thread, e os
+    // dados de cada índice continuam no cache daquele núcleo.
+    void parallelForStealing(int count, const std::function<void(int, int)>& fn) {
+        if (count <= 0) return;
+        if (workers.empty() || count == 1) {
+            for (int i = 0; i < count; ++i) fn(i, 0);
+            return;
+        }
+        std::lock_guard<std::mutex> turn(callerMutex);
+        const int threads = getThreadCount();
+        for (int t = 0; t < threads; ++t) {
+            ranges[t].begin = (int)((long long)count * t / threads);
+            ranges[t].end = (int)((long long)count * (t + 1) / threads);
+        }
+        steals = 0;
+        run(fn, count, true);
+    }
+
+    // faixas roubadas na última chamada de parallelForStealing
+    int getLastSteals() const { return steals; }
+
+private:
+    // faixa [begin, end) ainda não executada de uma thread; a dona consome do
+    // começo e quem rouba leva o fim
+    struct alignas(64) Range {
+        std::mutex mutex;
+        int begin = 0;
+        int end = 0;
+    };
+
+    void run(const std::function<void(int, int)>& fn, int count, bool steal) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &fn;
+            jobCount = count;
+            nextIndex = 0;
+            stealing = steal;
+            busy = (int)workers.size();
+            generation++;
+        }
+        wake.notify_all();
+        runJob(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return busy == 0; });
+        job = nullptr;
+    }
+
+    void runJob(int worker) {
+        if (stealing) {
+            int i;
+            while (popOwn(worker, i) || stealFrom(worker, i)) (*job)(i, worker);
+            return;
+        }
+        for (;;) {
+            int i = nextIndex.fetch_add(1);
+            if (i >= jobCount) return;
+            (*job)(i, worker);
+        }
+    }
+
+    bool popOwn(int worker, int& index) {
+        Range& own = ranges[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.begin >= own.end) return false;
+        index = own.begin++;
+        return true;
+    }
+
+    // Procura, a partir da thread seguinte, uma faixa não vazia e leva a metade
+    // de cima dela (arredondada para cima). Uma faixa em trânsito entre as duas
+    // travas não some: quem roubou a executa.
+    bool stealFrom(int worker, int& index) {
+        const int threads = getThreadCount();
+        for (int k = 1; k < threads; ++k) {
+            Range& victim = ranges[(worker + k) % threads];
+            int begin, end;
+            {
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                const int remaining = victim.end - victim.begin;
+                if (remaining <= 0) continue;
+                end = victim.end;
+                begin = end - (remaining + 1) / 2;
+                victim.end = begin;
+            }
+            {
+                Range& own = ranges[worker];
+                std::lock_guard<std::mutex> lock(own.mutex);
+                own.begin = begin + 1;
+                own.end = end;
+            }
+            steals++;
+            index = begin;
+            return true;
+        }
+        return false;
+    }
+
+    void workerLoop(int worker) {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+            runJob(worker);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busy == 0) done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex callerMutex;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(int, int)>* job;
+    int jobCount;
+    std::atomic<int> nextIndex;
+    std::unique_ptr<Range[]> ranges;
+    bool stealing;
+    std::atomic<int> steals;
+    int busy;
+    uint64_t generation;
+    bool stopping;
+};
+
+#endif /* WorkerPool_h */
@@ -13,6 +13,7 @@
 
 #include <gl_utils.h>
 #include <stb_image.h>
+#include <TextureUpload.h>
 
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
@@ -37,6 +38,7 @@ int cursor_col = 0;
 const int CURSOR_TILE_ID = 6;
 
 unsigned int texture;
+AsyncTextureLoader textures;
 
 const char* vertexShaderSource = "#version 330 core\n"
     "layout (location = 0) in vec3 aPos;\n"
@@ -123,6 +125,7 @@ int main() {
     
     while (!glfwWindowShouldClose(window)) {
         processInput(window);
+        textures.pump();
 
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -138,6 +141,7 @@ int main() {
         glfwPollEvents();
     }
 
+    textures.stop();
     glDeleteProgram(shaderProgram);
     glfwTerminate();
     return 0;
@@ -216,35 +220,16 @@ void createShaders() {
     glDeleteShader(fragmentShader);
 }
 
+// O tileset é decodificado em outra thread (AsyncTextureLoader) e enviado no
+// textures.pump() do loop; até lá o mapa fica transparente. Uma falha na
+// leitura aparece no log do AssetLoader.
 void loadTexture(const char* path) {
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    static const unsigned char placeholder[4] = { 0, 0, 0, 0 };
+    texture = textures.request(path, placeholder);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    int width, height, nrChannels;
-    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
-    if (data) {
-        GLenum format;
-        if (nrChannels == 1)
-            format = GL_RED;
-        else if (nrChannels == 3)
-            format = GL_RGB;
-        else if (nrChannels == 4)
-            format = GL_RGBA;
-
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-        
-        std::cout << "Textura carregada com sucesso: " << path << std::endl;
-        std::cout << "Dimensoes: " << width << "x" << height << ", Canais: " << nrChannels << std::endl;
-    } else {
-        std::cout << "Falha ao carregar textura: " << path << std::endl;
-        std::cout << "Erro STB_Image: " << stbi_failure_reason() << std::endl;
-    }
-    stbi_image_free(data);
 }
 
 unsigned int VAO, VBO;
@@ -8,6 +8,8 @@
 #include <sstream>
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+#include "ShaderProgram.h"
+#include "TextureUpload.h"
 
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
@@ -35,27 +37,18 @@ glm::vec2 processInput(GLFWwindow* window, float deltaTime) {
     return deltaMovement;
 }
 
-GLuint loadTexture(const char* path) {
-    GLuint textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrChannels;
+// A imagem é decodificada em outra thread e chega no textures.pump() do
+// loop; até lá a camada fica transparente. A inversão vertical do stb vale
+// para as threads do AssetLoader, então é ligada antes do primeiro pedido.
+GLuint loadTexture(AsyncTextureLoader& textures, const char* path) {
+    static const unsigned char placeholder[4] = { 0, 0, 0, 0 };
     stbi_set_flip_vertically_on_load(true);
-    unsigned char* data = stbi_load(path, &width, &height, &nrChannels, 0);
-    if (data) {
-        GLenum format = (nrChannels == 4) ? GL_RGBA : GL_RGB;
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    } else {
-        std::cout << "Failed to load texture: " << path << std::endl;
-    }
-    stbi_image_free(data);
+    GLuint textureID = textures.request(path, placeholder);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     return textureID;
 }
 
@@ -141,17 +134,16 @@ public:
         }
     }
 
-    void draw(GLuint shaderProgram) {
+    // modelLoc vem de ShaderProgram::location, resolvido uma vez fora do laço
+    void draw(GLint modelLoc) {
         glm::mat4 model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(position, 0.0f));
         model = glm::scale(model, glm::vec3(scale, 1.0f));
 
-        GLuint modelLoc = glGetUniformLocation(shaderProgram, "model");
         glUniformMatrix4fv(modelLoc, 1, GL_FALSE, &model[0][0]);
 
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, textureID);
-        glUniform1i(glGetUniformLocation(shaderProgram, "ourTexture"), 0);
 
         glBindVertexArray(VAO);
         glDrawArrays(GL_TRIANGLES, 0, 6);
@@ -231,20 +223,24 @@ int main() {
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    GLuint shaderProgram = createShaderProgram(
+    ShaderProgram shader;
+    shader.adopt(createShaderProgram(
         "../src/EntregasVivenciais/vivencialm4/vertex_shader.glsl",
         "../src/EntregasVivenciais/vivencialm4/fragment_shader.glsl"
-    );
+    ));
+    GLint modelLoc = shader.location("model");
 
     glm::mat4 projection = glm::ortho(0.0f, (float)SCR_WIDTH, 0.0f, (float)SCR_HEIGHT, -1.0f, 1.0f);
-    glUseProgram(shaderProgram);
-    GLuint projectionLoc = glGetUniformLocation(shaderProgram, "projection");
-    glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, &projection[0][0]);
-
-    GLuint textureLayerFar = loadTexture("../src/EntregasVivenciais/vivencialm4/game_background_1.png");
-    GLuint textureLayerMid = loadTexture("../src/EntregasVivenciais/vivencialm4/game_background_4.png");
-    GLuint textureLayerClose = loadTexture("../src/EntregasVivenciais/vivencialm4/game_background_3.png");
-    GLuint characterTexture = loadTexture("../src/EntregasVivenciais/vivencialm4/character.png");
+    FrameUniformBuffer frameUniforms;
+    frameUniforms.update(projection, (float)SCR_WIDTH, (float)SCR_HEIGHT, 0.0f);
+    shader.use();
+    ShaderProgram::set(shader.location("ourTexture"), 0);
+
+    AsyncTextureLoader textures;
+    GLuint textureLayerFar = loadTexture(textures, "../src/EntregasVivenciais/vivencialm4/game_background_1.png");
+    GLuint textureLayerMid = loadTexture(textures, "../src/EntregasVivenciais/vivencialm4/game_background_4.png");
+    GLuint textureLayerClose = loadTexture(textures, "../src/EntregasVivenciais/vivencialm4/game_background_3.png");
+    GLuint characterTexture = loadTexture(textures, "../src/EntregasVivenciais/vivencialm4/character.png");
     Layer layerFar(textureLayerFar, glm::vec2(0, 0), glm::vec2(SCR_WIDTH, SCR_HEIGHT), 0.1f, true);
     Layer layerMid(textureLayerMid, glm::vec2(0, 0), glm::vec2(SCR_WIDTH, SCR_HEIGHT), 0.4f, true);
     Layer layerClose(textureLayerClose, glm::vec2(0, 0), glm::vec2(SCR_WIDTH, SCR_HEIGHT), 0.8f, true);
@@ -258,32 +254,36 @@ int main() {
         float deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
+        textures.pump();
         glm::vec2 playerDelta = processInput(window, deltaTime);
 
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        glUseProgram(shaderProgram);
+        shader.use();
 
         layerFar.update(-playerDelta.x, -playerDelta.y);
         layerFar.wrapAround(SCR_WIDTH);
-        layerFar.draw(shaderProgram);
+        layerFar.draw(modelLoc);
 
         layerMid.update(-playerDelta.x, -playerDelta.y);
         layerMid.wrapAround(SCR_WIDTH);
-        layerMid.draw(shaderProgram);
+        layerMid.draw(modelLoc);
 
         layerClose.update(-playerDelta.x, -playerDelta.y);
         layerClose.wrapAround(SCR_WIDTH);
-        layerClose.draw(shaderProgram);
+        layerClose.draw(modelLoc);
 
         character.position += playerDelta;
-        character.draw(shaderProgram);
+        character.draw(modelLoc);
 
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
+    textures.stop();
+    shader.destroy();
+    frameUniforms.destroy();
     glfwTerminate();
     return 0;
 }
\ No newline at end of file
@@ -5,7 +5,12 @@ layout (location = 1) in vec2 aTexCoord;
 out vec2 TexCoord;
 
 uniform mat4 model;
-uniform mat4 projection;
+
+layout (std140) uniform Frame {
+    mat4 projection;
+    vec2 viewportSize;
+    float time;
+};
 
 void main() {
     gl_Position = projection * model * vec4(aPos, 0.0, 1.0);
@@ -17,6 +17,7 @@
 #include "DiamondView.h"
 #include "SlideView.h"
 #include "ltMath.h"
+#include "ShaderProgram.h"
 #include <fstream>
 
 
@@ -298,6 +299,18 @@ int main()
 		return false;
 	}
 
+	// localizações resolvidas uma vez, fora do laço de tiles
+	ShaderProgram program;
+	program.adopt(shader_programme, false);
+	GLint offsetxLoc = program.location("offsetx");
+	GLint offsetyLoc = program.location("offsety");
+	GLint txLoc = program.location("tx");
+	GLint tyLoc = program.location("ty");
+	GLint layerZLoc = program.location("layer_z");
+	GLint weightLoc = program.location("weight");
+	program.use();
+	glUniform1i(program.location("sprite"), 0);
+
 	float previous = glfwGetTime();
     
     
@@ -337,17 +350,16 @@ int main()
                                 
                 tview->computeDrawPosition(c, r, tw, th, x, y);
                 
-                glUniform1f(glGetUniformLocation(shader_programme, "offsetx"), u * tileW);
-                glUniform1f(glGetUniformLocation(shader_programme, "offsety"), v * tileH);
-                glUniform1f(glGetUniformLocation(shader_programme, "tx"), x);
-                glUniform1f(glGetUniformLocation(shader_programme, "ty"), y + 1.0);
-                glUniform1f(glGetUniformLocation(shader_programme, "layer_z"), tmap->getZ());                
-                glUniform1f(glGetUniformLocation(shader_programme, "weight"), (c == cx) && (r == cy) ? 0.5 : 0.0);                
+                glUniform1f(offsetxLoc, u * tileW);
+                glUniform1f(offsetyLoc, v * tileH);
+                glUniform1f(txLoc, x);
+                glUniform1f(tyLoc, y + 1.0);
+                glUniform1f(layerZLoc, tmap->getZ());                
+                glUniform1f(weightLoc, (c == cx) && (r == cy) ? 0.5 : 0.0);                
                 
                 // bind Texture
                 // glActiveTexture(GL_TEXTURE0);
                 glBindTexture(GL_TEXTURE_2D, tmap->getTileSet());
-                glUniform1i(glGetUniformLocation(shader_programme, "sprite"), 0);
                 glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
             }
             